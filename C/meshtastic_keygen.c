@@ -40,6 +40,13 @@
 #include <errno.h>
 #include <stdint.h>
 #include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netdb.h>
+#include <poll.h>
 #if defined(__x86_64__) || defined(__i386__)
 #include <cpuid.h>
 #include <immintrin.h>
@@ -78,6 +85,13 @@ void randombytes(unsigned char *out, unsigned long long outlen) {
 
 // Runtime-configurable settings
 static int g_num_threads = DEFAULT_NUM_THREADS;
+// --ignore-case: letters leave the exact masks (like '?') and are listed here instead; the key char
+// at pos[k] must be upper[k] or upper[k] + 26, the same letter in lower case
+struct case_fold {
+	unsigned char n;
+	unsigned char pos[BASE64_LEN];
+	unsigned char upper[BASE64_LEN];
+};
 // Multiple search patterns support
 struct search_pattern {
 	char *prefix;
@@ -91,10 +105,50 @@ struct search_pattern {
 	unsigned char pre_idx[4];   // indices 0..63 for first chars
 	unsigned char suf_mask_len; // 0..3 (we ignore the trailing '=')
 	unsigned char suf_idx[3];   // indices for last 1..3 chars before '='
+	unsigned char pre_fold;     // --ignore-case: bit k set when pre_idx[k] is a letter (upper-case index)
+	unsigned char suf_fold;     // likewise for suf_idx[k]
+	// Exact match on raw bytes: the Base64 char at string position p is bits 6p..6p+5 of the key read
+	// as one big-endian 256-bit number, so each side is (pub & mask) == value over four 64-bit words
+	uint64_t pre_bmask[4], pre_bval[4];
+	uint64_t suf_bmask[4], suf_bval[4];
+	unsigned char pre_bits;     // 1 when the prefix side can match (set by pattern_bits)
+	unsigned char suf_bits;     // likewise for the suffix side
+	struct case_fold pre_cf, suf_cf; // absolute char positions
+	// --contains: matches at any position of the 43 data chars. The chars sit left-aligned in one
+	// 64-bit window that is slid over the key in 6-bit steps ('?' leaves its bits out of the mask)
+	char *infix;
+	size_t infix_len;           // 1..INFIX_MAX_LEN, 0 for prefix/suffix patterns
+	uint64_t inf_mask, inf_val;
+	struct case_fold inf_cf;    // positions relative to the infix start
+	// --top scoring: the first / last SCORE_MAX_CHARS chars of each side as 6-bit groups, laid out
+	// like the key words they are compared with (see pattern_score_bits); 0 length = side unused
+	uint64_t sc_pre_val, sc_pre_mask;
+	uint64_t sc_suf_val, sc_suf_mask;
+	unsigned char sc_pre_len, sc_suf_len;
+	int job;                    // --serve: slot of the job that owns this pattern
+	unsigned job_id;            // ... and its id (a retired set may name a slot since reused)
 };
+#define INFIX_MAX_LEN 10        // 60 bits: one 64-bit window per offset
+#define SCORE_MAX_CHARS 10      // --top scores count up to this many chars per side
 static struct search_pattern *g_patterns = NULL;
 static size_t g_patterns_count = 0;
 static size_t g_patterns_cap = 0;
+static size_t g_infix_count = 0;     // patterns with infix_len > 0
+static int g_patterns_cpu_only = 0;  // infix, '?' or --ignore-case present; the OpenCL matcher has none
+static int g_pattern_job = 0;        // --serve: owner recorded by add_pattern / add_infix_pattern
+static unsigned g_pattern_job_id = 0;
+static int g_ignore_case = 0;        // --ignore-case: letters match in either case
+static int g_top_k = 0;              // --top K: keep the K best-scoring keys (0 = off)
+static int g_top_stop = 0;           // --top-stop N: a key scoring >= N counts as FOUND (0 = off)
+static int g_seeded = 0;             // --seed S: deterministic per-thread secret streams
+static unsigned long long g_seed = 0;
+static unsigned char g_seed_key[32]; // ChaCha20 key of the seeded streams: built from S, or random
+static int g_seed_random = 0;        // g_seed_key is 256 bits from the OS RNG (no S to print)
+static const char *g_checkpoint_path = NULL; // --checkpoint FILE / --resume FILE: periodic state file
+static unsigned g_stream_base = 0;   // --worker: first stream (thread) id of this process's shard
+static int g_worker_fd = -1;         // --worker: connection to the coordinator
+static int g_json = 0;               // --json: FOUND records as JSON lines on stdout
+static int g_serve = 0;              // --serve: daemon; patterns come from client jobs
 static int g_affinity = 0; // pin worker threads to CPUs
 static int g_quiet = 0;    // disable periodic reporting
 static int g_better = 0;   // add visually better variants for patterns
@@ -108,11 +162,68 @@ static int g_use_internal = 0; // use internal CPU ladder for pubkey derivation
 static int g_pin_pcores = 0;   // prefer pinning threads to P-cores on hybrid CPUs
 static int g_cpu_batch = 1;    // optional: batch size for internal ladder with batch inversion
 static int g_avx2_multi_lanes = 0; // experimental: 2 or 4 lanes for CPU internal ladder batching
+static int g_incremental = 0;      // walk k, k+8, k+16, ... from one random start per thread (internal CPU math)
 // Global state for coordination and reporting
-static _Atomic int g_stop = 0;
-static _Atomic unsigned long long g_key_count = 0;
+// The stop flag has a cache line to itself: every worker polls it once per batch and it is written once
+static struct { _Alignas(64) _Atomic int flag; } g_stop;
+static _Atomic unsigned long long g_key_count = 0; // keys counted outside the CPU workers (GPU loop, --coordinator)
 static _Atomic unsigned long long g_found_count = 0;
 static unsigned long long g_found_target = 1ULL;
+// --- Stage profiling (make PROFILE=1, i.e. -DME_KEYGEN_PROFILE) ---
+// A worker stamps the time-stamp counter (CLOCK_MONOTONIC off x86) at each stage boundary of a
+// batch and charges the time since the previous stamp to the stage just finished, so the stages
+// partition the loop: rng (ChaCha20 refill and clamping, or --derive input), ladder (scalar
+// multiples, walk steps, or the whole OpenSSL call), invert (the shared batch inversion), finish
+// (X * Zinv and tobytes), match (prefilters and exact checks), sink (secret, scoring, output) and
+// other (counters, pattern-set checks). Seven stamps per batch of ladders stay well under 1%.
+// Sums are thread-local and published to the worker's g_stats slot with its key count; the reporter
+// prints the split per interval and exit prints it for the run. Without the flag the macros are empty.
+#ifdef ME_KEYGEN_PROFILE
+enum { PROF_RNG, PROF_LADDER, PROF_INVERT, PROF_FINISH, PROF_MATCH, PROF_SINK, PROF_OTHER, PROF_NSTAGES };
+static const char *const g_prof_names[PROF_NSTAGES] = {"rng", "ladder", "invert", "finish", "match", "sink", "other"};
+struct prof_acc {
+	uint64_t last;
+	uint64_t t[PROF_NSTAGES];
+};
+static _Thread_local struct prof_acc tl_prof;
+#if defined(__x86_64__) || defined(__i386__)
+#define PROF_UNIT "cycles"
+static inline uint64_t prof_now(void) { return __rdtsc(); }
+#else
+#define PROF_UNIT "ns"
+static inline uint64_t prof_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+#endif
+#define PROF_MARK() (tl_prof.last = prof_now())
+#define PROF_LAP(st) do { uint64_t prof_t_ = prof_now(); tl_prof.t[(st)] += prof_t_ - tl_prof.last; tl_prof.last = prof_t_; } while (0)
+#else
+#define PROF_MARK() ((void)0)
+#define PROF_LAP(st) ((void)0)
+#endif
+
+// Per-worker counters, one cache line each. The owner stores its running total after every batch
+// (a plain store, no read-modify-write) and readers sum the slots, so no written line is shared.
+struct keygen_stats {
+	_Alignas(64) _Atomic unsigned long long keys;
+	_Atomic int cpu;            // CPU the worker last ran on (-1 before its first batch)
+#ifdef ME_KEYGEN_PROFILE
+	_Atomic unsigned long long prof[PROF_NSTAGES]; // time per stage, in PROF_UNIT
+#endif
+};
+static struct keygen_stats *g_stats = NULL; // one per worker thread
+static double g_report_sec = 5.0;  // --report-interval
+static int g_report_detail = 0;    // --report-detail: every thread's and CPU's rate
+
+// Keys checked so far: the worker slots plus g_key_count
+static unsigned long long keys_total(void) {
+	unsigned long long n = atomic_load_explicit(&g_key_count, memory_order_relaxed);
+	if (g_stats)
+		for (int i = 0; i < g_num_threads; ++i) n += atomic_load_explicit(&g_stats[i].keys, memory_order_relaxed);
+	return n;
+}
 
 // Small helper: format an unsigned long long into a compact human-readable string
 static void human_readable_ull(unsigned long long v, char *out, size_t outlen){
@@ -158,22 +269,37 @@ ME_DIAG_POP
 static int g_has_bmi2 = 0;
 static int g_has_adx = 0;
 static int g_has_avx2 = 0;
+static int g_has_avx512f = 0;
 static int g_has_avx512ifma = 0;
-static const char *g_fe_backend_name = "baseline";
+static int g_use_fe51 = 0; // internal CPU paths use the native 5x51 ladder (fe51_*) instead of fe + g_fe_mul/g_fe_sq
+static int g_use_ifma8 = 0; // internal CPU batch path runs the 8-lane AVX-512 IFMA ladder (x25519_base_batch_ifma)
 
 static void cpu_detect_features(void) {
 #if defined(__x86_64__) || defined(__i386__)
 	unsigned int eax=0, ebx=0, ecx=0, edx=0;
 	unsigned int max_leaf = __get_cpuid_max(0, NULL);
+	// OS support for the wide register state (XCR0): YMM needs bits 1-2, opmask/ZMM also bits 5-7
+	int os_ymm = 0, os_zmm = 0;
+	if (max_leaf >= 1) {
+		__get_cpuid(1, &eax, &ebx, &ecx, &edx);
+		if ((ecx >> 27) & 1U) { // OSXSAVE
+			unsigned int xcr0_lo = 0, xcr0_hi = 0;
+			__asm__ volatile("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+			(void)xcr0_hi;
+			os_ymm = (xcr0_lo & 0x6U) == 0x6U;
+			os_zmm = os_ymm && (xcr0_lo & 0xE0U) == 0xE0U;
+		}
+	}
 	if (max_leaf >= 7) {
 		// Leaf 7, subleaf 0
 		__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx);
 		// Bits from CPUID.(EAX=07H, ECX=0):EBX
-		// AVX2 = bit 5, BMI2 = bit 8, ADX = bit 19, AVX-512 IFMA = bit 21 (if supported)
-		g_has_avx2 = (ebx >> 5) & 1U;
+		// AVX2 = bit 5, BMI2 = bit 8, AVX-512F = bit 16, ADX = bit 19, AVX-512 IFMA = bit 21 (if supported)
+		g_has_avx2 = ((ebx >> 5) & 1U) && os_ymm;
 		g_has_bmi2 = (ebx >> 8) & 1U;
 		g_has_adx  = (ebx >> 19) & 1U;
-		g_has_avx512ifma = (ebx >> 21) & 1U; // presence only; OS XSAVE checks omitted for now
+		g_has_avx512f = ((ebx >> 16) & 1U) && os_zmm;
+		g_has_avx512ifma = ((ebx >> 21) & 1U) && os_zmm;
 	}
 #else
 	// Non-x86: leave all zeros
@@ -624,7 +750,7 @@ static void fem_avx2(fe *h, const fe *f, const fe *g) {
 }
 ME_DIAG_POP
 static void fesq_avx2(fe *h, const fe *f) { fe_sq_5x51_core(h, f); }
-// Experimental SoA for 4-lane FE (placeholder for future AVX2 vectorization)
+// 4-lane SoA field element: limb[i][lane] in ref10 10x(26/25) radix (see fe4 / ladder4_avx2_get_x2z2)
 #if defined(__x86_64__) || defined(__i386__)
 typedef struct {
 	int limb[10][4];
@@ -635,8 +761,25 @@ typedef struct {
 // In FE test mode, cross-check fem via BN to ensure correctness, then map back to limbs
 // fem_ref declared later after helpers
 static inline void fea24(fe *h,const fe *f){
-	// Use a24 = (A-2)/4 = 121665 per RFC 7748 with z2 = E*(AA + a24*E)
-	fe a24c; fe0(&a24c); a24c.v[0] = 121665; fem(h, f, &a24c);
+	// Use a24 = (A-2)/4 = 121665 per RFC 7748 with z2 = E*(AA + a24*E); a 17-bit constant, so
+	// scale each limb and run one ref10 carry pass instead of a full fem
+	long long h0 = (long long)f->v[0] * 121665, h1 = (long long)f->v[1] * 121665;
+	long long h2 = (long long)f->v[2] * 121665, h3 = (long long)f->v[3] * 121665;
+	long long h4 = (long long)f->v[4] * 121665, h5 = (long long)f->v[5] * 121665;
+	long long h6 = (long long)f->v[6] * 121665, h7 = (long long)f->v[7] * 121665;
+	long long h8 = (long long)f->v[8] * 121665, h9 = (long long)f->v[9] * 121665;
+	long long carry9 = (h9 + (1LL << 24)) >> 25; h0 += carry9 * 19; h9 -= carry9 << 25;
+	long long carry1 = (h1 + (1LL << 24)) >> 25; h2 += carry1; h1 -= carry1 << 25;
+	long long carry3 = (h3 + (1LL << 24)) >> 25; h4 += carry3; h3 -= carry3 << 25;
+	long long carry5 = (h5 + (1LL << 24)) >> 25; h6 += carry5; h5 -= carry5 << 25;
+	long long carry7 = (h7 + (1LL << 24)) >> 25; h8 += carry7; h7 -= carry7 << 25;
+	long long carry0 = (h0 + (1LL << 25)) >> 26; h1 += carry0; h0 -= carry0 << 26;
+	long long carry2 = (h2 + (1LL << 25)) >> 26; h3 += carry2; h2 -= carry2 << 26;
+	long long carry4 = (h4 + (1LL << 25)) >> 26; h5 += carry4; h4 -= carry4 << 26;
+	long long carry6 = (h6 + (1LL << 25)) >> 26; h7 += carry6; h6 -= carry6 << 26;
+	long long carry8 = (h8 + (1LL << 25)) >> 26; h9 += carry8; h8 -= carry8 << 26;
+	h->v[0] = (int)h0; h->v[1] = (int)h1; h->v[2] = (int)h2; h->v[3] = (int)h3; h->v[4] = (int)h4;
+	h->v[5] = (int)h5; h->v[6] = (int)h6; h->v[7] = (int)h7; h->v[8] = (int)h8; h->v[9] = (int)h9;
 }
 
 static inline void feinvert(fe *out, const fe *z){
@@ -871,7 +1014,7 @@ static void ladder_get_x2z2(const unsigned char sk[32], fe *out_x2, fe *out_z2){
 	// X2' = AA*BB
 	fem(&x2,&aa,&bb);
 	// Z2' = E * (AA + a24*E), a24 = 121665
-	fe a24c; fe0(&a24c); a24c.v[0] = 121665; fem(&tmp,&e,&a24c); fea(&tmp,&aa,&tmp); fem(&z2,&e,&tmp); }
+	fea24(&tmp,&e); fea(&tmp,&aa,&tmp); fem(&z2,&e,&tmp); }
 	fex(&x2,&x3,swap); fex(&z2,&z3,swap);
 	fec(out_x2, &x2); fec(out_z2, &z2);
 }
@@ -879,6 +1022,7 @@ static void ladder_get_x2z2(const unsigned char sk[32], fe *out_x2, fe *out_z2){
 // Batch inversion: given z[0..n-1], compute inv[ i ] = 1/z[i] using 1 inversion + O(n) muls
 static void fe_batch_invert(fe *out_inv, const fe *in_z, int n){
 	if (n <= 0) return;
+	if (n == 1) { feinvert(&out_inv[0], &in_z[0]); return; }
 	fe *prefix = (fe*)malloc((size_t)n * sizeof(fe));
 	if (!prefix) { // fallback: individual inversions
 		for (int i=0;i<n;++i) feinvert(&out_inv[i], &in_z[i]);
@@ -898,6 +1042,1093 @@ static void fe_batch_invert(fe *out_inv, const fe *in_z, int n){
 	free(prefix);
 }
 
+// --- Native 5x51 field arithmetic (MEKG_CPU_FE=fe51) ---
+// The 10x(26/25) backends above repack into 5x51 limbs on every multiply and split back afterwards.
+// fe51 keeps radix 2^51 limbs from fe51_frombytes through the whole ladder, inversion and batch
+// inversion, and only serializes once in fe51_tobytes.
+// Limb bounds: mul/sq/mul_small outputs are carried (< 2^51 + 2^13); fe51_add of two carried values
+// stays < 2^52.1 and fe51_sub (bias 4p) stays < 2^53.4, which keeps every 128-bit column below 2^115.
+typedef struct { uint64_t v[5]; } fe51;
+#define FE51_MASK ((1ULL << 51) - 1)
+
+static inline void fe51_0(fe51 *h){ h->v[0]=0; h->v[1]=0; h->v[2]=0; h->v[3]=0; h->v[4]=0; }
+static inline void fe51_1(fe51 *h){ fe51_0(h); h->v[0]=1; }
+static inline void fe51_add(fe51 *h, const fe51 *f, const fe51 *g){
+	for (int i = 0; i < 5; ++i) h->v[i] = f->v[i] + g->v[i];
+}
+static inline void fe51_sub(fe51 *h, const fe51 *f, const fe51 *g){
+	// f + 4p - g keeps every limb non-negative for carried g
+	h->v[0] = f->v[0] + 0x1FFFFFFFFFFFB4ULL - g->v[0];
+	h->v[1] = f->v[1] + 0x1FFFFFFFFFFFFCULL - g->v[1];
+	h->v[2] = f->v[2] + 0x1FFFFFFFFFFFFCULL - g->v[2];
+	h->v[3] = f->v[3] + 0x1FFFFFFFFFFFFCULL - g->v[3];
+	h->v[4] = f->v[4] + 0x1FFFFFFFFFFFFCULL - g->v[4];
+}
+static inline void fe51_cswap(fe51 *f, fe51 *g, uint64_t b){
+	uint64_t m = (uint64_t)0 - b;
+	for (int i = 0; i < 5; ++i) { uint64_t x = m & (f->v[i] ^ g->v[i]); f->v[i] ^= x; g->v[i] ^= x; }
+}
+
+ME_DIAG_PUSH
+ME_DIAG_IGNORED_PEDANTIC
+typedef unsigned __int128 fe51_u128;
+// Carry 128-bit columns down to 51-bit limbs, folding the top carry back in via *19
+static inline void fe51_carry_wide(fe51 *h, fe51_u128 r0, fe51_u128 r1, fe51_u128 r2, fe51_u128 r3, fe51_u128 r4){
+	uint64_t c;
+	c = (uint64_t)(r0 >> 51); r1 += c; uint64_t h0 = (uint64_t)r0 & FE51_MASK;
+	c = (uint64_t)(r1 >> 51); r2 += c; uint64_t h1 = (uint64_t)r1 & FE51_MASK;
+	c = (uint64_t)(r2 >> 51); r3 += c; uint64_t h2 = (uint64_t)r2 & FE51_MASK;
+	c = (uint64_t)(r3 >> 51); r4 += c; uint64_t h3 = (uint64_t)r3 & FE51_MASK;
+	c = (uint64_t)(r4 >> 51);          uint64_t h4 = (uint64_t)r4 & FE51_MASK;
+	h0 += c * 19;
+	c = h0 >> 51; h0 &= FE51_MASK; h1 += c;
+	h->v[0]=h0; h->v[1]=h1; h->v[2]=h2; h->v[3]=h3; h->v[4]=h4;
+}
+static inline void fe51_mul(fe51 *h, const fe51 *f, const fe51 *g){
+	uint64_t f0=f->v[0], f1=f->v[1], f2=f->v[2], f3=f->v[3], f4=f->v[4];
+	uint64_t g0=g->v[0], g1=g->v[1], g2=g->v[2], g3=g->v[3], g4=g->v[4];
+	uint64_t g1_19 = g1 * 19, g2_19 = g2 * 19, g3_19 = g3 * 19, g4_19 = g4 * 19;
+	fe51_u128 r0 = (fe51_u128)f0*g0 + (fe51_u128)f1*g4_19 + (fe51_u128)f2*g3_19 + (fe51_u128)f3*g2_19 + (fe51_u128)f4*g1_19;
+	fe51_u128 r1 = (fe51_u128)f0*g1 + (fe51_u128)f1*g0 + (fe51_u128)f2*g4_19 + (fe51_u128)f3*g3_19 + (fe51_u128)f4*g2_19;
+	fe51_u128 r2 = (fe51_u128)f0*g2 + (fe51_u128)f1*g1 + (fe51_u128)f2*g0 + (fe51_u128)f3*g4_19 + (fe51_u128)f4*g3_19;
+	fe51_u128 r3 = (fe51_u128)f0*g3 + (fe51_u128)f1*g2 + (fe51_u128)f2*g1 + (fe51_u128)f3*g0 + (fe51_u128)f4*g4_19;
+	fe51_u128 r4 = (fe51_u128)f0*g4 + (fe51_u128)f1*g3 + (fe51_u128)f2*g2 + (fe51_u128)f3*g1 + (fe51_u128)f4*g0;
+	fe51_carry_wide(h, r0, r1, r2, r3, r4);
+}
+static inline void fe51_sq(fe51 *h, const fe51 *f){
+	uint64_t f0=f->v[0], f1=f->v[1], f2=f->v[2], f3=f->v[3], f4=f->v[4];
+	uint64_t f0_2 = f0 * 2, f1_2 = f1 * 2;
+	uint64_t f1_38 = f1 * 38, f2_38 = f2 * 38, f3_38 = f3 * 38, f3_19 = f3 * 19, f4_19 = f4 * 19;
+	fe51_u128 r0 = (fe51_u128)f0*f0   + (fe51_u128)f1_38*f4 + (fe51_u128)f2_38*f3;
+	fe51_u128 r1 = (fe51_u128)f0_2*f1 + (fe51_u128)f2_38*f4 + (fe51_u128)f3_19*f3;
+	fe51_u128 r2 = (fe51_u128)f0_2*f2 + (fe51_u128)f1*f1    + (fe51_u128)f3_38*f4;
+	fe51_u128 r3 = (fe51_u128)f0_2*f3 + (fe51_u128)f1_2*f2  + (fe51_u128)f4_19*f4;
+	fe51_u128 r4 = (fe51_u128)f0_2*f4 + (fe51_u128)f1_2*f3  + (fe51_u128)f2*f2;
+	fe51_carry_wide(h, r0, r1, r2, r3, r4);
+}
+static inline void fe51_mul_small(fe51 *h, const fe51 *f, uint64_t k){
+	fe51_carry_wide(h, (fe51_u128)f->v[0]*k, (fe51_u128)f->v[1]*k, (fe51_u128)f->v[2]*k,
+		(fe51_u128)f->v[3]*k, (fe51_u128)f->v[4]*k);
+}
+ME_DIAG_POP
+
+static inline void fe51_sqn(fe51 *h, const fe51 *f, int n){
+	fe51_sq(h, f);
+	for (int i = 1; i < n; ++i) fe51_sq(h, h);
+}
+
+static inline void fe51_frombytes(fe51 *h, const unsigned char s[32]){
+	uint64_t w[4];
+	for (int i = 0; i < 4; ++i) {
+		w[i] = 0;
+		for (int j = 7; j >= 0; --j) w[i] = (w[i] << 8) | s[i*8 + j];
+	}
+	h->v[0] = w[0] & FE51_MASK;
+	h->v[1] = ((w[0] >> 51) | (w[1] << 13)) & FE51_MASK;
+	h->v[2] = ((w[1] >> 38) | (w[2] << 26)) & FE51_MASK;
+	h->v[3] = ((w[2] >> 25) | (w[3] << 39)) & FE51_MASK;
+	h->v[4] = (w[3] >> 12) & FE51_MASK; // bit 255 ignored per RFC 7748
+}
+
+static inline void fe51_tobytes(unsigned char s[32], const fe51 *h){
+	uint64_t t0=h->v[0], t1=h->v[1], t2=h->v[2], t3=h->v[3], t4=h->v[4], c;
+	// Two carry passes bring the value below 2^255 + 2^13 < 2p
+	for (int pass = 0; pass < 2; ++pass) {
+		c = t0 >> 51; t0 &= FE51_MASK; t1 += c;
+		c = t1 >> 51; t1 &= FE51_MASK; t2 += c;
+		c = t2 >> 51; t2 &= FE51_MASK; t3 += c;
+		c = t3 >> 51; t3 &= FE51_MASK; t4 += c;
+		c = t4 >> 51; t4 &= FE51_MASK; t0 += c * 19;
+	}
+	// q = 1 iff value >= p; then add 19*q and drop bit 255 (same trick as ref10 fetobytes)
+	uint64_t q = (t0 + 19) >> 51;
+	q = (t1 + q) >> 51; q = (t2 + q) >> 51; q = (t3 + q) >> 51; q = (t4 + q) >> 51;
+	t0 += 19 * q;
+	c = t0 >> 51; t0 &= FE51_MASK; t1 += c;
+	c = t1 >> 51; t1 &= FE51_MASK; t2 += c;
+	c = t2 >> 51; t2 &= FE51_MASK; t3 += c;
+	c = t3 >> 51; t3 &= FE51_MASK; t4 += c;
+	t4 &= FE51_MASK;
+	uint64_t w[4] = { t0 | (t1 << 51), (t1 >> 13) | (t2 << 38), (t2 >> 26) | (t3 << 25), (t3 >> 39) | (t4 << 12) };
+	for (int i = 0; i < 4; ++i) for (int j = 0; j < 8; ++j) s[i*8 + j] = (unsigned char)(w[i] >> (8*j));
+}
+
+// z^(p-2) with the same addition chain as feinvert
+static void fe51_invert(fe51 *out, const fe51 *z){
+	fe51 t0, t1, t2, t3;
+	fe51_sq(&t0, z);              // z^2
+	fe51_sqn(&t1, &t0, 2);        // z^8
+	fe51_mul(&t1, &t1, z);        // z^9
+	fe51_mul(&t0, &t0, &t1);      // z^11
+	fe51_sq(&t2, &t0);            // z^22
+	fe51_mul(&t1, &t1, &t2);      // z^(2^5 - 1)
+	fe51_sqn(&t2, &t1, 5);
+	fe51_mul(&t1, &t2, &t1);      // z^(2^10 - 1)
+	fe51_sqn(&t2, &t1, 10);
+	fe51_mul(&t2, &t2, &t1);      // z^(2^20 - 1)
+	fe51_sqn(&t3, &t2, 20);
+	fe51_mul(&t2, &t3, &t2);      // z^(2^40 - 1)
+	fe51_sqn(&t2, &t2, 10);
+	fe51_mul(&t1, &t2, &t1);      // z^(2^50 - 1)
+	fe51_sqn(&t2, &t1, 50);
+	fe51_mul(&t2, &t2, &t1);      // z^(2^100 - 1)
+	fe51_sqn(&t3, &t2, 100);
+	fe51_mul(&t2, &t3, &t2);      // z^(2^200 - 1)
+	fe51_sqn(&t2, &t2, 50);
+	fe51_mul(&t2, &t2, &t1);      // z^(2^250 - 1)
+	fe51_sqn(&t2, &t2, 5);        // z^(2^255 - 32)
+	fe51_mul(out, &t2, &t0);      // z^(2^255 - 21)
+}
+
+// Batch inversion without scratch: out[i] first holds the prefix product z[0..i-1], then 1/z[i].
+// out must not alias in.
+static void fe51_batch_invert(fe51 *out, const fe51 *in, int n){
+	if (n <= 0) return;
+	fe51 acc; fe51_1(&acc);
+	for (int i = 0; i < n; ++i) { out[i] = acc; fe51_mul(&acc, &acc, &in[i]); }
+	fe51 inv; fe51_invert(&inv, &acc);
+	for (int i = n - 1; i >= 0; --i) {
+		fe51 t; fe51_mul(&t, &inv, &out[i]);
+		fe51_mul(&inv, &inv, &in[i]);
+		out[i] = t;
+	}
+}
+
+// Montgomery ladder on u=9 returning projective (X2, Z2); same step formulas as ladder_get_x2z2
+static void ladder51_get_x2z2(const unsigned char sk[32], fe51 *out_x2, fe51 *out_z2){
+	fe51 x2, z2, x3, z3, a, aa, b, bb, e, c, d, da, cb, t;
+	fe51_1(&x2); fe51_0(&z2); fe51_0(&x3); x3.v[0] = 9; fe51_1(&z3);
+	uint64_t swap = 0;
+	for (int pos = 254; pos >= 0; --pos) {
+		uint64_t bit = (uint64_t)((sk[pos>>3] >> (pos & 7)) & 1);
+		swap ^= bit; fe51_cswap(&x2, &x3, swap); fe51_cswap(&z2, &z3, swap); swap = bit;
+		fe51_add(&a, &x2, &z2); fe51_sq(&aa, &a);
+		fe51_sub(&b, &x2, &z2); fe51_sq(&bb, &b);
+		fe51_sub(&e, &aa, &bb);
+		fe51_add(&c, &x3, &z3); fe51_sub(&d, &x3, &z3);
+		fe51_mul(&da, &d, &a); fe51_mul(&cb, &c, &b);
+		fe51_add(&t, &da, &cb); fe51_sq(&x3, &t);
+		fe51_sub(&t, &da, &cb); fe51_sq(&t, &t); fe51_mul_small(&z3, &t, 9); // x1 = 9
+		fe51_mul(&x2, &aa, &bb);
+		fe51_mul_small(&t, &e, 121665); fe51_add(&t, &aa, &t); fe51_mul(&z2, &e, &t);
+	}
+	fe51_cswap(&x2, &x3, swap); fe51_cswap(&z2, &z3, swap);
+	*out_x2 = x2; *out_z2 = z2;
+}
+
+// Projective basepoint multiple used by the fe51 paths: the ladder, or the comb once MEKG_CPU_FE selects it
+static void (*g_fe51_x2z2)(const unsigned char sk[32], fe51 *x2, fe51 *z2) = ladder51_get_x2z2;
+
+static ME_MAYBE_UNUSED void x25519_basepoint_mul_fe51(const unsigned char sk[32], unsigned char out[32]){
+	fe51 x2, z2, zi;
+	g_fe51_x2z2(sk, &x2, &z2);
+	fe51_invert(&zi, &z2); fe51_mul(&x2, &x2, &zi); fe51_tobytes(out, &x2);
+}
+
+// Batched public keys for n clamped secrets: n projective multiples (g_fe51_x2z2), one shared inversion, n finishes.
+// X2/Z2/Zinv are caller-provided scratch arrays of at least n entries.
+static void x25519_base_batch_fe51(const unsigned char *sks, int n, unsigned char *pubs, fe51 *X2, fe51 *Z2, fe51 *Zinv){
+	for (int i = 0; i < n; ++i) g_fe51_x2z2(sks + (size_t)i * 32, &X2[i], &Z2[i]);
+	PROF_LAP(PROF_LADDER);
+	fe51_batch_invert(Zinv, Z2, n);
+	PROF_LAP(PROF_INVERT);
+	for (int i = 0; i < n; ++i) {
+		fe51 x; fe51_mul(&x, &X2[i], &Zinv[i]); fe51_tobytes(pubs + (size_t)i * 32, &x);
+	}
+	PROF_LAP(PROF_FINISH);
+}
+
+// --- Fixed-base comb on edwards25519 (MEKG_CPU_FE=fixedbase) ---
+// Public keys are always X25519(sk, 9), so the basepoint multiple can come from a table instead of a
+// 255-step ladder. The Montgomery basepoint u=9 is the Edwards point B with y = 4/5, and
+// u = (1 + y) / (1 - y) = (Z + Y) / (Z - Y) maps back. g_fb_table[i][j] = (j+1) * 256^i * B in
+// affine (y+x, y-x, 2dxy) form. A clamped scalar becomes 64 signed radix-16 digits, as in ref10
+// ge_scalarmult_base: 64 constant-time lookups and mixed additions, 4 doublings, no inversion.
+// The result is returned projectively as (Z+Y, Z-Y), so callers use it exactly like the ladder's
+// (X2, Z2) and share one batch inversion.
+typedef struct { fe51 X, Y, Z; } ge51_p2;
+typedef struct { fe51 X, Y, Z, T; } ge51_p3;
+typedef struct { fe51 X, Y, Z, T; } ge51_p1p1;
+typedef struct { fe51 YplusX, YminusX, Z, T2d; } ge51_cached;
+typedef struct { fe51 yplusx, yminusx, xy2d; } ge51_precomp;
+static ge51_precomp g_fb_table[32][8];
+static int g_fb_ready = 0;
+
+// Weak reduction: limbs back to 51 bits (+ a small carry into limb 1) after chained add/sub
+static inline void fe51_carry(fe51 *h){
+	uint64_t c;
+	c = h->v[0] >> 51; h->v[0] &= FE51_MASK; h->v[1] += c;
+	c = h->v[1] >> 51; h->v[1] &= FE51_MASK; h->v[2] += c;
+	c = h->v[2] >> 51; h->v[2] &= FE51_MASK; h->v[3] += c;
+	c = h->v[3] >> 51; h->v[3] &= FE51_MASK; h->v[4] += c;
+	c = h->v[4] >> 51; h->v[4] &= FE51_MASK; h->v[0] += c * 19;
+	c = h->v[0] >> 51; h->v[0] &= FE51_MASK; h->v[1] += c;
+}
+static inline void fe51_neg(fe51 *h, const fe51 *f){
+	fe51 z; fe51_0(&z); fe51_sub(h, &z, f); fe51_carry(h);
+}
+static inline void fe51_cmov(fe51 *f, const fe51 *g, uint64_t b){
+	uint64_t m = (uint64_t)0 - b;
+	for (int i = 0; i < 5; ++i) f->v[i] ^= m & (f->v[i] ^ g->v[i]);
+}
+static int fe51_equal(const fe51 *f, const fe51 *g){
+	unsigned char a[32], b[32];
+	fe51_tobytes(a, f); fe51_tobytes(b, g);
+	return memcmp(a, b, 32) == 0;
+}
+// f^e for a 256-bit little-endian exponent (startup only; not constant time)
+static void fe51_pow(fe51 *out, const fe51 *f, const unsigned char e[32]){
+	fe51 r; fe51_1(&r);
+	for (int i = 255; i >= 0; --i) {
+		fe51_sq(&r, &r);
+		if ((e[i >> 3] >> (i & 7)) & 1) fe51_mul(&r, &r, f);
+	}
+	*out = r;
+}
+
+static inline void ge51_p1p1_to_p2(ge51_p2 *r, const ge51_p1p1 *p){
+	fe51_mul(&r->X, &p->X, &p->T); fe51_mul(&r->Y, &p->Y, &p->Z); fe51_mul(&r->Z, &p->Z, &p->T);
+}
+static inline void ge51_p1p1_to_p3(ge51_p3 *r, const ge51_p1p1 *p){
+	fe51_mul(&r->X, &p->X, &p->T); fe51_mul(&r->Y, &p->Y, &p->Z);
+	fe51_mul(&r->Z, &p->Z, &p->T); fe51_mul(&r->T, &p->X, &p->Y);
+}
+// ref10 ge_p2_dbl (a = -1)
+static inline void ge51_p2_dbl(ge51_p1p1 *r, const ge51_p2 *p){
+	fe51 t0;
+	fe51_sq(&r->X, &p->X);
+	fe51_sq(&r->Z, &p->Y);
+	fe51_sq(&r->T, &p->Z); fe51_add(&r->T, &r->T, &r->T);
+	fe51_add(&r->Y, &p->X, &p->Y); fe51_sq(&t0, &r->Y);
+	fe51_add(&r->Y, &r->Z, &r->X);
+	fe51_sub(&r->Z, &r->Z, &r->X); fe51_carry(&r->Z);
+	fe51_sub(&r->X, &t0, &r->Y);
+	fe51_sub(&r->T, &r->T, &r->Z);
+}
+// ref10 ge_madd: p + q for affine q
+static inline void ge51_madd(ge51_p1p1 *r, const ge51_p3 *p, const ge51_precomp *q){
+	fe51 t0;
+	fe51_add(&r->X, &p->Y, &p->X);
+	fe51_sub(&r->Y, &p->Y, &p->X);
+	fe51_mul(&r->Z, &r->X, &q->yplusx);
+	fe51_mul(&r->Y, &r->Y, &q->yminusx);
+	fe51_mul(&r->T, &q->xy2d, &p->T);
+	fe51_add(&t0, &p->Z, &p->Z);
+	fe51_sub(&r->X, &r->Z, &r->Y);
+	fe51_add(&r->Y, &r->Z, &r->Y);
+	fe51_add(&r->Z, &t0, &r->T);
+	fe51_sub(&r->T, &t0, &r->T);
+}
+// ref10 ge_add: p + q for projective q (table construction only)
+static void ge51_add(ge51_p1p1 *r, const ge51_p3 *p, const ge51_cached *q){
+	fe51 t0;
+	fe51_add(&r->X, &p->Y, &p->X);
+	fe51_sub(&r->Y, &p->Y, &p->X);
+	fe51_mul(&r->Z, &r->X, &q->YplusX);
+	fe51_mul(&r->Y, &r->Y, &q->YminusX);
+	fe51_mul(&r->T, &q->T2d, &p->T);
+	fe51_mul(&r->X, &p->Z, &q->Z);
+	fe51_add(&t0, &r->X, &r->X);
+	fe51_sub(&r->X, &r->Z, &r->Y);
+	fe51_add(&r->Y, &r->Z, &r->Y);
+	fe51_add(&r->Z, &t0, &r->T);
+	fe51_sub(&r->T, &t0, &r->T);
+}
+static void ge51_p3_to_cached(ge51_cached *r, const ge51_p3 *p, const fe51 *d2){
+	fe51_add(&r->YplusX, &p->Y, &p->X); fe51_carry(&r->YplusX);
+	fe51_sub(&r->YminusX, &p->Y, &p->X); fe51_carry(&r->YminusX);
+	r->Z = p->Z;
+	fe51_mul(&r->T2d, &p->T, d2);
+}
+static void ge51_p3_dbl(ge51_p3 *r, const ge51_p3 *p){
+	ge51_p2 q = { p->X, p->Y, p->Z }; ge51_p1p1 t;
+	ge51_p2_dbl(&t, &q); ge51_p1p1_to_p3(r, &t);
+}
+
+// Build g_fb_table once: derive d, B and 2d at runtime, then 256 multiples with one batch inversion
+static int fixedbase_init(void){
+	static const unsigned char exp_sqrt[32] = { // (p+3)/8 = 2^252 - 2
+		0xfe,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+		0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0x0f };
+	static const unsigned char exp_i[32] = { // (p-1)/4 = 2^253 - 5, 2^((p-1)/4) = sqrt(-1)
+		0xfb,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+		0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0x1f };
+	if (g_fb_ready) return 1;
+	fe51 one, t, d, d2, y, x, yy, num, den, beta, chk, sqrtm1, two;
+	fe51_1(&one);
+	// d = -121665 / 121666
+	fe51_0(&t); t.v[0] = 121666; fe51_invert(&t, &t);
+	fe51_mul_small(&d, &t, 121665); fe51_neg(&d, &d);
+	fe51_add(&d2, &d, &d); fe51_carry(&d2);
+	// B: y = 4/5, x = sqrt((y^2 - 1) / (d y^2 + 1))
+	fe51_0(&t); t.v[0] = 5; fe51_invert(&t, &t); fe51_mul_small(&y, &t, 4);
+	fe51_sq(&yy, &y);
+	fe51_sub(&num, &yy, &one); fe51_carry(&num);
+	fe51_mul(&den, &d, &yy); fe51_add(&den, &den, &one);
+	fe51_invert(&t, &den); fe51_mul(&t, &num, &t); // x^2
+	fe51_pow(&beta, &t, exp_sqrt);
+	fe51_sq(&chk, &beta);
+	if (!fe51_equal(&chk, &t)) {
+		fe51_0(&two); two.v[0] = 2; fe51_pow(&sqrtm1, &two, exp_i);
+		fe51_mul(&beta, &beta, &sqrtm1); fe51_sq(&chk, &beta);
+		if (!fe51_equal(&chk, &t)) return 0;
+	}
+	x = beta;
+	ge51_p3 *pts = (ge51_p3 *)malloc(sizeof(ge51_p3) * 256);
+	fe51 *zs = (fe51 *)malloc(sizeof(fe51) * 256), *zi = (fe51 *)malloc(sizeof(fe51) * 256);
+	if (!pts || !zs || !zi) { free(pts); free(zs); free(zi); return 0; }
+	ge51_p3 bi; bi.X = x; bi.Y = y; fe51_1(&bi.Z); fe51_mul(&bi.T, &x, &y);
+	for (int i = 0; i < 32; ++i) {
+		ge51_cached bc; ge51_p1p1 s;
+		ge51_p3_to_cached(&bc, &bi, &d2);
+		pts[i * 8] = bi;
+		for (int j = 1; j < 8; ++j) { ge51_add(&s, &pts[i * 8 + j - 1], &bc); ge51_p1p1_to_p3(&pts[i * 8 + j], &s); }
+		for (int k = 0; k < 8; ++k) ge51_p3_dbl(&bi, &bi); // next row: 256 * B_i
+	}
+	for (int k = 0; k < 256; ++k) zs[k] = pts[k].Z;
+	fe51_batch_invert(zi, zs, 256);
+	for (int k = 0; k < 256; ++k) {
+		fe51 ax, ay; ge51_precomp *e = &g_fb_table[k / 8][k % 8];
+		fe51_mul(&ax, &pts[k].X, &zi[k]); fe51_mul(&ay, &pts[k].Y, &zi[k]);
+		fe51_add(&e->yplusx, &ay, &ax); fe51_carry(&e->yplusx);
+		fe51_sub(&e->yminusx, &ay, &ax); fe51_carry(&e->yminusx);
+		fe51_mul(&e->xy2d, &ax, &ay); fe51_mul(&e->xy2d, &e->xy2d, &d2);
+	}
+	free(pts); free(zs); free(zi);
+	g_fb_ready = 1;
+	return 1;
+}
+
+// Constant-time t = b * row[0] for b in [-8, 8] (row[j] = (j+1) * B_i)
+static inline void fixedbase_select(ge51_precomp *t, const ge51_precomp row[8], signed char b){
+	uint64_t neg = (uint64_t)((unsigned char)b >> 7);
+	unsigned char babs = (unsigned char)(b - (((-(int)neg) & b) << 1));
+	fe51_1(&t->yplusx); fe51_1(&t->yminusx); fe51_0(&t->xy2d);
+	for (int j = 0; j < 8; ++j) {
+		uint64_t eq = (uint64_t)(((unsigned)(babs ^ (j + 1)) - 1U) >> 31);
+		fe51_cmov(&t->yplusx, &row[j].yplusx, eq);
+		fe51_cmov(&t->yminusx, &row[j].yminusx, eq);
+		fe51_cmov(&t->xy2d, &row[j].xy2d, eq);
+	}
+	// -P swaps y+x and y-x and negates 2dxy
+	fe51 nxy; fe51_neg(&nxy, &t->xy2d);
+	fe51_cswap(&t->yplusx, &t->yminusx, neg);
+	fe51_cmov(&t->xy2d, &nxy, neg);
+}
+
+// sk * B via the comb, returned as the Montgomery u-coordinate (Z+Y : Z-Y); sk must be clamped
+static void fixedbase_get_x2z2(const unsigned char sk[32], fe51 *out_x2, fe51 *out_z2){
+	signed char e[64];
+	for (int i = 0; i < 32; ++i) { e[2*i] = (signed char)(sk[i] & 15); e[2*i + 1] = (signed char)((sk[i] >> 4) & 15); }
+	signed char carry = 0;
+	for (int i = 0; i < 63; ++i) {
+		e[i] = (signed char)(e[i] + carry);
+		carry = (signed char)((e[i] + 8) >> 4);
+		e[i] = (signed char)(e[i] - (carry << 4));
+	}
+	e[63] = (signed char)(e[63] + carry);
+
+	ge51_p3 h; ge51_p1p1 r; ge51_p2 s; ge51_precomp t;
+	fe51_0(&h.X); fe51_1(&h.Y); fe51_1(&h.Z); fe51_0(&h.T);
+	for (int i = 1; i < 64; i += 2) {
+		fixedbase_select(&t, g_fb_table[i / 2], e[i]);
+		ge51_madd(&r, &h, &t); ge51_p1p1_to_p3(&h, &r);
+	}
+	s.X = h.X; s.Y = h.Y; s.Z = h.Z;
+	ge51_p2_dbl(&r, &s); ge51_p1p1_to_p2(&s, &r);
+	ge51_p2_dbl(&r, &s); ge51_p1p1_to_p2(&s, &r);
+	ge51_p2_dbl(&r, &s); ge51_p1p1_to_p2(&s, &r);
+	ge51_p2_dbl(&r, &s); ge51_p1p1_to_p3(&h, &r);
+	for (int i = 0; i < 64; i += 2) {
+		fixedbase_select(&t, g_fb_table[i / 2], e[i]);
+		ge51_madd(&r, &h, &t); ge51_p1p1_to_p3(&h, &r);
+	}
+	fe51_add(out_x2, &h.Z, &h.Y); fe51_carry(out_x2);
+	fe51_sub(out_z2, &h.Z, &h.Y); fe51_carry(out_z2);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// --- 4-lane AVX2 ladder (MEKG_EXPERIMENTAL_AVX2_MULTI=4) ---
+// Four independent secrets run the Montgomery ladder in lockstep. Each limb of fe4 is one __m256i
+// holding that limb for lanes 0..3 as 64-bit words, so _mm256_mul_epu32 computes four 32x32->64
+// limb products at once. Limbs use the ref10 10x(26/25) radix: after fe4_carry they are below
+// 2^26, fe4_sub adds 2p and stays below 2^27.6, and 19*limb still fits the 32-bit multiplier
+// input. fe_soa4 is the packed in-memory form between the ladder and the batch inversion.
+#define ME_TARGET_AVX2 __attribute__((target("avx2")))
+typedef struct { __m256i v[10]; } fe4;
+
+ME_TARGET_AVX2
+static inline void fe4_load(fe4 *h, const fe_soa4 *f){
+	for (int i = 0; i < 10; ++i) h->v[i] = _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *)f->limb[i]));
+}
+ME_TARGET_AVX2
+static inline void fe4_store(fe_soa4 *h, const fe4 *f){
+	const __m256i idx = _mm256_setr_epi32(0, 2, 4, 6, 0, 0, 0, 0);
+	for (int i = 0; i < 10; ++i)
+		_mm_storeu_si128((__m128i *)h->limb[i], _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(f->v[i], idx)));
+}
+ME_TARGET_AVX2
+static inline void fe4_set_small(fe4 *h, int k){
+	h->v[0] = _mm256_set1_epi64x(k);
+	for (int i = 1; i < 10; ++i) h->v[i] = _mm256_setzero_si256();
+}
+ME_TARGET_AVX2
+static inline void fe4_add(fe4 *h, const fe4 *f, const fe4 *g){
+	for (int i = 0; i < 10; ++i) h->v[i] = _mm256_add_epi64(f->v[i], g->v[i]);
+}
+ME_TARGET_AVX2
+static inline void fe4_sub(fe4 *h, const fe4 *f, const fe4 *g){
+	// f + 2p - g: carried g limbs never exceed the 2p limbs, so lanes stay non-negative
+	const __m256i p0 = _mm256_set1_epi64x(0x7FFFFDA), pe = _mm256_set1_epi64x(0x7FFFFFE), po = _mm256_set1_epi64x(0x3FFFFFE);
+	for (int i = 0; i < 10; ++i)
+		h->v[i] = _mm256_sub_epi64(_mm256_add_epi64(f->v[i], i == 0 ? p0 : (i & 1) ? po : pe), g->v[i]);
+}
+ME_TARGET_AVX2
+static inline void fe4_cswap(fe4 *f, fe4 *g, __m256i mask){
+	for (int i = 0; i < 10; ++i) {
+		__m256i x = _mm256_and_si256(mask, _mm256_xor_si256(f->v[i], g->v[i]));
+		f->v[i] = _mm256_xor_si256(f->v[i], x); g->v[i] = _mm256_xor_si256(g->v[i], x);
+	}
+}
+// Carry 64-bit column sums down to 26/25-bit limbs; the top carry (up to 2^37) folds back as *19
+ME_TARGET_AVX2
+static inline void fe4_carry(fe4 *h, __m256i r[10]){
+	const __m256i m26 = _mm256_set1_epi64x((1 << 26) - 1), m25 = _mm256_set1_epi64x((1 << 25) - 1);
+	for (int i = 0; i < 9; ++i) {
+		int s = (i & 1) ? 25 : 26;
+		__m256i c = _mm256_srli_epi64(r[i], s);
+		r[i + 1] = _mm256_add_epi64(r[i + 1], c);
+		r[i] = _mm256_and_si256(r[i], (i & 1) ? m25 : m26);
+	}
+	__m256i c = _mm256_srli_epi64(r[9], 25);
+	r[9] = _mm256_and_si256(r[9], m25);
+	c = _mm256_add_epi64(_mm256_add_epi64(_mm256_slli_epi64(c, 4), _mm256_slli_epi64(c, 1)), c);
+	r[0] = _mm256_add_epi64(r[0], c);
+	c = _mm256_srli_epi64(r[0], 26);
+	r[0] = _mm256_and_si256(r[0], m26);
+	r[1] = _mm256_add_epi64(r[1], c);
+	for (int i = 0; i < 10; ++i) h->v[i] = r[i];
+}
+#define FE4_MUL(a, b) _mm256_mul_epu32((a), (b))
+#define FE4_MAC(acc, a, b) ((acc) = _mm256_add_epi64((acc), _mm256_mul_epu32((a), (b))))
+// Schoolbook 10x10 with the ref10 coefficients: x2 when both limb indices are odd, x19 on wrap
+ME_TARGET_AVX2
+static inline void fe4_mul(fe4 *h, const fe4 *f, const fe4 *g){
+	const __m256i k19 = _mm256_set1_epi64x(19);
+	__m256i f0 = f->v[0], f1 = f->v[1], f2 = f->v[2], f3 = f->v[3], f4 = f->v[4], f5 = f->v[5], f6 = f->v[6],
+		f7 = f->v[7], f8 = f->v[8], f9 = f->v[9];
+	__m256i g0 = g->v[0], g1 = g->v[1], g2 = g->v[2], g3 = g->v[3], g4 = g->v[4], g5 = g->v[5], g6 = g->v[6],
+		g7 = g->v[7], g8 = g->v[8], g9 = g->v[9];
+	__m256i f1_2 = _mm256_add_epi64(f1, f1), f3_2 = _mm256_add_epi64(f3, f3), f5_2 = _mm256_add_epi64(f5, f5),
+		f7_2 = _mm256_add_epi64(f7, f7), f9_2 = _mm256_add_epi64(f9, f9);
+	__m256i g1_19 = _mm256_mul_epu32(g1, k19), g2_19 = _mm256_mul_epu32(g2, k19),
+		g3_19 = _mm256_mul_epu32(g3, k19), g4_19 = _mm256_mul_epu32(g4, k19), g5_19 = _mm256_mul_epu32(g5, k19),
+		g6_19 = _mm256_mul_epu32(g6, k19), g7_19 = _mm256_mul_epu32(g7, k19), g8_19 = _mm256_mul_epu32(g8, k19),
+		g9_19 = _mm256_mul_epu32(g9, k19);
+	__m256i r[10];
+	r[0] = FE4_MUL(f0, g0); FE4_MAC(r[0], f1_2, g9_19); FE4_MAC(r[0], f2, g8_19); FE4_MAC(r[0], f3_2, g7_19);
+	FE4_MAC(r[0], f4, g6_19); FE4_MAC(r[0], f5_2, g5_19); FE4_MAC(r[0], f6, g4_19); FE4_MAC(r[0], f7_2, g3_19);
+	FE4_MAC(r[0], f8, g2_19); FE4_MAC(r[0], f9_2, g1_19);
+	r[1] = FE4_MUL(f0, g1); FE4_MAC(r[1], f1, g0); FE4_MAC(r[1], f2, g9_19); FE4_MAC(r[1], f3, g8_19);
+	FE4_MAC(r[1], f4, g7_19); FE4_MAC(r[1], f5, g6_19); FE4_MAC(r[1], f6, g5_19); FE4_MAC(r[1], f7, g4_19);
+	FE4_MAC(r[1], f8, g3_19); FE4_MAC(r[1], f9, g2_19);
+	r[2] = FE4_MUL(f0, g2); FE4_MAC(r[2], f1_2, g1); FE4_MAC(r[2], f2, g0); FE4_MAC(r[2], f3_2, g9_19);
+	FE4_MAC(r[2], f4, g8_19); FE4_MAC(r[2], f5_2, g7_19); FE4_MAC(r[2], f6, g6_19); FE4_MAC(r[2], f7_2, g5_19);
+	FE4_MAC(r[2], f8, g4_19); FE4_MAC(r[2], f9_2, g3_19);
+	r[3] = FE4_MUL(f0, g3); FE4_MAC(r[3], f1, g2); FE4_MAC(r[3], f2, g1); FE4_MAC(r[3], f3, g0);
+	FE4_MAC(r[3], f4, g9_19); FE4_MAC(r[3], f5, g8_19); FE4_MAC(r[3], f6, g7_19); FE4_MAC(r[3], f7, g6_19);
+	FE4_MAC(r[3], f8, g5_19); FE4_MAC(r[3], f9, g4_19);
+	r[4] = FE4_MUL(f0, g4); FE4_MAC(r[4], f1_2, g3); FE4_MAC(r[4], f2, g2); FE4_MAC(r[4], f3_2, g1);
+	FE4_MAC(r[4], f4, g0); FE4_MAC(r[4], f5_2, g9_19); FE4_MAC(r[4], f6, g8_19); FE4_MAC(r[4], f7_2, g7_19);
+	FE4_MAC(r[4], f8, g6_19); FE4_MAC(r[4], f9_2, g5_19);
+	r[5] = FE4_MUL(f0, g5); FE4_MAC(r[5], f1, g4); FE4_MAC(r[5], f2, g3); FE4_MAC(r[5], f3, g2);
+	FE4_MAC(r[5], f4, g1); FE4_MAC(r[5], f5, g0); FE4_MAC(r[5], f6, g9_19); FE4_MAC(r[5], f7, g8_19);
+	FE4_MAC(r[5], f8, g7_19); FE4_MAC(r[5], f9, g6_19);
+	r[6] = FE4_MUL(f0, g6); FE4_MAC(r[6], f1_2, g5); FE4_MAC(r[6], f2, g4); FE4_MAC(r[6], f3_2, g3);
+	FE4_MAC(r[6], f4, g2); FE4_MAC(r[6], f5_2, g1); FE4_MAC(r[6], f6, g0); FE4_MAC(r[6], f7_2, g9_19);
+	FE4_MAC(r[6], f8, g8_19); FE4_MAC(r[6], f9_2, g7_19);
+	r[7] = FE4_MUL(f0, g7); FE4_MAC(r[7], f1, g6); FE4_MAC(r[7], f2, g5); FE4_MAC(r[7], f3, g4);
+	FE4_MAC(r[7], f4, g3); FE4_MAC(r[7], f5, g2); FE4_MAC(r[7], f6, g1); FE4_MAC(r[7], f7, g0);
+	FE4_MAC(r[7], f8, g9_19); FE4_MAC(r[7], f9, g8_19);
+	r[8] = FE4_MUL(f0, g8); FE4_MAC(r[8], f1_2, g7); FE4_MAC(r[8], f2, g6); FE4_MAC(r[8], f3_2, g5);
+	FE4_MAC(r[8], f4, g4); FE4_MAC(r[8], f5_2, g3); FE4_MAC(r[8], f6, g2); FE4_MAC(r[8], f7_2, g1);
+	FE4_MAC(r[8], f8, g0); FE4_MAC(r[8], f9_2, g9_19);
+	r[9] = FE4_MUL(f0, g9); FE4_MAC(r[9], f1, g8); FE4_MAC(r[9], f2, g7); FE4_MAC(r[9], f3, g6);
+	FE4_MAC(r[9], f4, g5); FE4_MAC(r[9], f5, g4); FE4_MAC(r[9], f6, g3); FE4_MAC(r[9], f7, g2);
+	FE4_MAC(r[9], f8, g1); FE4_MAC(r[9], f9, g0);
+	fe4_carry(h, r);
+}
+// Squaring: 55 products instead of 100; cross terms doubled on the left operand
+ME_TARGET_AVX2
+static inline void fe4_sq(fe4 *h, const fe4 *f){
+	const __m256i k19 = _mm256_set1_epi64x(19);
+	__m256i f0 = f->v[0], f1 = f->v[1], f2 = f->v[2], f3 = f->v[3], f4 = f->v[4], f5 = f->v[5], f6 = f->v[6],
+		f7 = f->v[7], f8 = f->v[8], f9 = f->v[9];
+	__m256i f0_2 = _mm256_add_epi64(f0, f0), f1_2 = _mm256_add_epi64(f1, f1), f2_2 = _mm256_add_epi64(f2, f2),
+		f3_2 = _mm256_add_epi64(f3, f3), f4_2 = _mm256_add_epi64(f4, f4), f5_2 = _mm256_add_epi64(f5, f5),
+		f6_2 = _mm256_add_epi64(f6, f6), f7_2 = _mm256_add_epi64(f7, f7), f8_2 = _mm256_add_epi64(f8, f8),
+		f9_2 = _mm256_add_epi64(f9, f9);
+	__m256i f1_4 = _mm256_add_epi64(f1_2, f1_2), f3_4 = _mm256_add_epi64(f3_2, f3_2),
+		f5_4 = _mm256_add_epi64(f5_2, f5_2), f7_4 = _mm256_add_epi64(f7_2, f7_2);
+	__m256i f5_19 = _mm256_mul_epu32(f5, k19), f6_19 = _mm256_mul_epu32(f6, k19),
+		f7_19 = _mm256_mul_epu32(f7, k19), f8_19 = _mm256_mul_epu32(f8, k19), f9_19 = _mm256_mul_epu32(f9, k19);
+	__m256i r[10];
+	r[0] = FE4_MUL(f0, f0); FE4_MAC(r[0], f1_4, f9_19); FE4_MAC(r[0], f2_2, f8_19); FE4_MAC(r[0], f3_4, f7_19);
+	FE4_MAC(r[0], f4_2, f6_19); FE4_MAC(r[0], f5_2, f5_19);
+	r[1] = FE4_MUL(f0_2, f1); FE4_MAC(r[1], f2_2, f9_19); FE4_MAC(r[1], f3_2, f8_19); FE4_MAC(r[1], f4_2, f7_19);
+	FE4_MAC(r[1], f5_2, f6_19);
+	r[2] = FE4_MUL(f0_2, f2); FE4_MAC(r[2], f1_2, f1); FE4_MAC(r[2], f3_4, f9_19); FE4_MAC(r[2], f4_2, f8_19);
+	FE4_MAC(r[2], f5_4, f7_19); FE4_MAC(r[2], f6, f6_19);
+	r[3] = FE4_MUL(f0_2, f3); FE4_MAC(r[3], f1_2, f2); FE4_MAC(r[3], f4_2, f9_19); FE4_MAC(r[3], f5_2, f8_19);
+	FE4_MAC(r[3], f6_2, f7_19);
+	r[4] = FE4_MUL(f0_2, f4); FE4_MAC(r[4], f1_4, f3); FE4_MAC(r[4], f2, f2); FE4_MAC(r[4], f5_4, f9_19);
+	FE4_MAC(r[4], f6_2, f8_19); FE4_MAC(r[4], f7_2, f7_19);
+	r[5] = FE4_MUL(f0_2, f5); FE4_MAC(r[5], f1_2, f4); FE4_MAC(r[5], f2_2, f3); FE4_MAC(r[5], f6_2, f9_19);
+	FE4_MAC(r[5], f7_2, f8_19);
+	r[6] = FE4_MUL(f0_2, f6); FE4_MAC(r[6], f1_4, f5); FE4_MAC(r[6], f2_2, f4); FE4_MAC(r[6], f3_2, f3);
+	FE4_MAC(r[6], f7_4, f9_19); FE4_MAC(r[6], f8, f8_19);
+	r[7] = FE4_MUL(f0_2, f7); FE4_MAC(r[7], f1_2, f6); FE4_MAC(r[7], f2_2, f5); FE4_MAC(r[7], f3_2, f4);
+	FE4_MAC(r[7], f8_2, f9_19);
+	r[8] = FE4_MUL(f0_2, f8); FE4_MAC(r[8], f1_4, f7); FE4_MAC(r[8], f2_2, f6); FE4_MAC(r[8], f3_4, f5);
+	FE4_MAC(r[8], f4, f4); FE4_MAC(r[8], f9_2, f9_19);
+	r[9] = FE4_MUL(f0_2, f9); FE4_MAC(r[9], f1_2, f8); FE4_MAC(r[9], f2_2, f7); FE4_MAC(r[9], f3_2, f6);
+	FE4_MAC(r[9], f4_2, f5);
+	fe4_carry(h, r);
+}
+ME_TARGET_AVX2
+static inline void fe4_mul_small(fe4 *h, const fe4 *f, int k){
+	const __m256i kv = _mm256_set1_epi64x(k);
+	__m256i r[10];
+	for (int i = 0; i < 10; ++i) r[i] = _mm256_mul_epu32(f->v[i], kv);
+	fe4_carry(h, r);
+}
+ME_TARGET_AVX2
+static inline void fe4_sqn(fe4 *h, const fe4 *f, int n){
+	fe4_sq(h, f);
+	for (int i = 1; i < n; ++i) fe4_sq(h, h);
+}
+
+// Per-lane z^(p-2), same addition chain as feinvert/fe51_invert
+ME_TARGET_AVX2
+static void fe4_invert(fe4 *out, const fe4 *z){
+	fe4 t0, t1, t2, t3;
+	fe4_sq(&t0, z);
+	fe4_sqn(&t1, &t0, 2);
+	fe4_mul(&t1, &t1, z);
+	fe4_mul(&t0, &t0, &t1);
+	fe4_sq(&t2, &t0);
+	fe4_mul(&t1, &t1, &t2);
+	fe4_sqn(&t2, &t1, 5);
+	fe4_mul(&t1, &t2, &t1);
+	fe4_sqn(&t2, &t1, 10);
+	fe4_mul(&t2, &t2, &t1);
+	fe4_sqn(&t3, &t2, 20);
+	fe4_mul(&t2, &t3, &t2);
+	fe4_sqn(&t2, &t2, 10);
+	fe4_mul(&t1, &t2, &t1);
+	fe4_sqn(&t2, &t1, 50);
+	fe4_mul(&t2, &t2, &t1);
+	fe4_sqn(&t3, &t2, 100);
+	fe4_mul(&t2, &t3, &t2);
+	fe4_sqn(&t2, &t2, 50);
+	fe4_mul(&t2, &t2, &t1);
+	fe4_sqn(&t2, &t2, 5);
+	fe4_mul(out, &t2, &t0);
+}
+
+// Ladder on u=9 for the four clamped secrets at sks (lane j = sks + 32*j); same step as ladder51_get_x2z2
+ME_TARGET_AVX2
+static void ladder4_avx2_get_x2z2(const unsigned char *sks, fe_soa4 *out_x2, fe_soa4 *out_z2){
+	fe4 x2, z2, x3, z3, a, aa, b, bb, e, c, d, da, cb, t;
+	fe4_set_small(&x2, 1); fe4_set_small(&z2, 0); fe4_set_small(&x3, 9); fe4_set_small(&z3, 1);
+	__m256i swap = _mm256_setzero_si256();
+	for (int pos = 254; pos >= 0; --pos) {
+		int byte = pos >> 3, sh = pos & 7;
+		__m256i bit = _mm256_set_epi64x((sks[96 + byte] >> sh) & 1, (sks[64 + byte] >> sh) & 1,
+			(sks[32 + byte] >> sh) & 1, (sks[byte] >> sh) & 1);
+		__m256i mask = _mm256_sub_epi64(_mm256_setzero_si256(), _mm256_xor_si256(swap, bit));
+		fe4_cswap(&x2, &x3, mask); fe4_cswap(&z2, &z3, mask); swap = bit;
+		fe4_add(&a, &x2, &z2); fe4_sq(&aa, &a);
+		fe4_sub(&b, &x2, &z2); fe4_sq(&bb, &b);
+		fe4_sub(&e, &aa, &bb);
+		fe4_add(&c, &x3, &z3); fe4_sub(&d, &x3, &z3);
+		fe4_mul(&da, &d, &a); fe4_mul(&cb, &c, &b);
+		fe4_add(&t, &da, &cb); fe4_sq(&x3, &t);
+		fe4_sub(&t, &da, &cb); fe4_sq(&t, &t); fe4_mul_small(&z3, &t, 9);
+		fe4_mul(&x2, &aa, &bb);
+		fe4_mul_small(&t, &e, 121665); fe4_add(&t, &aa, &t); fe4_mul(&z2, &e, &t);
+	}
+	__m256i mask = _mm256_sub_epi64(_mm256_setzero_si256(), swap);
+	fe4_cswap(&x2, &x3, mask); fe4_cswap(&z2, &z3, mask);
+	fe4_store(out_x2, &x2); fe4_store(out_z2, &z2);
+}
+
+// Lane-parallel batch inversion over n vectors (4n field elements, one fe4_invert).
+// out[i] holds the running prefix product first, then 1/in[i]; out must not alias in.
+ME_TARGET_AVX2
+static void fe4_batch_invert_avx2(fe_soa4 *out, const fe_soa4 *in, int n){
+	if (n <= 0) return;
+	fe4 acc, x, inv, t;
+	fe4_set_small(&acc, 1);
+	for (int i = 0; i < n; ++i) { fe4_store(&out[i], &acc); fe4_load(&x, &in[i]); fe4_mul(&acc, &acc, &x); }
+	fe4_invert(&inv, &acc);
+	for (int i = n - 1; i >= 0; --i) {
+		fe4_load(&t, &out[i]); fe4_mul(&t, &inv, &t);
+		fe4_load(&x, &in[i]); fe4_mul(&inv, &inv, &x);
+		fe4_store(&out[i], &t);
+	}
+}
+
+// Public keys for 4*n4 clamped secrets: n4 four-lane ladders, one lane-parallel inversion, then
+// x = X2 * Zinv per vector and per-lane serialization through fe51_tobytes.
+ME_TARGET_AVX2
+static void x25519_base_batch_avx2(const unsigned char *sks, int n4, unsigned char *pubs, fe_soa4 *X2, fe_soa4 *Z2, fe_soa4 *Zinv){
+	for (int i = 0; i < n4; ++i) ladder4_avx2_get_x2z2(sks + (size_t)i * 128, &X2[i], &Z2[i]);
+	PROF_LAP(PROF_LADDER);
+	fe4_batch_invert_avx2(Zinv, Z2, n4);
+	PROF_LAP(PROF_INVERT);
+	for (int i = 0; i < n4; ++i) {
+		fe4 x, zi; fe_soa4 xs;
+		fe4_load(&x, &X2[i]); fe4_load(&zi, &Zinv[i]); fe4_mul(&x, &x, &zi); fe4_store(&xs, &x);
+		for (int lane = 0; lane < 4; ++lane) {
+			fe51 h;
+			for (int k = 0; k < 5; ++k)
+				h.v[k] = (uint64_t)(uint32_t)xs.limb[2*k][lane] + ((uint64_t)(uint32_t)xs.limb[2*k + 1][lane] << 26);
+			fe51_tobytes(pubs + ((size_t)i * 4 + (size_t)lane) * 32, &h);
+		}
+	}
+	PROF_LAP(PROF_FINISH);
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+// --- 8-lane AVX-512 IFMA ladder (default internal path when IFMA is usable; MEKG_CPU_FE=ifma8) ---
+// Eight independent secrets per __m512i, five 51-bit limbs per lane. _mm512_madd52lo/hi_epu64
+// return the low and high 52 bits of each 52x52-bit limb product. A product column i+j therefore
+// lands at 2^(51(i+j)) for the low half and at 2 * 2^(51(i+j+1)) for the high half, so high
+// halves are doubled into the next column, then columns 5..9 fold back with *19.
+// IFMA madd52 arithmetic on fe51's 2^51 limb grid rather than radix 2^52: 2^255 - 19 is not a
+// multiple of 52 bits, and 2^51 lets every reduction stay a plain *19.
+// madd52 reads only the low 52 bits of each input, so every op leaves limbs below 2^52:
+// add/sub carry once in parallel, mul/sq carry twice.
+#define ME_TARGET_IFMA __attribute__((target("avx512f,avx512ifma")))
+typedef struct { __m512i v[5]; } fe8;
+typedef struct { uint64_t limb[5][8]; } fe_soa8; // packed form for batch inversion scratch
+#define FE8_MAC(lo, hi, a, b) do { (lo) = _mm512_madd52lo_epu64((lo), (a), (b)); (hi) = _mm512_madd52hi_epu64((hi), (a), (b)); } while (0)
+
+ME_TARGET_IFMA
+static inline __m512i fe8_mul19(__m512i x){
+	return _mm512_add_epi64(_mm512_add_epi64(_mm512_slli_epi64(x, 4), _mm512_slli_epi64(x, 1)), x);
+}
+ME_TARGET_IFMA
+static inline void fe8_load(fe8 *h, const fe_soa8 *f){
+	for (int i = 0; i < 5; ++i) h->v[i] = _mm512_loadu_si512((const void *)f->limb[i]);
+}
+ME_TARGET_IFMA
+static inline void fe8_store(fe_soa8 *h, const fe8 *f){
+	for (int i = 0; i < 5; ++i) _mm512_storeu_si512((void *)h->limb[i], f->v[i]);
+}
+ME_TARGET_IFMA
+static inline void fe8_set_small(fe8 *h, long long k){
+	h->v[0] = _mm512_set1_epi64(k);
+	for (int i = 1; i < 5; ++i) h->v[i] = _mm512_setzero_si512();
+}
+// One parallel carry round: limbs drop to 51 bits plus the incoming carry
+ME_TARGET_IFMA
+static inline void fe8_carry(fe8 *h, const __m512i r[5]){
+	const __m512i m51 = _mm512_set1_epi64((long long)FE51_MASK);
+	__m512i c0 = _mm512_srli_epi64(r[0], 51), c1 = _mm512_srli_epi64(r[1], 51), c2 = _mm512_srli_epi64(r[2], 51),
+		c3 = _mm512_srli_epi64(r[3], 51), c4 = _mm512_srli_epi64(r[4], 51);
+	h->v[0] = _mm512_add_epi64(_mm512_and_si512(r[0], m51), fe8_mul19(c4));
+	h->v[1] = _mm512_add_epi64(_mm512_and_si512(r[1], m51), c0);
+	h->v[2] = _mm512_add_epi64(_mm512_and_si512(r[2], m51), c1);
+	h->v[3] = _mm512_add_epi64(_mm512_and_si512(r[3], m51), c2);
+	h->v[4] = _mm512_add_epi64(_mm512_and_si512(r[4], m51), c3);
+}
+ME_TARGET_IFMA
+static inline void fe8_add(fe8 *h, const fe8 *f, const fe8 *g){
+	__m512i r[5];
+	for (int i = 0; i < 5; ++i) r[i] = _mm512_add_epi64(f->v[i], g->v[i]);
+	fe8_carry(h, r);
+}
+ME_TARGET_IFMA
+static inline void fe8_sub(fe8 *h, const fe8 *f, const fe8 *g){
+	// f + 2p - g; g limbs are at most 2^51 + 19, below every 2p limb
+	const __m512i p0 = _mm512_set1_epi64(0xFFFFFFFFFFFDALL), pi = _mm512_set1_epi64(0xFFFFFFFFFFFFELL);
+	__m512i r[5];
+	for (int i = 0; i < 5; ++i) r[i] = _mm512_sub_epi64(_mm512_add_epi64(f->v[i], i ? pi : p0), g->v[i]);
+	fe8_carry(h, r);
+}
+ME_TARGET_IFMA
+static inline void fe8_cswap(fe8 *f, fe8 *g, __mmask8 m){
+	for (int i = 0; i < 5; ++i) {
+		__m512i a = f->v[i], b = g->v[i];
+		f->v[i] = _mm512_mask_blend_epi64(m, a, b); g->v[i] = _mm512_mask_blend_epi64(m, b, a);
+	}
+}
+// Columns lo[k] (weight 2^51k) and hi[k] (weight 2 * 2^51(k+1)) -> five carried limbs
+ME_TARGET_IFMA
+static inline void fe8_reduce(fe8 *h, const __m512i lo[9], const __m512i hi[9]){
+	__m512i r[10];
+	r[0] = lo[0];
+	for (int k = 1; k < 9; ++k) r[k] = _mm512_add_epi64(lo[k], _mm512_add_epi64(hi[k - 1], hi[k - 1]));
+	r[9] = _mm512_add_epi64(hi[8], hi[8]);
+	for (int k = 0; k < 5; ++k) r[k] = _mm512_add_epi64(r[k], fe8_mul19(r[k + 5]));
+	fe8_carry(h, r);
+	fe8_carry(h, h->v);
+}
+ME_TARGET_IFMA
+static inline void fe8_mul(fe8 *h, const fe8 *f, const fe8 *g){
+	__m512i f0 = f->v[0], f1 = f->v[1], f2 = f->v[2], f3 = f->v[3], f4 = f->v[4];
+	__m512i g0 = g->v[0], g1 = g->v[1], g2 = g->v[2], g3 = g->v[3], g4 = g->v[4];
+	__m512i lo[9], hi[9];
+	for (int k = 0; k < 9; ++k) { lo[k] = _mm512_setzero_si512(); hi[k] = _mm512_setzero_si512(); }
+	FE8_MAC(lo[0], hi[0], f0, g0);
+	FE8_MAC(lo[1], hi[1], f0, g1); FE8_MAC(lo[1], hi[1], f1, g0);
+	FE8_MAC(lo[2], hi[2], f0, g2); FE8_MAC(lo[2], hi[2], f1, g1); FE8_MAC(lo[2], hi[2], f2, g0);
+	FE8_MAC(lo[3], hi[3], f0, g3); FE8_MAC(lo[3], hi[3], f1, g2); FE8_MAC(lo[3], hi[3], f2, g1);
+	FE8_MAC(lo[3], hi[3], f3, g0);
+	FE8_MAC(lo[4], hi[4], f0, g4); FE8_MAC(lo[4], hi[4], f1, g3); FE8_MAC(lo[4], hi[4], f2, g2);
+	FE8_MAC(lo[4], hi[4], f3, g1); FE8_MAC(lo[4], hi[4], f4, g0);
+	FE8_MAC(lo[5], hi[5], f1, g4); FE8_MAC(lo[5], hi[5], f2, g3); FE8_MAC(lo[5], hi[5], f3, g2);
+	FE8_MAC(lo[5], hi[5], f4, g1);
+	FE8_MAC(lo[6], hi[6], f2, g4); FE8_MAC(lo[6], hi[6], f3, g3); FE8_MAC(lo[6], hi[6], f4, g2);
+	FE8_MAC(lo[7], hi[7], f3, g4); FE8_MAC(lo[7], hi[7], f4, g3);
+	FE8_MAC(lo[8], hi[8], f4, g4);
+	fe8_reduce(h, lo, hi);
+}
+// Squaring: cross terms once, doubled, then the diagonal (15 products instead of 25)
+ME_TARGET_IFMA
+static inline void fe8_sq(fe8 *h, const fe8 *f){
+	__m512i f0 = f->v[0], f1 = f->v[1], f2 = f->v[2], f3 = f->v[3], f4 = f->v[4];
+	__m512i lo[9], hi[9];
+	for (int k = 0; k < 9; ++k) { lo[k] = _mm512_setzero_si512(); hi[k] = _mm512_setzero_si512(); }
+	FE8_MAC(lo[1], hi[1], f0, f1);
+	FE8_MAC(lo[2], hi[2], f0, f2);
+	FE8_MAC(lo[3], hi[3], f0, f3); FE8_MAC(lo[3], hi[3], f1, f2);
+	FE8_MAC(lo[4], hi[4], f0, f4); FE8_MAC(lo[4], hi[4], f1, f3);
+	FE8_MAC(lo[5], hi[5], f1, f4); FE8_MAC(lo[5], hi[5], f2, f3);
+	FE8_MAC(lo[6], hi[6], f2, f4);
+	FE8_MAC(lo[7], hi[7], f3, f4);
+	for (int k = 0; k < 9; ++k) { lo[k] = _mm512_add_epi64(lo[k], lo[k]); hi[k] = _mm512_add_epi64(hi[k], hi[k]); }
+	FE8_MAC(lo[0], hi[0], f0, f0);
+	FE8_MAC(lo[2], hi[2], f1, f1);
+	FE8_MAC(lo[4], hi[4], f2, f2);
+	FE8_MAC(lo[6], hi[6], f3, f3);
+	FE8_MAC(lo[8], hi[8], f4, f4);
+	fe8_reduce(h, lo, hi);
+}
+ME_TARGET_IFMA
+static inline void fe8_mul_small(fe8 *h, const fe8 *f, long long k){
+	const __m512i kv = _mm512_set1_epi64(k), z = _mm512_setzero_si512();
+	__m512i lo[5], hi[5], r[5];
+	for (int i = 0; i < 5; ++i) { lo[i] = _mm512_madd52lo_epu64(z, f->v[i], kv); hi[i] = _mm512_madd52hi_epu64(z, f->v[i], kv); }
+	r[0] = _mm512_add_epi64(lo[0], fe8_mul19(_mm512_add_epi64(hi[4], hi[4])));
+	for (int i = 1; i < 5; ++i) r[i] = _mm512_add_epi64(lo[i], _mm512_add_epi64(hi[i - 1], hi[i - 1]));
+	fe8_carry(h, r);
+}
+ME_TARGET_IFMA
+static inline void fe8_sqn(fe8 *h, const fe8 *f, int n){
+	fe8_sq(h, f);
+	for (int i = 1; i < n; ++i) fe8_sq(h, h);
+}
+
+// Per-lane z^(p-2), same addition chain as fe51_invert
+ME_TARGET_IFMA
+static void fe8_invert(fe8 *out, const fe8 *z){
+	fe8 t0, t1, t2, t3;
+	fe8_sq(&t0, z);
+	fe8_sqn(&t1, &t0, 2);
+	fe8_mul(&t1, &t1, z);
+	fe8_mul(&t0, &t0, &t1);
+	fe8_sq(&t2, &t0);
+	fe8_mul(&t1, &t1, &t2);
+	fe8_sqn(&t2, &t1, 5);
+	fe8_mul(&t1, &t2, &t1);
+	fe8_sqn(&t2, &t1, 10);
+	fe8_mul(&t2, &t2, &t1);
+	fe8_sqn(&t3, &t2, 20);
+	fe8_mul(&t2, &t3, &t2);
+	fe8_sqn(&t2, &t2, 10);
+	fe8_mul(&t1, &t2, &t1);
+	fe8_sqn(&t2, &t1, 50);
+	fe8_mul(&t2, &t2, &t1);
+	fe8_sqn(&t3, &t2, 100);
+	fe8_mul(&t2, &t3, &t2);
+	fe8_sqn(&t2, &t2, 50);
+	fe8_mul(&t2, &t2, &t1);
+	fe8_sqn(&t2, &t2, 5);
+	fe8_mul(out, &t2, &t0);
+}
+
+// Ladder on u=9 for the eight clamped secrets at sks (lane j = sks + 32*j); same step as ladder51_get_x2z2
+ME_TARGET_IFMA
+static void ladder8_ifma_get_x2z2(const unsigned char *sks, fe_soa8 *out_x2, fe_soa8 *out_z2){
+	fe8 x2, z2, x3, z3, a, aa, b, bb, e, c, d, da, cb, t;
+	fe8_set_small(&x2, 1); fe8_set_small(&z2, 0); fe8_set_small(&x3, 9); fe8_set_small(&z3, 1);
+	unsigned int swap = 0;
+	for (int pos = 254; pos >= 0; --pos) {
+		int byte = pos >> 3, sh = pos & 7;
+		unsigned int bits = 0;
+		for (int lane = 0; lane < 8; ++lane) bits |= (unsigned int)((sks[lane * 32 + byte] >> sh) & 1) << lane;
+		fe8_cswap(&x2, &x3, (__mmask8)(swap ^ bits)); fe8_cswap(&z2, &z3, (__mmask8)(swap ^ bits)); swap = bits;
+		fe8_add(&a, &x2, &z2); fe8_sq(&aa, &a);
+		fe8_sub(&b, &x2, &z2); fe8_sq(&bb, &b);
+		fe8_sub(&e, &aa, &bb);
+		fe8_add(&c, &x3, &z3); fe8_sub(&d, &x3, &z3);
+		fe8_mul(&da, &d, &a); fe8_mul(&cb, &c, &b);
+		fe8_add(&t, &da, &cb); fe8_sq(&x3, &t);
+		fe8_sub(&t, &da, &cb); fe8_sq(&t, &t); fe8_mul_small(&z3, &t, 9);
+		fe8_mul(&x2, &aa, &bb);
+		fe8_mul_small(&t, &e, 121665); fe8_add(&t, &aa, &t); fe8_mul(&z2, &e, &t);
+	}
+	fe8_cswap(&x2, &x3, (__mmask8)swap); fe8_cswap(&z2, &z3, (__mmask8)swap);
+	fe8_store(out_x2, &x2); fe8_store(out_z2, &z2);
+}
+
+// Lane-parallel batch inversion over n vectors (8n field elements, one fe8_invert).
+// out[i] holds the running prefix product first, then 1/in[i]; out must not alias in.
+ME_TARGET_IFMA
+static void fe8_batch_invert_ifma(fe_soa8 *out, const fe_soa8 *in, int n){
+	if (n <= 0) return;
+	fe8 acc, x, inv, t;
+	fe8_set_small(&acc, 1);
+	for (int i = 0; i < n; ++i) { fe8_store(&out[i], &acc); fe8_load(&x, &in[i]); fe8_mul(&acc, &acc, &x); }
+	fe8_invert(&inv, &acc);
+	for (int i = n - 1; i >= 0; --i) {
+		fe8_load(&t, &out[i]); fe8_mul(&t, &inv, &t);
+		fe8_load(&x, &in[i]); fe8_mul(&inv, &inv, &x);
+		fe8_store(&out[i], &t);
+	}
+}
+
+// Public keys for 8*n8 clamped secrets: n8 eight-lane ladders, one lane-parallel inversion, then
+// x = X2 * Zinv per vector and per-lane serialization through fe51_tobytes (same limb grid).
+ME_TARGET_IFMA
+static void x25519_base_batch_ifma(const unsigned char *sks, int n8, unsigned char *pubs, fe_soa8 *X2, fe_soa8 *Z2, fe_soa8 *Zinv){
+	for (int i = 0; i < n8; ++i) ladder8_ifma_get_x2z2(sks + (size_t)i * 256, &X2[i], &Z2[i]);
+	PROF_LAP(PROF_LADDER);
+	fe8_batch_invert_ifma(Zinv, Z2, n8);
+	PROF_LAP(PROF_INVERT);
+	for (int i = 0; i < n8; ++i) {
+		fe8 x, zi; fe_soa8 xs;
+		fe8_load(&x, &X2[i]); fe8_load(&zi, &Zinv[i]); fe8_mul(&x, &x, &zi); fe8_store(&xs, &x);
+		for (int lane = 0; lane < 8; ++lane) {
+			fe51 h;
+			for (int k = 0; k < 5; ++k) h.v[k] = xs.limb[k][lane];
+			fe51_tobytes(pubs + ((size_t)i * 8 + (size_t)lane) * 32, &h);
+		}
+	}
+	PROF_LAP(PROF_FINISH);
+}
+#endif
+
+// Reference public key through OpenSSL EVP (used to re-derive secrets produced by internal walks)
+static int x25519_pub_openssl(unsigned char out[32], const unsigned char priv[32]){
+	EVP_PKEY *pkey = EVP_PKEY_new_raw_private_key(EVP_PKEY_X25519, NULL, priv, 32);
+	if (!pkey) return 0;
+	size_t len = 32;
+	int ok = EVP_PKEY_get_raw_public_key(pkey, out, &len) > 0 && len == 32;
+	EVP_PKEY_free(pkey);
+	return ok;
+}
+
+// --- Incremental-scalar walk: k, k+8, k+16, ... from one random clamped start ---
+// Consecutive walk points differ by Q = 8*B, so x((k+8(i+1))B) follows from x((k+8i)B), x(Q) and
+// x((k+8(i-1))B) with one x-only differential addition (4M+2S) instead of a 255-step ladder.
+// A step of 8 keeps the low three bits clear, and walks are bounded so bit 254 stays set and
+// bit 255 stays clear: every scalar on the walk is a valid clamped X25519 secret.
+#define INCR_WALK_MAX_STEPS (1ULL << 32)
+#define INCR_DEFAULT_BATCH 256
+static fe51 g_walk_q_p1; // x(8B) + 1
+static fe51 g_walk_q_m1; // x(8B) - 1
+
+struct incr_walk {
+	unsigned char k0[32];    // clamped start scalar
+	unsigned long long step; // index of the next key to emit (secret = k0 + 8*step)
+	fe51 xp, zp;             // (k0 + 8*(step-1)) * B, projective
+	fe51 xc, zc;             // (k0 + 8*step) * B, projective
+};
+
+// 256-bit little-endian scalar plus/minus a small value
+static void scalar_add_u64(unsigned char out[32], const unsigned char k[32], unsigned long long v){
+	unsigned int carry = 0;
+	for (int i = 0; i < 32; ++i) {
+		unsigned int t = (unsigned int)k[i] + (unsigned int)(v & 0xFFu) + carry;
+		out[i] = (unsigned char)t; carry = t >> 8; v >>= 8;
+	}
+}
+static void scalar_sub_u64(unsigned char out[32], const unsigned char k[32], unsigned long long v){
+	int borrow = 0;
+	for (int i = 0; i < 32; ++i) {
+		int t = (int)k[i] - (int)(v & 0xFFu) - borrow;
+		borrow = t < 0; out[i] = (unsigned char)(t + (borrow ? 256 : 0)); v >>= 8;
+	}
+}
+
+// Precompute x(8B) once; the walk only needs x(Q)+1 and x(Q)-1
+static void walk_init_step_point(void){
+	unsigned char eight[32] = { 8 };
+	fe51 x, z, zi, q, one;
+	ladder51_get_x2z2(eight, &x, &z);
+	fe51_invert(&zi, &z); fe51_mul(&q, &x, &zi);
+	fe51_1(&one); fe51_add(&g_walk_q_p1, &q, &one); fe51_sub(&g_walk_q_m1, &q, &one);
+	fe51_mul_small(&g_walk_q_m1, &g_walk_q_m1, 1); // carry so fe51_mul sees reduced limbs
+}
+
+// Start a walk from 32 random bytes, positioned at step (0 for a fresh walk, the saved step on
+// --resume). Returns 0 if the walk would leave the clamped range (k0 + 8*INCR_WALK_MAX_STEPS >= 2^255);
+// the caller then draws a new start.
+static int walk_start(struct incr_walk *w, const unsigned char rnd[32], unsigned long long step){
+	unsigned char end[32], cur[32], prev[32];
+	memcpy(w->k0, rnd, 32);
+	w->k0[0] &= 248; w->k0[31] &= 127; w->k0[31] |= 64;
+	scalar_add_u64(end, w->k0, 8ULL * INCR_WALK_MAX_STEPS);
+	if (end[31] & 0x80) return 0;
+	scalar_add_u64(cur, w->k0, 8ULL * step);
+	scalar_sub_u64(prev, cur, 8ULL);
+	g_fe51_x2z2(prev, &w->xp, &w->zp);
+	g_fe51_x2z2(cur, &w->xc, &w->zc);
+	w->step = step;
+	return 1;
+}
+
+static inline void walk_secret(const struct incr_walk *w, unsigned long long idx, unsigned char out[32]){
+	scalar_add_u64(out, w->k0, 8ULL * idx);
+}
+
+// Emit n consecutive walk points as projective (X, Z) and advance the walk.
+// Differential addition: x(P+Q) = Z(P-Q) * [U+V]^2 / X(P-Q) * [U-V]^2 with
+// U = (X_P - Z_P)(x_Q + 1), V = (X_P + Z_P)(x_Q - 1).
+static void walk_fill(struct incr_walk *w, fe51 *X, fe51 *Z, int n){
+	for (int i = 0; i < n; ++i) {
+		fe51 t0, t1, u, v, xn, zn;
+		X[i] = w->xc; Z[i] = w->zc;
+		fe51_sub(&t0, &w->xc, &w->zc); fe51_mul(&u, &t0, &g_walk_q_p1);
+		fe51_add(&t1, &w->xc, &w->zc); fe51_mul(&v, &t1, &g_walk_q_m1);
+		fe51_add(&t0, &u, &v); fe51_sq(&t0, &t0); fe51_mul(&xn, &t0, &w->zp);
+		fe51_sub(&t1, &u, &v); fe51_sq(&t1, &t1); fe51_mul(&zn, &t1, &w->xp);
+		w->xp = w->xc; w->zp = w->zc;
+		w->xc = xn; w->zc = zn;
+	}
+	w->step += (unsigned long long)n;
+}
+
+
+// CPU-only RFC 7748 self-test (MEKG_TEST_RFC=1): Alice/Bob basepoint vectors through the fe51 ladder,
+// the fixed-base comb and the fe ladder on the selected g_fe_mul backend, then random clamped secrets
+// through the fe51 batch path (ladder and comb), the SIMD ladders and the incremental walk against OpenSSL.
+// Returns 0 on success, 6 on mismatch.
+static int cpu_selftest_rfc(void){
+	static const unsigned char vec_sk[2][32] = {
+		{ 0x77,0x07,0x6d,0x0a,0x73,0x18,0xa5,0x7d,0x3c,0x16,0xc1,0x72,0x51,0xb2,0x66,0x45,
+		  0xdf,0x4c,0x2f,0x87,0xeb,0xc0,0x99,0x2a,0xb1,0x77,0xfb,0xa5,0x1d,0xb9,0x2c,0x2a },
+		{ 0x5d,0xab,0x08,0x7e,0x62,0x4a,0x8a,0x4b,0x79,0xe1,0x7f,0x8b,0x83,0x80,0x0e,0xe6,
+		  0x6f,0x3b,0xb1,0x29,0x26,0x18,0xb6,0xfd,0x1c,0x2f,0x8b,0x27,0xff,0x88,0xe0,0xeb } };
+	static const unsigned char vec_pk[2][32] = {
+		{ 0x85,0x20,0xf0,0x09,0x89,0x30,0xa7,0x54,0x74,0x8b,0x7d,0xdc,0xb4,0x3e,0xf7,0x5a,
+		  0x0d,0xbf,0x3a,0x0d,0x26,0x38,0x1a,0xf4,0xeb,0xa4,0xa9,0x8e,0xaa,0x9b,0x4e,0x6a },
+		{ 0xde,0x9e,0xdb,0x7d,0x7b,0x7d,0xc1,0xb4,0xd3,0x5b,0x61,0xc2,0xec,0xe4,0x35,0x37,
+		  0x3f,0x83,0x43,0xc8,0x5b,0x78,0x67,0x4d,0xad,0xfc,0x7e,0x14,0x6f,0x88,0x2b,0x4f } };
+	enum { N = 64 };
+	unsigned char sks[N * 32], pubs[N * 32], ref[32];
+	fe51 X2[N], Z2[N], Zi[N];
+	int bad = 0;
+	void (*sel_x2z2)(const unsigned char sk[32], fe51 *x2, fe51 *z2) = g_fe51_x2z2;
+	g_fe51_x2z2 = ladder51_get_x2z2;
+	if (!fixedbase_init()) { fprintf(stderr, "Fixed-base table init failed\n"); return 6; }
+	// Non-canonical input p + 3 must serialize as 3
+	{
+		unsigned char in[32], out[32], exp[32] = { 3 }; fe51 t;
+		memset(in, 0xff, 32); in[0] = 0xf0; in[31] = 0x7f;
+		fe51_frombytes(&t, in); fe51_tobytes(out, &t);
+		if (memcmp(out, exp, 32) != 0) { fprintf(stderr, "fe51_tobytes: p + 3 not reduced\n"); bad = 1; }
+	}
+	for (int v = 0; v < 2; ++v) {
+		unsigned char sk[32], out51[32], outfe[32];
+		memcpy(sk, vec_sk[v], 32); sk[0] &= 248; sk[31] &= 127; sk[31] |= 64;
+		unsigned char outfb[32]; fe51 fx, fz;
+		x25519_basepoint_mul_fe51(sk, out51);
+		x25519_basepoint_mul_cpu(sk, outfe);
+		fixedbase_get_x2z2(sk, &fx, &fz); fe51_invert(&fz, &fz); fe51_mul(&fx, &fx, &fz); fe51_tobytes(outfb, &fx);
+		int ok51 = memcmp(out51, vec_pk[v], 32) == 0, okfe = memcmp(outfe, vec_pk[v], 32) == 0;
+		int okfb = memcmp(outfb, vec_pk[v], 32) == 0;
+		fprintf(stderr, "RFC %s fe51: %s  fixedbase: %s  fe ladder: %s\n", v ? "Bob  " : "Alice",
+			ok51 ? "OK" : "BAD", okfb ? "OK" : "BAD", okfe ? "OK" : "BAD");
+		if (!ok51 || !okfe || !okfb) bad = 1;
+		memcpy(sks + (size_t)v * 32, sk, 32);
+	}
+	if (RAND_bytes(sks + 64, (N - 2) * 32) != 1) { fprintf(stderr, "RAND_bytes failed\n"); return 6; }
+	for (int i = 2; i < N; ++i) { unsigned char *sk = sks + (size_t)i * 32; sk[0] &= 248; sk[31] &= 127; sk[31] |= 64; }
+	x25519_base_batch_fe51(sks, N, pubs, X2, Z2, Zi);
+	int batch_bad = 0;
+	for (int i = 0; i < N; ++i) {
+		if (!x25519_pub_openssl(ref, sks + (size_t)i * 32) || memcmp(ref, pubs + (size_t)i * 32, 32) != 0) batch_bad++;
+	}
+	fprintf(stderr, "fe51 batch vs OpenSSL: %d/%d OK\n", N - batch_bad, N);
+	{
+		unsigned char pubs_fb[N * 32];
+		int fb_bad = 0;
+		g_fe51_x2z2 = fixedbase_get_x2z2;
+		x25519_base_batch_fe51(sks, N, pubs_fb, X2, Z2, Zi);
+		g_fe51_x2z2 = ladder51_get_x2z2;
+		for (int i = 0; i < N; ++i) if (memcmp(pubs_fb + (size_t)i * 32, pubs + (size_t)i * 32, 32) != 0) fb_bad++;
+		fprintf(stderr, "Fixed-base batch vs fe51: %d/%d OK\n", N - fb_bad, N);
+		batch_bad += fb_bad;
+	}
+#if defined(__x86_64__) || defined(__i386__)
+	if (g_has_avx2) {
+		// Same secrets (RFC vectors in lanes 0 and 1) through the 4-lane AVX2 ladder
+		fe_soa4 X4[N / 4], Z4[N / 4], Zi4[N / 4];
+		unsigned char pubs4[N * 32];
+		x25519_base_batch_avx2(sks, N / 4, pubs4, X4, Z4, Zi4);
+		int avx2_bad = 0;
+		for (int i = 0; i < N; ++i) if (memcmp(pubs4 + (size_t)i * 32, pubs + (size_t)i * 32, 32) != 0) avx2_bad++;
+		if (memcmp(pubs4, vec_pk[0], 32) != 0 || memcmp(pubs4 + 32, vec_pk[1], 32) != 0) avx2_bad++;
+		fprintf(stderr, "AVX2 4-lane batch vs fe51: %d/%d OK\n", N - avx2_bad, N);
+		batch_bad += avx2_bad;
+	}
+	if (g_has_avx512f && g_has_avx512ifma) {
+		// Same secrets through the 8-lane IFMA ladder
+		fe_soa8 X8[N / 8], Z8[N / 8], Zi8[N / 8];
+		unsigned char pubs8[N * 32];
+		x25519_base_batch_ifma(sks, N / 8, pubs8, X8, Z8, Zi8);
+		int ifma_bad = 0;
+		for (int i = 0; i < N; ++i) if (memcmp(pubs8 + (size_t)i * 32, pubs + (size_t)i * 32, 32) != 0) ifma_bad++;
+		if (memcmp(pubs8, vec_pk[0], 32) != 0 || memcmp(pubs8 + 32, vec_pk[1], 32) != 0) ifma_bad++;
+		fprintf(stderr, "IFMA 8-lane batch vs fe51: %d/%d OK\n", N - ifma_bad, N);
+		batch_bad += ifma_bad;
+	}
+#endif
+	// Incremental walk: N consecutive points from a random start
+	struct incr_walk w; unsigned char rnd[32];
+	walk_init_step_point();
+	int walk_bad = 0;
+	do { if (RAND_bytes(rnd, 32) != 1) { fprintf(stderr, "RAND_bytes failed\n"); return 6; } } while (!walk_start(&w, rnd, 0));
+	walk_fill(&w, X2, Z2, N);
+	fe51_batch_invert(Zi, Z2, N);
+	for (int i = 0; i < N; ++i) {
+		unsigned char sk[32], pk[32]; fe51 x;
+		fe51_mul(&x, &X2[i], &Zi[i]); fe51_tobytes(pk, &x);
+		walk_secret(&w, (unsigned long long)i, sk);
+		if (!x25519_pub_openssl(ref, sk) || memcmp(ref, pk, 32) != 0) walk_bad++;
+	}
+	// A walk resumed mid-way must continue with the same points
+	if (walk_start(&w, rnd, N / 2)) {
+		fe51 rx[2], rz[2];
+		walk_fill(&w, rx, rz, 2);
+		for (int i = 0; i < 2; ++i) {
+			fe51 a, b, zi;
+			fe51_mul(&a, &X2[N / 2 + i], &Zi[N / 2 + i]);
+			fe51_invert(&zi, &rz[i]); fe51_mul(&b, &rx[i], &zi);
+			unsigned char ab[32], bb[32]; fe51_tobytes(ab, &a); fe51_tobytes(bb, &b);
+			if (memcmp(ab, bb, 32) != 0) walk_bad++;
+		}
+	} else walk_bad++;
+	fprintf(stderr, "Incremental walk vs OpenSSL: %d/%d OK\n", N - walk_bad, N);
+	g_fe51_x2z2 = sel_x2z2;
+	return (bad || batch_bad || walk_bad) ? 6 : 0;
+}
 
 // Normalize fe to ref10 carry form and build BIGNUM directly from limbs
 #ifdef ME_KEYGEN_OPENCL
@@ -955,22 +2186,143 @@ static BIGNUM* BN_from_fe_limbs(const fe *h){
 }
 #endif
 
+static void top_print(int final); // --top leaderboards, defined with the CPU pipeline
+
+static void checkpoint_tick(void); // --checkpoint, defined with the CPU pipeline
+
+#ifdef ME_KEYGEN_PROFILE
+// Stage totals over the worker slots into t[] and their key count
+static unsigned long long prof_collect(unsigned long long t[PROF_NSTAGES]) {
+	unsigned long long keys = 0;
+	memset(t, 0, sizeof(unsigned long long) * PROF_NSTAGES);
+	for (int i = 0; g_stats && i < g_num_threads; ++i) {
+		keys += atomic_load_explicit(&g_stats[i].keys, memory_order_relaxed);
+		for (int j = 0; j < PROF_NSTAGES; ++j) t[j] += atomic_load_explicit(&g_stats[i].prof[j], memory_order_relaxed);
+	}
+	return keys;
+}
+
+// "Stages: rng 1.2% ladder 80.1% ... | 41.0K cycles/key" for the given deltas
+static void prof_print(const char *label, const unsigned long long d[PROF_NSTAGES], unsigned long long keys) {
+	unsigned long long sum = 0;
+	for (int j = 0; j < PROF_NSTAGES; ++j) sum += d[j];
+	if (!sum || !keys) return;
+	char line[256], per_key[32];
+	int n = snprintf(line, sizeof line, "%s:", label);
+	for (int j = 0; j < PROF_NSTAGES; ++j) n += snprintf(line + n, sizeof line - (size_t)n, " %s %.1f%%", g_prof_names[j], 100.0 * (double)d[j] / (double)sum);
+	human_readable_ull(sum / keys, per_key, sizeof per_key);
+	fprintf(stderr, "%s | %s %s/key per thread\n", line, per_key, PROF_UNIT);
+}
+
+// At exit: the split for the whole run
+static void prof_summary(void) {
+	unsigned long long t[PROF_NSTAGES];
+	unsigned long long keys = prof_collect(t);
+	prof_print("Stages (run)", t, keys);
+}
+#endif
+
+// Every --report-interval seconds: total and rate on stderr. With several workers the line adds the
+// spread of per-thread and per-CPU rates, so a throttled or oversubscribed core shows up as the min;
+// --report-detail follows it with every thread's and CPU's rate. Rates divide by the measured
+// interval. The sleep is sliced so a stop is noticed quickly and checkpoints keep their own cadence.
 static void *reporter(void *arg) {
 	(void)arg;
-	unsigned long long last = 0;
-	while (!atomic_load(&g_stop)) {
-		sleep(5);
-		unsigned long long total = atomic_load_explicit(&g_key_count, memory_order_relaxed);
-		unsigned long long delta = total - last;
-		last = total;
-		char total_str[32];
-		char rate_str[32];
+	int nt = g_stats ? g_num_threads : 0;
+	int ncpu = (int)sysconf(_SC_NPROCESSORS_CONF);
+	if (ncpu < 1) ncpu = 1;
+	unsigned long long *last_t = (unsigned long long *)calloc((size_t)nt + 1, sizeof *last_t);
+	double *thr_rate = (double *)calloc((size_t)nt + 1, sizeof *thr_rate);
+	double *cpu_rate = (double *)calloc((size_t)ncpu, sizeof *cpu_rate);
+	unsigned char *cpu_used = (unsigned char *)calloc((size_t)ncpu, 1);
+	if (!last_t || !thr_rate || !cpu_rate || !cpu_used) nt = 0; // totals only
+	unsigned long long last = keys_total();
+	for (int i = 0; i < nt; ++i) last_t[i] = atomic_load_explicit(&g_stats[i].keys, memory_order_relaxed);
+#ifdef ME_KEYGEN_PROFILE
+	unsigned long long prof_last[PROF_NSTAGES], prof_keys = prof_collect(prof_last);
+#endif
+	struct timespec prev, now;
+	clock_gettime(CLOCK_MONOTONIC, &prev);
+	while (!atomic_load(&g_stop.flag)) {
+		struct timespec slice = {0, 100 * 1000000L};
+		nanosleep(&slice, NULL);
+		if (g_checkpoint_path) checkpoint_tick();
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		double dt = (double)(now.tv_sec - prev.tv_sec) + (double)(now.tv_nsec - prev.tv_nsec) / 1e9;
+		if (dt < g_report_sec) continue;
+		prev = now;
+		if (g_quiet) continue; // started only for checkpoints
+		unsigned long long total = keys_total();
+		char total_str[32], rate_str[32], line[512];
 		human_readable_ull(total, total_str, sizeof total_str);
-		unsigned long long per_sec = delta / 5ULL;
-		human_readable_ull(per_sec, rate_str, sizeof rate_str);
-	fprintf(stderr, "Keys: total=%s, %s/s\n", total_str, rate_str);
-	fflush(stderr);
+		human_readable_ull((unsigned long long)((double)(total - last) / dt), rate_str, sizeof rate_str);
+		last = total;
+		int len = snprintf(line, sizeof line, "Keys: total=%s, %s/s", total_str, rate_str);
+		int nrun = 0; // workers that have run a batch (none for the coordinator, GPU or an idle --serve)
+		if (nt > 1) {
+			char a[32], b[32];
+			double tmin = 0, tmax = 0, cmin = 0, cmax = 0;
+			int imin = -1, imax = -1, jmin = -1, jmax = -1, ncores = 0;
+			memset(cpu_rate, 0, sizeof(double) * (size_t)ncpu);
+			memset(cpu_used, 0, (size_t)ncpu);
+			for (int i = 0; i < nt; ++i) {
+				unsigned long long k = atomic_load_explicit(&g_stats[i].keys, memory_order_relaxed);
+				double r = thr_rate[i] = (double)(k - last_t[i]) / dt;
+				last_t[i] = k;
+				int c = atomic_load_explicit(&g_stats[i].cpu, memory_order_relaxed);
+				if (c < 0) continue;
+				nrun++;
+				if (imin < 0 || r < tmin) { tmin = r; imin = i; }
+				if (imax < 0 || r > tmax) { tmax = r; imax = i; }
+				if (c < ncpu) { cpu_rate[c] += r; cpu_used[c] = 1; }
+			}
+			for (int c = 0; c < ncpu; ++c) {
+				if (!cpu_used[c]) continue;
+				if (jmin < 0 || cpu_rate[c] < cmin) { cmin = cpu_rate[c]; jmin = c; }
+				if (jmax < 0 || cpu_rate[c] > cmax) { cmax = cpu_rate[c]; jmax = c; }
+				ncores++;
+			}
+			human_readable_ull((unsigned long long)tmin, a, sizeof a);
+			human_readable_ull((unsigned long long)tmax, b, sizeof b);
+			if (nrun > 1) len += snprintf(line + len, sizeof line - (size_t)len, " | thread min %s/s (t%d) max %s/s (t%d)", a, imin, b, imax);
+			if (ncores > 1) {
+				human_readable_ull((unsigned long long)cmin, a, sizeof a);
+				human_readable_ull((unsigned long long)cmax, b, sizeof b);
+				snprintf(line + len, sizeof line - (size_t)len, " | cpu min %s/s (cpu%d) max %s/s (cpu%d)", a, jmin, b, jmax);
+			}
+		}
+		fprintf(stderr, "%s\n", line);
+		if (g_report_detail && nrun > 1) {
+			char r[32];
+			fprintf(stderr, "  threads:");
+			for (int i = 0; i < nt; ++i) {
+				human_readable_ull((unsigned long long)thr_rate[i], r, sizeof r);
+				fprintf(stderr, " t%d=%s", i, r);
+			}
+			fprintf(stderr, "\n  cpus:");
+			for (int c = 0; c < ncpu; ++c) {
+				if (!cpu_used[c]) continue;
+				human_readable_ull((unsigned long long)cpu_rate[c], r, sizeof r);
+				fprintf(stderr, " cpu%d=%s", c, r);
+			}
+			fprintf(stderr, "\n");
+		}
+#ifdef ME_KEYGEN_PROFILE
+		{
+			unsigned long long cur[PROF_NSTAGES], d[PROF_NSTAGES];
+			unsigned long long k = prof_collect(cur);
+			for (int j = 0; j < PROF_NSTAGES; ++j) { d[j] = cur[j] - prof_last[j]; prof_last[j] = cur[j]; }
+			prof_print("  stages", d, k - prof_keys);
+			prof_keys = k;
+		}
+#endif
+		fflush(stderr);
+		if (g_top_k) top_print(0);
 	}
+	free(last_t);
+	free(thr_rate);
+	free(cpu_rate);
+	free(cpu_used);
 	return NULL;
 }
 
@@ -1000,6 +2352,43 @@ static void build_core_order_if_needed(void){
 #endif
 }
 
+// --cpu-autotune without SMT siblings: reorder g_core_order (identity unless MEKG_PIN_PCORES built it) so
+// the first hardware thread of every core comes first. Returns that count, or 0 when the topology
+// is unknown; pinning the first N workers through g_core_order then puts one on each core.
+static int core_order_primary_first(void){
+#ifdef __linux__
+	int ncpu = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if (ncpu <= 0) return 0;
+	if (!g_core_order || g_core_order_count != ncpu) {
+		int *idx = (int*)malloc((size_t)ncpu * sizeof(int));
+		if (!idx) return 0;
+		for (int i=0;i<ncpu;++i) idx[i]=i;
+		free(g_core_order);
+		g_core_order = idx; g_core_order_count = ncpu;
+	}
+	int *tmp = (int*)malloc((size_t)ncpu * sizeof(int));
+	if (!tmp) return 0;
+	int np = 0, ns = 0;
+	char path[256];
+	for (int pass=0; pass<2; ++pass) {
+		for (int i=0;i<ncpu;++i){
+			int cpu = g_core_order[i], first = -1;
+			snprintf(path, sizeof path, "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+			FILE *f = fopen(path, "r");
+			if (f) { if (fscanf(f, "%d", &first) != 1) first = -1; fclose(f); }
+			if (first < 0) { free(tmp); return 0; }
+			if (pass == 0 && first == cpu) tmp[np++] = cpu;
+			else if (pass == 1 && first != cpu) tmp[np + ns++] = cpu;
+		}
+	}
+	memcpy(g_core_order, tmp, (size_t)ncpu * sizeof(int));
+	free(tmp);
+	return np;
+#else
+	return 0;
+#endif
+}
+
 // Fast fixed-size Base64 for 32-byte input. Produces 44 chars + NUL.
 static inline void base64_encode_32(const unsigned char in[32], char out[45]) {
 	static const char B64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
@@ -1074,347 +2463,2919 @@ static inline void chacha20_next(chacha20_ctx *ctx, uint8_t *out, size_t outlen)
 		uint8_t block[64]; chacha20_block(ctx, block);
 		size_t n = outlen < 64 ? outlen : 64;
 		memcpy(out, block, n);
-		out += n; outlen -= n; ctx->state[12] += 1; // counter++
+		out += n; outlen -= n;
+		if (++ctx->state[12] == 0) ctx->state[13] += 1; // 64-bit block counter (words 12..13)
 	}
 }
 
-void *generate_keys(void *arg) {
-	// Optional: pin thread to a CPU for better cache locality
-	long tid = (long)(intptr_t)arg;
-#ifdef __linux__
-	if (g_affinity) {
-		int ncpu = (int)sysconf(_SC_NPROCESSORS_ONLN);
-		if (ncpu > 0) {
-			cpu_set_t set;
-			CPU_ZERO(&set);
-			if (g_pin_pcores && g_core_order && g_core_order_count==ncpu) {
-				int cpu = g_core_order[(int)(tid % ncpu)];
-				CPU_SET((unsigned)cpu, &set);
-			} else {
-				CPU_SET((unsigned)(tid % ncpu), &set);
-			}
-			(void)pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
-		}
+// --seed S: the stream key is S (8 bytes, little-endian) followed by a fixed label
+static void seed_key_from_u64(unsigned long long seed, uint8_t key[32]) {
+	static const uint8_t label[32] = "\0\0\0\0\0\0\0\0meshtastic_keygen/seed";
+	memcpy(key, label, 32);
+	for (int i = 0; i < 8; ++i) key[i] = (uint8_t)(seed >> (8 * i));
+}
+
+// Seeded streams without --seed (--checkpoint): a full 256-bit key from the OS RNG, kept in the
+// checkpoint file instead of a printable S
+static int seed_key_random(void) {
+	if (RAND_bytes(g_seed_key, sizeof g_seed_key) != 1) { fprintf(stderr, "RAND_bytes failed\n"); return -1; }
+	g_seeded = 1;
+	g_seed_random = 1;
+	return 0;
+}
+
+static void hex_encode_32(const uint8_t in[32], char out[65]) {
+	static const char hex[] = "0123456789abcdef";
+	for (int i = 0; i < 32; ++i) { out[2 * i] = hex[in[i] >> 4]; out[2 * i + 1] = hex[in[i] & 0xF]; }
+	out[64] = '\0';
+}
+
+// 64 hex digits -> 32 bytes; -1 on anything else
+static int hex_decode_32(const char *in, uint8_t out[32]) {
+	for (int i = 0; i < 64; ++i) {
+		int c = in[i], v = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+		if (v < 0) return -1;
+		if (i & 1) out[i / 2] = (uint8_t)(out[i / 2] | v); else out[i / 2] = (uint8_t)(v << 4);
 	}
-#endif
+	return in[64] == '\0' || in[64] == '\n' ? 0 : -1;
+}
 
-	unsigned char pub_key[32];
-	char b64_pub[BASE64_LEN + 1];  // 44 + 1
-	char b64_priv[BASE64_LEN + 1]; // 44 + 1
-	unsigned long long local_cnt = 0;
+// Seeded streams: thread t's secret stream is ChaCha20 under g_seed_key, nonce = thread, starting at
+// the given 64-bit block; key index i (32 bytes each) lives in block i/2, so any key is a pure
+// function of (key, thread, index)
+static void seed_stream_init(chacha20_ctx *ctx, const uint8_t key[32], uint32_t thread, unsigned long long block) {
+	uint8_t nonce[12] = {0};
+	for (int i = 0; i < 4; ++i) {
+		nonce[i] = (uint8_t)(block >> (32 + 8 * i)); // high counter word
+		nonce[4 + i] = (uint8_t)(thread >> (8 * i));
+	}
+	chacha20_init(ctx, key, nonce, (uint32_t)block);
+}
 
-	// Reusable per-thread buffers for optional batch inversion path
-	fe *batch_X2 = NULL, *batch_Z2 = NULL, *batch_Zinv = NULL;
-	int batch_cap = 0;
+// Raw (unclamped) 32 stream bytes at key index idx
+static void seed_stream_key(const uint8_t key[32], uint32_t thread, unsigned long long idx, unsigned char out[32]) {
+	chacha20_ctx c;
+	uint8_t block[64];
+	seed_stream_init(&c, key, thread, idx / 2);
+	chacha20_block(&c, block);
+	memcpy(out, block + (idx & 1) * 32, 32);
+}
 
-	// Per-thread DRBG to avoid RAND_bytes in the hot loop
-	enum { RAND_KEYS_BATCH = 4096 };
-	unsigned char rand_buf[RAND_KEYS_BATCH * 32];
-	size_t rand_off = RAND_KEYS_BATCH * 32; // force initial refill
-	chacha20_ctx drbg; unsigned char seed_key[32], seed_nonce[12];
-	if (RAND_bytes(seed_key, sizeof seed_key) != 1 || RAND_bytes(seed_nonce, sizeof seed_nonce) != 1) {
-		// Fallback: zero seed; still functional but lower entropy (unlikely path)
-		memset(seed_key, 0, sizeof seed_key);
-		memset(seed_nonce, 0, sizeof seed_nonce);
-	}
-	chacha20_init(&drbg, seed_key, seed_nonce, 1u);
-
-	while (!atomic_load_explicit(&g_stop, memory_order_relaxed)) {
-		// Generate random private key bytes (buffered)
-		if (rand_off >= sizeof(rand_buf)) {
-			chacha20_next(&drbg, rand_buf, sizeof(rand_buf));
-			rand_off = 0;
-		}
-
-		// Experimental: small multi-lane (2 or 4) internal ladder + single inversion
-		if (g_use_internal && g_avx2_multi_lanes >= 2) {
-			int N = g_avx2_multi_lanes;
-			size_t need = (size_t)N * 32;
-			size_t remain = sizeof(rand_buf) - rand_off;
-			if (remain < need) { chacha20_next(&drbg, rand_buf, sizeof(rand_buf)); rand_off = 0; }
-			unsigned char *privs = rand_buf + rand_off;
-			// Ensure reusable buffers are large enough
-			if (batch_cap < N) {
-				fe *newX2 = (fe *)realloc(batch_X2, (size_t)N * sizeof(fe));
-				fe *newZ2 = (fe *)realloc(batch_Z2, (size_t)N * sizeof(fe));
-				fe *newZi = (fe *)realloc(batch_Zinv, (size_t)N * sizeof(fe));
-				if (!newX2 || !newZ2 || !newZi) {
-					if (newX2) batch_X2 = newX2;
-					if (newZ2) batch_Z2 = newZ2;
-					if (newZi) batch_Zinv = newZi;
-					break; // allocation failure; exit thread
-				}
-				batch_X2 = newX2; batch_Z2 = newZ2; batch_Zinv = newZi; batch_cap = N;
-			}
-			for (int i = 0; i < N; ++i) {
-				unsigned char *sk = privs + (size_t)i * 32;
-				// Clamp per RFC 7748
-				sk[0] &= 248; sk[31] &= 127; sk[31] |= 64;
-				ladder_get_x2z2(sk, &batch_X2[i], &batch_Z2[i]);
-			}
-			fe_batch_invert(batch_Zinv, batch_Z2, N);
-			for (int i = 0; i < N; ++i) {
-				unsigned char *sk = privs + (size_t)i * 32;
-				fe X; fem(&X, &batch_X2[i], &batch_Zinv[i]);
-				fetobytes(pub_key, &X);
-				// Quick prefilter
-				int likely_match = (g_patterns_count == 0);
-				if (!likely_match) {
-					unsigned char b0 = pub_key[0], b1 = pub_key[1], b2 = pub_key[2];
-					unsigned char p0 = (b0 >> 2) & 0x3F;
-					unsigned char p1 = ((b0 & 0x3) << 4) | (b1 >> 4); p1 &= 0x3F;
-					unsigned char p2 = ((b1 & 0xF) << 2) | (b2 >> 6); p2 &= 0x3F;
-					unsigned char p3 = b2 & 0x3F;
-					unsigned char e30 = pub_key[30], e31 = pub_key[31];
-					unsigned char s41 = (e30 >> 2) & 0x3F;
-					unsigned char s42 = ((e30 & 0x3) << 4) | (e31 >> 4); s42 &= 0x3F;
-					unsigned char s43 = ((e31 & 0xF) << 2); s43 &= 0x3F;
-					for (size_t k = 0; k < g_patterns_count && !likely_match; ++k) {
-						struct search_pattern *sp = &g_patterns[k]; int ok = 1;
-						if (sp->pre_mask_len) {
-							if (sp->pre_mask_len >= 1 && sp->pre_idx[0] != p0) ok = 0;
-							if (ok && sp->pre_mask_len >= 2 && sp->pre_idx[1] != p1) ok = 0;
-							if (ok && sp->pre_mask_len >= 3 && sp->pre_idx[2] != p2) ok = 0;
-							if (ok && sp->pre_mask_len >= 4 && sp->pre_idx[3] != p3) ok = 0;
-						}
-						if (ok && sp->suf_mask_len) {
-							if (sp->suf_mask_len >= 1 && sp->suf_idx[0] != s41) ok = 0;
-							if (ok && sp->suf_mask_len >= 2 && sp->suf_idx[1] != s42) ok = 0;
-							if (ok && sp->suf_mask_len >= 3 && sp->suf_idx[2] != s43) ok = 0;
-						}
-						if (ok) { likely_match = 1; break; }
-					}
-				}
-				if (likely_match) {
-					base64_encode_32(pub_key, b64_pub);
-					int matched = 0;
-					for (size_t k = 0; k < g_patterns_count; ++k) {
-						struct search_pattern *sp = &g_patterns[k];
-						if (sp->prefix_len > 0 && memcmp(b64_pub, sp->prefix, sp->prefix_len) == 0) { matched = 1; break; }
-						if (sp->suffix_len > 0 && memcmp(b64_pub + sp->suffix_off, sp->suffix, sp->suffix_len) == 0) { matched = 1; break; }
-					}
-					if (matched) {
-						base64_encode_32(sk, b64_priv);
-						printf("FOUND: pub=%s priv=%s\n", b64_pub, b64_priv);
-						fprintf(stderr, "FOUND: pub=%s priv=%s\n", b64_pub, b64_priv);
-						fflush(stdout); fflush(stderr);
-						unsigned long long cur = atomic_fetch_add_explicit(&g_found_count, 1ULL, memory_order_relaxed) + 1ULL;
-						if (cur >= g_found_target) { atomic_store_explicit(&g_stop, 1, memory_order_relaxed); }
+// --- Match stages: raw-byte prefilter, then exact raw-bit verify on candidates only ---
+// A pattern entry may carry both a prefix and its STR= suffix; either one is enough to match.
+
+// Pattern index want (0xFF = '?') against key index got; fold also accepts the lower-case letter
+static inline int prefilter_idx_ok(unsigned char want, unsigned fold, unsigned char got) {
+	return want == 0xFFu || want == got || (fold && want + 26u == got);
+}
+
+// Compiled, immutable copy of the pattern list that the match stages read. Workers pick up the
+// current set at a batch boundary (pattern_set_enter) and never see it change under them; a new set
+// is published with one pointer swap (pattern_set_publish) and the old one is freed once every
+// worker has passed a later batch boundary. The copies keep only the compiled fields: the strings
+// stay with g_patterns, the list add_pattern builds.
+struct pattern_set {
+	struct search_pattern *pats;
+	size_t count;
+	size_t infix_count;
+	// Prefilter tables. pre_bitmap holds one bit per value of the first 3 public-key bytes
+	// (b0<<16 | b1<<8 | b2, i.e. the first four Base64 chars) and suf_bitmap one per value of the
+	// last 2 bytes (the three chars before '='); a bit is set when some pattern accepts that value,
+	// so the hot check is two lookups whatever the number of patterns. infix_digrams has one bit per
+	// pair of adjacent Base64 indices (c[p] << 6 | c[p+1]) that some --contains pattern starts its
+	// first fully specified pair with.
+	uint64_t *pre_bitmap;       // 2^24 bits (2 MiB); NULL: prefilter_linear
+	uint64_t suf_bitmap[(1u << 16) / 64];
+	uint64_t infix_digrams[(1u << 12) / 64];
+	unsigned long long retire_epoch; // set when replaced; freed once every reader is past it
+	struct pattern_set *next_retired;
+};
+
+// Cheap test on the first 3 and last 2 public-key bytes; 1 when some pattern may match
+static int prefilter_linear(const struct pattern_set *ps, const unsigned char pub_key[32]) {
+	if (ps->count == 0) return 0;
+	// First up to 4 Base64 indices from the first 3 bytes
+	unsigned char b0 = pub_key[0], b1 = pub_key[1], b2 = pub_key[2];
+	unsigned char p0 = (b0 >> 2) & 0x3F;
+	unsigned char p1 = (((b0 & 0x3) << 4) | (b1 >> 4)) & 0x3F;
+	unsigned char p2 = (((b1 & 0xF) << 2) | (b2 >> 6)) & 0x3F;
+	unsigned char p3 = b2 & 0x3F;
+	// Last 3 Base64 indices before '=' (string positions 40..42) from the last 2 bytes
+	unsigned char e30 = pub_key[30], e31 = pub_key[31];
+	unsigned char suf[3];
+	suf[0] = (e30 >> 2) & 0x3F;
+	suf[1] = (((e30 & 0x3) << 4) | (e31 >> 4)) & 0x3F;
+	suf[2] = ((e31 & 0xF) << 2) & 0x3F;
+	for (size_t i = 0; i < ps->count; ++i) {
+		const struct search_pattern *sp = &ps->pats[i];
+		if (sp->pre_mask_len) {
+			int ok = 1;
+			if (!prefilter_idx_ok(sp->pre_idx[0], sp->pre_fold & 1u, p0)) ok = 0;
+			if (ok && sp->pre_mask_len >= 2 && !prefilter_idx_ok(sp->pre_idx[1], sp->pre_fold & 2u, p1)) ok = 0;
+			if (ok && sp->pre_mask_len >= 3 && !prefilter_idx_ok(sp->pre_idx[2], sp->pre_fold & 4u, p2)) ok = 0;
+			if (ok && sp->pre_mask_len >= 4 && !prefilter_idx_ok(sp->pre_idx[3], sp->pre_fold & 8u, p3)) ok = 0;
+			if (ok) return 1;
+		}
+		if (sp->suf_mask_len) {
+			// suf_idx[] holds the last suf_mask_len chars in order; align them to the end
+			const unsigned char *s = suf + (3 - sp->suf_mask_len);
+			int ok = 1;
+			for (unsigned char k = 0; k < sp->suf_mask_len && ok; ++k) {
+				if (!prefilter_idx_ok(sp->suf_idx[k], sp->suf_fold & (1u << k), s[k])) ok = 0;
+			}
+			if (ok) return 1;
+		}
+	}
+	return 0;
+}
+
+// Base64 index of a pattern char: 0xFF for '?'. Under --ignore-case a letter yields its upper-case
+// index and sets fold_bit in *fold.
+static unsigned char pattern_char_index(char ch, unsigned *fold, unsigned fold_bit) {
+	if (ch == '?') return 0xFFu;
+	if (g_ignore_case && isalpha((unsigned char)ch)) {
+		*fold |= fold_bit;
+		return (unsigned char)(toupper((unsigned char)ch) - 'A');
+	}
+	return b64_index((unsigned char)ch);
+}
+
+// Set bit (value | s) for every subset s of free_bits
+static void bitmap_set_all(uint64_t *bm, uint32_t value, uint32_t free_bits) {
+	uint32_t s = 0;
+	do {
+		uint32_t i = value | s;
+		bm[i >> 6] |= 1ULL << (i & 63);
+		s = (s - free_bits) & free_bits;
+	} while (s);
+}
+
+static void pattern_set_free(struct pattern_set *ps) {
+	if (!ps) return;
+	free(ps->pats);
+	free(ps->pre_bitmap);
+	free(ps);
+}
+
+// Compile the current g_patterns into a new set; NULL when out of memory. Without the 2 MiB prefix
+// bitmap the set still works through prefilter_linear (*no_bitmap is then set).
+static struct pattern_set *pattern_set_build(int *no_bitmap) {
+	struct pattern_set *ps = (struct pattern_set *)calloc(1, sizeof *ps);
+	if (!ps) return NULL;
+	if (g_patterns_count) {
+		ps->pats = (struct search_pattern *)malloc(g_patterns_count * sizeof *ps->pats);
+		if (!ps->pats) { free(ps); return NULL; }
+		memcpy(ps->pats, g_patterns, g_patterns_count * sizeof *ps->pats);
+	}
+	ps->count = g_patterns_count;
+	ps->infix_count = g_infix_count;
+	*no_bitmap = 0;
+	for (size_t i = 0; i < g_patterns_count; ++i) {
+		const struct search_pattern *sp = &g_patterns[i];
+		if (!sp->infix_len) continue;
+		// First adjacent pair without '?' (or the leading pair); a missing second char is a wildcard
+		size_t q = 0;
+		while (q + 1 < sp->infix_len && (sp->infix[q] == '?' || sp->infix[q + 1] == '?')) ++q;
+		if (q + 1 >= sp->infix_len) q = 0;
+		unsigned fold = 0;
+		unsigned char a = pattern_char_index(sp->infix[q], &fold, 1u);
+		unsigned char b = q + 1 < sp->infix_len ? pattern_char_index(sp->infix[q + 1], &fold, 2u) : 0xFFu;
+		for (unsigned cs = 0; cs < 4; ++cs) {
+			if (cs & ~fold) continue; // each folded letter in upper (bit clear) and lower (bit set) case
+			uint32_t value = 0, free_bits = 0;
+			if (a == 0xFFu) free_bits |= 0xFC0u; else value |= (uint32_t)(a + (cs & 1u ? 26 : 0)) << 6;
+			if (b == 0xFFu) free_bits |= 0x03Fu; else value |= (uint32_t)(b + (cs & 2u ? 26 : 0));
+			bitmap_set_all(ps->infix_digrams, value, free_bits);
+		}
+	}
+	for (size_t i = 0; i < ps->count; ++i) {
+		struct search_pattern *sp = &ps->pats[i];
+		sp->prefix = sp->suffix = sp->infix = NULL; // owned by g_patterns, which may be rebuilt
+	}
+	// Infix-only sets need no prefix bitmap
+	if (ps->count == ps->infix_count) return ps;
+	ps->pre_bitmap = (uint64_t *)calloc((1u << 24) / 64, sizeof(uint64_t));
+	if (!ps->pre_bitmap) { *no_bitmap = 1; return ps; }
+	for (size_t i = 0; i < ps->count; ++i) {
+		const struct search_pattern *sp = &ps->pats[i];
+		// cs walks the case choices of folded letters: bit k set takes the lower-case index
+		for (unsigned cs = 0; sp->pre_mask_len && cs < 16u; ++cs) {
+			if (cs & ~(unsigned)sp->pre_fold) continue;
+			// Char k covers bits 23-6k .. 18-6k; '?' leaves them free
+			uint32_t value = 0, mask = 0;
+			for (unsigned k = 0; k < sp->pre_mask_len; ++k) {
+				if (sp->pre_idx[k] == 0xFFu) continue;
+				value |= (uint32_t)(sp->pre_idx[k] + (cs >> k & 1u ? 26 : 0)) << (18 - 6 * k);
+				mask |= 0x3Fu << (18 - 6 * k);
+			}
+			bitmap_set_all(ps->pre_bitmap, value, 0xFFFFFFu & ~mask);
+		}
+		for (unsigned cs = 0; sp->suf_mask_len && cs < 8u; ++cs) {
+			if (cs & ~(unsigned)sp->suf_fold) continue;
+			// Over x = b30<<8 | b31 the three chars before '=' are x>>10, (x>>4)&63 and (x&15)<<2;
+			// a last char with either low bit set can never occur, so that choice adds nothing
+			uint32_t value = 0, mask = 0;
+			int possible = 1;
+			for (unsigned k = 0; k < sp->suf_mask_len; ++k) {
+				unsigned pos = 3u - sp->suf_mask_len + k;
+				uint32_t c = sp->suf_idx[k];
+				if (c == 0xFFu) continue;
+				if (cs >> k & 1u) c += 26;
+				if (pos == 0) { value |= c << 10; mask |= 0xFC00u; }
+				else if (pos == 1) { value |= c << 4; mask |= 0x03F0u; }
+				else { if (c & 3) possible = 0; value |= c >> 2; mask |= 0x000Fu; }
+			}
+			if (possible) bitmap_set_all(ps->suf_bitmap, value, 0xFFFFu & ~mask);
+		}
+	}
+	return ps;
+}
+
+// Same answer as prefilter_linear from two bitmap lookups
+static int prefilter_bitmap(const struct pattern_set *ps, const unsigned char pub_key[32]) {
+	uint32_t pre = (uint32_t)pub_key[0] << 16 | (uint32_t)pub_key[1] << 8 | pub_key[2];
+	uint32_t suf = (uint32_t)pub_key[30] << 8 | pub_key[31];
+	return (int)(((ps->pre_bitmap[pre >> 6] >> (pre & 63)) | (ps->suf_bitmap[suf >> 6] >> (suf & 63))) & 1);
+}
+
+// 1 when some adjacent pair of the 43 data chars is in ps->infix_digrams. Each 3-byte group gives
+// four 6-bit indices and four pairs (the last one reaching into the next group); the zero padding
+// past byte 31 matches the encoder, so pairs touching it are at worst false candidates.
+static int prefilter_infix(const struct pattern_set *ps, const unsigned char pub_key[32]) {
+	const uint64_t *dg = ps->infix_digrams;
+	unsigned char b[34] = {0};
+	memcpy(b, pub_key, 32);
+	uint64_t hit = 0;
+	for (int g = 0; g < 11; ++g) {
+		uint32_t x = (uint32_t)b[3 * g] << 16 | (uint32_t)b[3 * g + 1] << 8 | b[3 * g + 2];
+		uint32_t d0 = x >> 12, d1 = (x >> 6) & 0xFFFu, d2 = x & 0xFFFu;
+		uint32_t d3 = (x & 0x3Fu) << 6 | (g < 10 ? (uint32_t)b[3 * g + 3] >> 2 : 0u);
+		hit |= (dg[d0 >> 6] >> (d0 & 63)) | (dg[d1 >> 6] >> (d1 & 63)) |
+			(dg[d2 >> 6] >> (d2 & 63)) | (dg[d3 >> 6] >> (d3 & 63));
+	}
+	return (int)(hit & 1);
+}
+
+static inline int bits_match(const uint64_t w[4], const uint64_t m[4], const uint64_t v[4]) {
+	return (((w[0] & m[0]) ^ v[0]) | ((w[1] & m[1]) ^ v[1]) | ((w[2] & m[2]) ^ v[2]) | ((w[3] & m[3]) ^ v[3])) == 0;
+}
+
+// 64 key bits starting at Base64 char position p, from big-endian words be[0..3] (be[4] = 0 padding)
+static inline uint64_t key_window(const uint64_t be[5], unsigned p) {
+	unsigned bit = p * 6, wi = bit >> 6, sh = bit & 63;
+	return sh ? (be[wi] << sh) | (be[wi + 1] >> (64 - sh)) : be[wi];
+}
+
+// Folded letters of a pattern placed at char position base
+static int case_fold_match(const uint64_t be[5], const struct case_fold *cf, unsigned base) {
+	for (unsigned k = 0; k < cf->n; ++k) {
+		unsigned c = (unsigned)(key_window(be, base + cf->pos[k]) >> 58);
+		if (c != cf->upper[k] && c != cf->upper[k] + 26u) return 0;
+	}
+	return 1;
+}
+
+// Slide the infix window over the key
+static int infix_match(const uint64_t be[5], const struct search_pattern *sp) {
+	for (unsigned o = 0; o + sp->infix_len <= BASE64_LEN - 1; ++o) {
+		if ((key_window(be, o) & sp->inf_mask) == sp->inf_val && case_fold_match(be, &sp->inf_cf, o)) return 1;
+	}
+	return 0;
+}
+
+static inline void key_words_be(const unsigned char pub_key[32], uint64_t be[5]) {
+	for (int k = 0; k < 4; ++k) {
+		uint64_t v = 0;
+		for (int j = 0; j < 8; ++j) v = v << 8 | pub_key[8 * k + j];
+		be[k] = v;
+	}
+	be[4] = 0;
+}
+
+// What a verify stage hands to the sink
+struct key_match {
+	char b64_pub[BASE64_LEN + 1];
+	const unsigned char *pub; // raw key behind b64_pub, valid until the sink returns
+	const struct pattern_set *set; // pattern set the key was matched against (set per batch)
+	const char *target;       // --fleet: " search=STR" / " contains=STR" the key was assigned to
+	const char *word;  // --wordlist entry that matched (not NUL-terminated), NULL otherwise
+	int word_len;
+	// --seed: where the secret came from (filled by the secret stage)
+	int thread;
+	unsigned long long index; // key index in the thread's stream (walk start for --incremental)
+	long long step;           // --incremental walk step, -1 otherwise
+};
+
+// Exact compare against every pattern on the raw key bytes; Base64 is only produced for a hit.
+// Returns 1 on a match with m filled in, 0 otherwise.
+// One pattern against a key given as raw words (w) and big-endian words (be)
+static inline int pattern_matches(const struct search_pattern *sp, const uint64_t w[4], const uint64_t be[5]) {
+	return (sp->pre_bits && bits_match(w, sp->pre_bmask, sp->pre_bval) && case_fold_match(be, &sp->pre_cf, 0)) ||
+		(sp->suf_bits && bits_match(w, sp->suf_bmask, sp->suf_bval) && case_fold_match(be, &sp->suf_cf, 0)) ||
+		(sp->infix_len && infix_match(be, sp));
+}
+
+static int verify_bits(const struct pattern_set *ps, const unsigned char pub_key[32], struct key_match *m) {
+	uint64_t w[4], be[5];
+	memcpy(w, pub_key, 32);
+	key_words_be(pub_key, be);
+	for (size_t i = 0; i < ps->count; ++i) {
+		if (pattern_matches(&ps->pats[i], w, be)) {
+			base64_encode_32(pub_key, m->b64_pub);
+			m->pub = pub_key;
+			m->word = NULL; m->word_len = 0;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// --top score: the longest run of pattern chars matched from the start of the key (prefix side) or
+// back from '=' (suffix side), over all prefix/suffix patterns. One XOR and a leading/trailing zero
+// count per side; '?' and folded letters are masked out of the XOR, and folded letters inside the
+// matched run are then checked one by one. No Base64 is produced.
+static int score_patterns(const struct pattern_set *ps, const unsigned char pub_key[32]) {
+	uint64_t be[5];
+	key_words_be(pub_key, be);
+	uint64_t head = be[0], tail = be[3] << 2; // tail: char 42 in bits 5..0, char 42-d in bits 6d+5..6d
+	int best = 0;
+	for (size_t i = 0; i < ps->count; ++i) {
+		const struct search_pattern *sp = &ps->pats[i];
+		if (sp->sc_pre_len) {
+			uint64_t x = (head ^ sp->sc_pre_val) & sp->sc_pre_mask;
+			int n = x ? __builtin_clzll(x) / 6 : sp->sc_pre_len;
+			for (unsigned k = 0; k < sp->pre_cf.n && n > best; ++k) {
+				unsigned pos = sp->pre_cf.pos[k];
+				unsigned c = (unsigned)(key_window(be, pos) >> 58);
+				if ((int)pos < n && c != sp->pre_cf.upper[k] && c != sp->pre_cf.upper[k] + 26u) n = (int)pos;
+			}
+			if (n > best) best = n;
+		}
+		if (sp->sc_suf_len) {
+			uint64_t x = (tail ^ sp->sc_suf_val) & sp->sc_suf_mask;
+			int n = x ? __builtin_ctzll(x) / 6 : sp->sc_suf_len;
+			for (unsigned k = 0; k < sp->suf_cf.n && n > best; ++k) {
+				int d = BASE64_LEN - 2 - sp->suf_cf.pos[k];
+				unsigned c = (unsigned)(key_window(be, sp->suf_cf.pos[k]) >> 58);
+				if (d < n && c != sp->suf_cf.upper[k] && c != sp->suf_cf.upper[k] + 26u) n = d;
+			}
+			if (n > best) best = n;
+		}
+	}
+	return best;
+}
+
+// --- Pattern set publication: pointer swap plus quiescent-state epochs ---
+// g_pset is the set the workers match against. A worker reads it only at a batch boundary, right
+// after writing the epoch it saw into its reader slot; that write also says it no longer holds any
+// older set. pattern_set_publish swaps the pointer and then bumps the epoch, and a replaced set is
+// freed once every online reader has announced that epoch or a later one. A worker pays one load of
+// g_pset_epoch per batch; the per-key loop is unchanged.
+#define PSET_OFFLINE ULLONG_MAX  // reader slot of a worker that holds no set (parked or exited)
+struct pset_reader {
+	_Alignas(64) _Atomic unsigned long long epoch;
+};
+static _Atomic(struct pattern_set *) g_pset = NULL;
+static _Atomic unsigned long long g_pset_epoch = 1;
+static struct pset_reader *g_pset_readers = NULL; // one per worker thread
+static int g_pset_nreaders = 0;
+static struct pattern_set *g_pset_retired = NULL; // replaced sets not yet freed (g_pset_lock)
+static pthread_mutex_t g_pset_lock = PTHREAD_MUTEX_INITIALIZER; // publishers
+
+// Free the retired sets no reader can still hold; caller holds g_pset_lock
+static void pattern_set_reclaim_locked(void) {
+	unsigned long long oldest = PSET_OFFLINE;
+	for (int i = 0; i < g_pset_nreaders; ++i) {
+		unsigned long long e = atomic_load(&g_pset_readers[i].epoch);
+		if (e < oldest) oldest = e;
+	}
+	struct pattern_set **pp = &g_pset_retired;
+	while (*pp) {
+		struct pattern_set *ps = *pp;
+		if (ps->retire_epoch <= oldest) { *pp = ps->next_retired; pattern_set_free(ps); }
+		else pp = &ps->next_retired;
+	}
+}
+
+// Called periodically by whoever publishes, so a retired set does not wait for the next swap
+static void pattern_set_reclaim(void) {
+	pthread_mutex_lock(&g_pset_lock);
+	pattern_set_reclaim_locked();
+	pthread_mutex_unlock(&g_pset_lock);
+}
+
+// Make ps the current set and retire the previous one
+static void pattern_set_publish(struct pattern_set *ps) {
+	pthread_mutex_lock(&g_pset_lock);
+	struct pattern_set *old = atomic_exchange(&g_pset, ps);
+	unsigned long long e = atomic_fetch_add(&g_pset_epoch, 1ULL) + 1ULL;
+	if (old) { old->retire_epoch = e; old->next_retired = g_pset_retired; g_pset_retired = old; }
+	pattern_set_reclaim_locked();
+	pthread_mutex_unlock(&g_pset_lock);
+}
+
+// Compile g_patterns and publish it; 0 when out of memory (the current set stays)
+static int pattern_set_rebuild(void) {
+	int no_bitmap = 0;
+	struct pattern_set *ps = pattern_set_build(&no_bitmap);
+	if (!ps) { fprintf(stderr, "Out of memory compiling the pattern set\n"); return 0; }
+	if (no_bitmap) fprintf(stderr, "Warning: cannot allocate the prefix bitmap; using the per-pattern prefilter\n");
+	pattern_set_publish(ps);
+	return 1;
+}
+
+// Empty g_patterns before it is filled again for a new set
+static void patterns_clear(void) {
+	for (size_t i = 0; i < g_patterns_count; ++i) {
+		free(g_patterns[i].prefix); free(g_patterns[i].suffix); free(g_patterns[i].infix);
+	}
+	g_patterns_count = 0;
+	g_infix_count = 0;
+}
+
+// --- Wordlist index (--wordlist FILE) ---
+// The file is memory-mapped and never copied: each word is an offset/length into the mapping. Words
+// are indexed twice, by their first four chars (24 key bits, bytes 0..2) and by their last four
+// before '=' (the 22 data bits at the end of byte 29..31). Per key that is one bit lookup per side in
+// a presence bitmap; only on a hit does an open-addressing table give the range of word ids sharing
+// that key, and those words are compared char by char on the raw bits.
+#define WORDLIST_MIN_LEN 4
+struct wordlist_slot {
+	uint32_t key;   // index key + 1; 0 marks an empty slot
+	uint32_t start; // first entry in the side's sorted id array
+	uint32_t count;
+};
+struct wordlist_side {
+	uint64_t *present;             // one bit per key value
+	struct wordlist_slot *slots;   // 2^slot_bits slots, at most half used
+	unsigned slot_bits;
+	uint32_t *ids;                 // word ids grouped by key
+};
+static struct {
+	const char *map;
+	size_t map_len;
+	uint32_t n;
+	uint32_t *off;
+	unsigned char *len;
+	struct wordlist_side pre, suf;
+} g_wordlist;
+
+static inline uint32_t wordlist_hash(uint32_t key, unsigned bits) {
+	return (key * 0x9E3779B1u) >> (32 - bits);
+}
+
+static inline uint32_t wordlist_pre_key(const unsigned char pub_key[32]) {
+	return (uint32_t)pub_key[0] << 16 | (uint32_t)pub_key[1] << 8 | pub_key[2];
+}
+
+static inline uint32_t wordlist_suf_key(const unsigned char pub_key[32]) {
+	return (uint32_t)(pub_key[29] & 0x3F) << 16 | (uint32_t)pub_key[30] << 8 | pub_key[31];
+}
+
+static const struct wordlist_slot *wordlist_find(const struct wordlist_side *sd, uint32_t key) {
+	uint32_t mask = (1u << sd->slot_bits) - 1u;
+	for (uint32_t h = wordlist_hash(key, sd->slot_bits);; h = (h + 1) & mask) {
+		const struct wordlist_slot *s = &sd->slots[h];
+		if (s->key == key + 1) return s;
+		if (s->key == 0) return NULL;
+	}
+}
+
+static int wordlist_entry_cmp(const void *a, const void *b) {
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+	return x < y ? -1 : x > y;
+}
+
+// Group (key << 32 | id) entries by key into the side's bitmap, slot table and id array
+static int wordlist_side_build(struct wordlist_side *sd, uint64_t *ent, size_t n, unsigned key_bits) {
+	qsort(ent, n, sizeof *ent, wordlist_entry_cmp);
+	size_t distinct = 0;
+	for (size_t i = 0; i < n; ++i) if (i == 0 || (ent[i] >> 32) != (ent[i - 1] >> 32)) distinct++;
+	sd->slot_bits = 4;
+	while ((1ull << sd->slot_bits) < 2 * distinct) sd->slot_bits++;
+	sd->present = (uint64_t *)calloc(((size_t)1 << key_bits) / 64, sizeof(uint64_t));
+	sd->slots = (struct wordlist_slot *)calloc((size_t)1 << sd->slot_bits, sizeof(struct wordlist_slot));
+	sd->ids = (uint32_t *)malloc((n ? n : 1) * sizeof(uint32_t));
+	if (!sd->present || !sd->slots || !sd->ids) return -1;
+	uint32_t mask = (1u << sd->slot_bits) - 1u;
+	for (size_t i = 0; i < n;) {
+		uint32_t key = (uint32_t)(ent[i] >> 32);
+		size_t j = i;
+		for (; j < n && (uint32_t)(ent[j] >> 32) == key; ++j) sd->ids[j] = (uint32_t)ent[j];
+		sd->present[key >> 6] |= 1ULL << (key & 63);
+		uint32_t h = wordlist_hash(key, sd->slot_bits);
+		while (sd->slots[h].key) h = (h + 1) & mask;
+		sd->slots[h].key = key + 1; sd->slots[h].start = (uint32_t)i; sd->slots[h].count = (uint32_t)(j - i);
+		i = j;
+	}
+	return 0;
+}
+
+// Map FILE and index its words: one per line, blank lines and '#' comments ignored, surrounding
+// whitespace trimmed. Words must be 4..43 Base64 chars; others are counted in *skipped.
+// Returns 0 on success, -1 with a message printed otherwise.
+static int wordlist_load(const char *path, size_t *skipped) {
+	*skipped = 0;
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) { fprintf(stderr, "Cannot open wordlist %s: %s\n", path, strerror(errno)); return -1; }
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) { fprintf(stderr, "Wordlist %s is empty or unreadable\n", path); close(fd); return -1; }
+	void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) { fprintf(stderr, "Cannot map wordlist %s: %s\n", path, strerror(errno)); return -1; }
+	g_wordlist.map = (const char *)map;
+	g_wordlist.map_len = (size_t)st.st_size;
+	// One line per word at most: size the arrays from the line count
+	size_t lines = 1;
+	for (const char *q = g_wordlist.map; (q = memchr(q, '\n', g_wordlist.map_len - (size_t)(q - g_wordlist.map))); ++q) lines++;
+	g_wordlist.off = (uint32_t *)malloc(lines * sizeof(uint32_t));
+	g_wordlist.len = (unsigned char *)malloc(lines);
+	uint64_t *pre = (uint64_t *)malloc(lines * sizeof(uint64_t));
+	uint64_t *suf = (uint64_t *)malloc(lines * sizeof(uint64_t));
+	if (!g_wordlist.off || !g_wordlist.len || !pre || !suf || g_wordlist.map_len > UINT32_MAX) {
+		fprintf(stderr, "Wordlist %s: out of memory or larger than 4 GiB\n", path);
+		free(pre); free(suf);
+		return -1;
+	}
+	size_t npre = 0, nsuf = 0;
+	const char *end = g_wordlist.map + g_wordlist.map_len;
+	for (const char *line = g_wordlist.map; line < end;) {
+		const char *eol = memchr(line, '\n', (size_t)(end - line));
+		if (!eol) eol = end;
+		const char *a = line, *b = eol;
+		line = eol + 1;
+		while (a < b && isspace((unsigned char)*a)) a++;
+		while (b > a && isspace((unsigned char)b[-1])) b--;
+		if (a == b || *a == '#') continue;
+		size_t n = (size_t)(b - a);
+		int ok = n >= WORDLIST_MIN_LEN && n <= BASE64_LEN - 1;
+		unsigned char idx[BASE64_LEN];
+		for (size_t i = 0; ok && i < n; ++i) if ((idx[i] = b64_index((unsigned char)a[i])) == 0xFFu) ok = 0;
+		if (!ok) { (*skipped)++; continue; }
+		uint32_t id = g_wordlist.n++;
+		g_wordlist.off[id] = (uint32_t)(a - g_wordlist.map);
+		g_wordlist.len[id] = (unsigned char)n;
+		uint32_t pk = (uint32_t)idx[0] << 18 | (uint32_t)idx[1] << 12 | (uint32_t)idx[2] << 6 | idx[3];
+		pre[npre++] = (uint64_t)pk << 32 | id;
+		// As a suffix the last char sits at position 42, whose low 2 bits are the zero padding
+		if ((idx[n - 1] & 3) == 0) {
+			uint32_t sk = (uint32_t)idx[n - 4] << 16 | (uint32_t)idx[n - 3] << 10 | (uint32_t)idx[n - 2] << 4 | (uint32_t)idx[n - 1] >> 2;
+			suf[nsuf++] = (uint64_t)sk << 32 | id;
+		}
+	}
+	int rc = 0;
+	if (wordlist_side_build(&g_wordlist.pre, pre, npre, 24) != 0 || wordlist_side_build(&g_wordlist.suf, suf, nsuf, 22) != 0) {
+		fprintf(stderr, "Wordlist %s: out of memory\n", path);
+		rc = -1;
+	}
+	free(pre); free(suf);
+	return rc;
+}
+
+static void wordlist_free(void) {
+	if (g_wordlist.map) munmap((void *)g_wordlist.map, g_wordlist.map_len);
+	free(g_wordlist.off); free(g_wordlist.len);
+	free(g_wordlist.pre.present); free(g_wordlist.pre.slots); free(g_wordlist.pre.ids);
+	free(g_wordlist.suf.present); free(g_wordlist.suf.slots); free(g_wordlist.suf.ids);
+	memset(&g_wordlist, 0, sizeof g_wordlist);
+}
+
+static int prefilter_wordlist(const struct pattern_set *ps, const unsigned char pub_key[32]) {
+	(void)ps;
+	uint32_t pk = wordlist_pre_key(pub_key), sk = wordlist_suf_key(pub_key);
+	return (int)(((g_wordlist.pre.present[pk >> 6] >> (pk & 63)) | (g_wordlist.suf.present[sk >> 6] >> (sk & 63))) & 1);
+}
+
+// Word id at char position pos (chars 0..3 / the last 4 are already known to match through the key)
+static int wordlist_word_at(const uint64_t be[5], uint32_t id, unsigned pos) {
+	const char *w = g_wordlist.map + g_wordlist.off[id];
+	for (unsigned k = 0; k < g_wordlist.len[id]; ++k) {
+		if ((unsigned)(key_window(be, pos + k) >> 58) != b64_index((unsigned char)w[k])) return 0;
+	}
+	return 1;
+}
+
+static int verify_wordlist(const struct pattern_set *ps, const unsigned char pub_key[32], struct key_match *m) {
+	(void)ps;
+	uint64_t be[5];
+	key_words_be(pub_key, be);
+	uint32_t hit = UINT32_MAX;
+	const struct wordlist_slot *s = wordlist_find(&g_wordlist.pre, wordlist_pre_key(pub_key));
+	for (uint32_t i = 0; s && i < s->count && hit == UINT32_MAX; ++i) {
+		uint32_t id = g_wordlist.pre.ids[s->start + i];
+		if (wordlist_word_at(be, id, 0)) hit = id;
+	}
+	s = hit == UINT32_MAX ? wordlist_find(&g_wordlist.suf, wordlist_suf_key(pub_key)) : NULL;
+	for (uint32_t i = 0; s && i < s->count && hit == UINT32_MAX; ++i) {
+		uint32_t id = g_wordlist.suf.ids[s->start + i];
+		if (wordlist_word_at(be, id, BASE64_LEN - 1u - g_wordlist.len[id])) hit = id;
+	}
+	if (hit == UINT32_MAX) return 0;
+	base64_encode_32(pub_key, m->b64_pub);
+	m->pub = pub_key;
+	m->word = g_wordlist.map + g_wordlist.off[hit];
+	m->word_len = g_wordlist.len[hit];
+	return 1;
+}
+
+static void worker_send_found(const char *line); // --worker, defined with the sharding code
+
+// --- FOUND output: lock-free MPSC ring drained by one writer thread ---
+// Sinks run on the compute threads, so they only copy a fixed-size record into the ring; the writer
+// does the Base64, formatting, stdout/stderr duplication, --json and the --worker forward, with all
+// stdio locking and blocking I/O. Producers claim a slot by CAS on the tail (bounded MPMC queue
+// with per-slot sequence numbers, used with a single consumer). When the ring is full the producer
+// yields until the writer frees a slot: backpressure, never a dropped key. The found count and the
+// -c stop stay on the producer side, so the limit is exact whatever the writer's lag.
+#define FOUND_RING_SLOTS 1024u // power of two
+struct found_rec {
+	unsigned char pub[32], priv[32];
+	int thread;
+	unsigned long long index;
+	long long step;
+	int word_len;
+	char word[BASE64_LEN];
+	char target[INFIX_MAX_LEN + BASE64_LEN + 16]; // --fleet: " search=STR" / " contains=STR"
+};
+struct found_slot {
+	_Alignas(64) _Atomic unsigned long long seq;
+	struct found_rec rec;
+};
+static struct found_slot *g_found_ring = NULL; // NULL: no writer, sinks print directly
+static struct { _Alignas(64) _Atomic unsigned long long pos; } g_found_tail;
+static _Atomic int g_found_closing = 0;
+static _Atomic unsigned long long g_found_waits = 0; // pushes that found the ring full
+static pthread_t g_found_writer;
+
+// FOUND text line; with --json also the JSON object for stdout. All values are Base64 or digits,
+// so nothing needs escaping.
+static void found_print(const struct found_rec *r) {
+	char b64_pub[BASE64_LEN + 1], b64_priv[BASE64_LEN + 1];
+	base64_encode_32(r->pub, b64_pub);
+	base64_encode_32(r->priv, b64_priv);
+	char word[BASE64_LEN + 8] = "", origin[96] = "";
+	if (r->word_len) snprintf(word, sizeof word, " word=%.*s", r->word_len, r->word);
+	if (g_seeded) {
+		// A random stream key has no printable seed; --regen with --resume FILE replays these records
+		int n = g_seed_random ? snprintf(origin, sizeof origin, " thread=%d index=%llu", r->thread, r->index)
+			: snprintf(origin, sizeof origin, " seed=%llu thread=%d index=%llu", g_seed, r->thread, r->index);
+		if (r->step >= 0) snprintf(origin + n, sizeof origin - (size_t)n, " step=%lld", r->step);
+	}
+	char line[320];
+	snprintf(line, sizeof line, "FOUND: pub=%s priv=%s%s%s%s\n", b64_pub, b64_priv, word, origin, r->target);
+	if (g_json) {
+		char js[400];
+		int n = snprintf(js, sizeof js, "{\"pub\":\"%s\",\"priv\":\"%s\"", b64_pub, b64_priv);
+		if (r->word_len) n += snprintf(js + n, sizeof js - (size_t)n, ",\"word\":\"%.*s\"", r->word_len, r->word);
+		if (g_seeded) {
+			if (!g_seed_random) n += snprintf(js + n, sizeof js - (size_t)n, ",\"seed\":%llu", g_seed);
+			n += snprintf(js + n, sizeof js - (size_t)n, ",\"thread\":%d,\"index\":%llu", r->thread, r->index);
+			if (r->step >= 0) n += snprintf(js + n, sizeof js - (size_t)n, ",\"step\":%lld", r->step);
+		}
+		const char *eq = r->target[0] ? strchr(r->target, '=') : NULL;
+		if (eq) n += snprintf(js + n, sizeof js - (size_t)n, ",\"%.*s\":\"%s\"", (int)(eq - r->target - 1), r->target + 1, eq + 1);
+		snprintf(js + n, sizeof js - (size_t)n, "}\n");
+		fputs(js, stdout);
+	} else {
+		fputs(line, stdout);
+	}
+	fputs(line, stderr);
+	if (g_worker_fd >= 0) worker_send_found(line);
+}
+
+static void *found_writer(void *arg) {
+	(void)arg;
+	unsigned long long head = 0;
+	int idle = 0;
+	for (;;) {
+		struct found_slot *sl = &g_found_ring[head & (FOUND_RING_SLOTS - 1)];
+		if (atomic_load_explicit(&sl->seq, memory_order_acquire) == head + 1) {
+			found_print(&sl->rec);
+			atomic_store_explicit(&sl->seq, head + FOUND_RING_SLOTS, memory_order_release);
+			head++;
+			idle = 0;
+			continue;
+		}
+		if (idle++ == 0) { fflush(stdout); fflush(stderr); } // once per drained burst
+		// Closing is set after the workers are joined, so the tail no longer moves
+		if (atomic_load(&g_found_closing) && atomic_load(&g_found_tail.pos) == head) break;
+		struct timespec ts = {0, idle < 64 ? 50 * 1000L : 1000 * 1000L};
+		nanosleep(&ts, NULL);
+	}
+	return NULL;
+}
+
+static int found_writer_start(void) {
+	g_found_ring = (struct found_slot *)aligned_alloc(64, sizeof(struct found_slot) * FOUND_RING_SLOTS);
+	if (!g_found_ring) return -1;
+	for (unsigned i = 0; i < FOUND_RING_SLOTS; ++i) atomic_init(&g_found_ring[i].seq, i);
+	atomic_store(&g_found_tail.pos, 0);
+	atomic_store(&g_found_closing, 0);
+	pthread_create(&g_found_writer, NULL, found_writer, NULL);
+	return 0;
+}
+
+// After the workers are joined: print what is queued and stop the writer
+static void found_writer_stop(void) {
+	if (!g_found_ring) return;
+	atomic_store(&g_found_closing, 1);
+	pthread_join(g_found_writer, NULL);
+	free(g_found_ring);
+	g_found_ring = NULL;
+	unsigned long long waits = atomic_load(&g_found_waits);
+	if (waits) fprintf(stderr, "FOUND output: the ring was full %llu times; workers waited for the writer\n", waits);
+}
+
+static void found_push(const struct found_rec *r) {
+	unsigned long long pos = atomic_load_explicit(&g_found_tail.pos, memory_order_relaxed);
+	int full = 0;
+	for (;;) {
+		struct found_slot *sl = &g_found_ring[pos & (FOUND_RING_SLOTS - 1)];
+		unsigned long long seq = atomic_load_explicit(&sl->seq, memory_order_acquire);
+		long long dif = (long long)(seq - pos);
+		if (dif == 0) {
+			if (atomic_compare_exchange_weak_explicit(&g_found_tail.pos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+				sl->rec = *r;
+				atomic_store_explicit(&sl->seq, pos + 1, memory_order_release);
+				return;
+			}
+		} else {
+			if (dif < 0) { // full: wait for the writer
+				if (!full++) atomic_fetch_add_explicit(&g_found_waits, 1, memory_order_relaxed);
+				sched_yield();
+			}
+			pos = atomic_load_explicit(&g_found_tail.pos, memory_order_relaxed);
+		}
+	}
+}
+
+// Sink: queue a FOUND record (printed by the writer) and bump the global found counter (stops when
+// the target is hit). A wordlist match adds word=WORD; --seed adds the (seed, thread, index[, step])
+// record; --fleet adds the target. Workers also forward the line to their coordinator.
+static void report_found(const struct key_match *m, const unsigned char priv[32]) {
+	struct found_rec r;
+	memcpy(r.pub, m->pub, 32);
+	memcpy(r.priv, priv, 32);
+	r.thread = m->thread; r.index = m->index; r.step = m->step;
+	r.word_len = m->word ? m->word_len : 0;
+	if (r.word_len) memcpy(r.word, m->word, (size_t)r.word_len);
+	snprintf(r.target, sizeof r.target, "%s", m->target ? m->target : "");
+	if (g_found_ring) {
+		found_push(&r);
+	} else {
+		found_print(&r);
+		fflush(stdout); fflush(stderr);
+	}
+	unsigned long long cur = atomic_fetch_add_explicit(&g_found_count, 1ULL, memory_order_relaxed) + 1ULL;
+	if (cur >= g_found_target) { atomic_store_explicit(&g_stop.flag, 1, memory_order_relaxed); }
+}
+
+// --- --top K: best-so-far leaderboards ---
+// Each worker keeps its own min-heap of the K best-scoring keys and only it writes there; the
+// sequence counter is odd while it does, so the reporter can copy a consistent snapshot without
+// locks (retrying if the counter moved) and merge all threads into the global top K.
+#define TOP_MAX 64
+struct top_entry {
+	int score;
+	unsigned char pub[32];
+	unsigned char sk[32];
+};
+struct top_board {
+	_Alignas(64) _Atomic unsigned seq;
+	int n;
+	struct top_entry e[TOP_MAX]; // min-heap on score
+};
+static struct top_board *g_top_boards = NULL; // one per worker thread
+
+// Insert into the owner's heap; returns the new entry threshold (min score once full)
+static int top_offer(struct top_board *b, int score, const unsigned char pub[32], const unsigned char sk[32]) {
+	unsigned seq = atomic_load_explicit(&b->seq, memory_order_relaxed);
+	atomic_store_explicit(&b->seq, seq + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	struct top_entry ne;
+	ne.score = score; memcpy(ne.pub, pub, 32); memcpy(ne.sk, sk, 32);
+	int i;
+	if (b->n < g_top_k) {
+		// Sift up from the new leaf
+		for (i = b->n++; i > 0 && b->e[(i - 1) / 2].score > score; i = (i - 1) / 2) b->e[i] = b->e[(i - 1) / 2];
+	} else {
+		// Replace the root (current minimum) and sift down
+		for (i = 0;;) {
+			int c = 2 * i + 1;
+			if (c >= b->n) break;
+			if (c + 1 < b->n && b->e[c + 1].score < b->e[c].score) c++;
+			if (b->e[c].score >= score) break;
+			b->e[i] = b->e[c]; i = c;
+		}
+	}
+	b->e[i] = ne;
+	atomic_store_explicit(&b->seq, seq + 2, memory_order_release);
+	return b->n < g_top_k ? 0 : b->e[0].score;
+}
+
+static int top_board_read(struct top_board *b, struct top_entry *out) {
+	for (;;) {
+		unsigned s0 = atomic_load_explicit(&b->seq, memory_order_acquire);
+		if (s0 & 1u) { sched_yield(); continue; }
+		int n = b->n;
+		if (n < 0 || n > g_top_k) continue;
+		memcpy(out, b->e, (size_t)n * sizeof *out);
+		atomic_thread_fence(memory_order_acquire);
+		if (atomic_load_explicit(&b->seq, memory_order_relaxed) == s0) return n;
+	}
+}
+
+static int top_entry_cmp(const void *a, const void *b) {
+	const struct top_entry *x = (const struct top_entry *)a, *y = (const struct top_entry *)b;
+	if (x->score != y->score) return y->score - x->score;
+	return memcmp(x->pub, y->pub, 32);
+}
+
+// Merge all boards and print the global top K: on stderr from the reporter when it changed, and
+// as TOP lines on stdout too at the end of the run
+static void top_print(int final) {
+	static uint64_t last_sig = 0;
+	if (!g_top_boards) return;
+	struct top_entry *all = (struct top_entry *)malloc((size_t)g_num_threads * (size_t)g_top_k * sizeof *all);
+	if (!all) return;
+	size_t n = 0;
+	for (int t = 0; t < g_num_threads; ++t) n += (size_t)top_board_read(&g_top_boards[t], all + n);
+	qsort(all, n, sizeof *all, top_entry_cmp);
+	if (n > (size_t)g_top_k) n = (size_t)g_top_k;
+	uint64_t sig = 1469598103934665603ULL; // FNV-1a over the shown entries
+	for (size_t i = 0; i < n; ++i) for (int j = 0; j < 32; ++j) sig = (sig ^ all[i].pub[j]) * 1099511628211ULL;
+	if (n && (final || sig != last_sig)) {
+		last_sig = sig;
+		if (!final) fprintf(stderr, "Top %zu so far:\n", n);
+		for (size_t i = 0, shown = 0; i < n; ++i) {
+			// Board entries skip the per-key checks (walk secrets are not re-derived when offered),
+			// so the secret is checked against OpenSSL here, once per printed entry
+			unsigned char ref_pub[32];
+			if (!x25519_pub_openssl(ref_pub, all[i].sk) || memcmp(ref_pub, all[i].pub, 32) != 0) {
+				fprintf(stderr, "Top: OpenSSL re-derivation mismatch, entry dropped\n");
+				continue;
+			}
+			char b64_pub[BASE64_LEN + 1], b64_priv[BASE64_LEN + 1];
+			base64_encode_32(all[i].pub, b64_pub);
+			base64_encode_32(all[i].sk, b64_priv);
+			fprintf(stderr, "TOP %zu: score=%d pub=%s priv=%s\n", ++shown, all[i].score, b64_pub, b64_priv);
+			if (final) printf("TOP %zu: score=%d pub=%s priv=%s\n", shown, all[i].score, b64_pub, b64_priv);
+		}
+		fflush(stdout); fflush(stderr);
+	}
+	free(all);
+}
+
+// --- --checkpoint / --resume ---
+// A --seed run is fully described by each thread's stream position (plus the walk it is on), so
+// the state file holds those, the counters and a fingerprint of the search. It is rewritten
+// atomically (temp file, fsync, rename) from the reporter every MEKG_CHECKPOINT_SEC seconds
+// (default 60) and once more after the workers stop.
+struct keygen_progress {
+	_Alignas(64) _Atomic unsigned seq;
+	int walk_active;
+	unsigned long long pos;       // next stream key index
+	unsigned long long keys;      // keys checked by this thread in this run
+	unsigned long long walk_idx, walk_step;
+};
+static struct keygen_progress *g_progress = NULL; // one per worker thread
+static struct keygen_progress *g_resume = NULL;   // --resume: loaded positions
+static unsigned long long g_resume_keys = 0;      // keys checked before this run
+static unsigned g_checkpoint_sec = 60;
+
+// FNV-1a over everything that decides which keys match and how stream indices are used
+static unsigned long long search_fingerprint(void) {
+	unsigned long long h = 1469598103934665603ULL;
+	#define FP_BYTES(p, n) do { const unsigned char *b_ = (const unsigned char *)(p); \
+		for (size_t k_ = 0; k_ < (size_t)(n); ++k_) h = (h ^ b_[k_]) * 1099511628211ULL; } while (0)
+	for (size_t i = 0; i < g_patterns_count; ++i) {
+		const struct search_pattern *sp = &g_patterns[i];
+		if (sp->prefix) FP_BYTES(sp->prefix, sp->prefix_len);
+		FP_BYTES("|", 1);
+		if (sp->suffix) FP_BYTES(sp->suffix, sp->suffix_len);
+		FP_BYTES("|", 1);
+		if (sp->infix) FP_BYTES(sp->infix, sp->infix_len);
+		FP_BYTES(";", 1);
+	}
+	if (g_wordlist.map) FP_BYTES(g_wordlist.map, g_wordlist.map_len);
+	FP_BYTES(&g_ignore_case, sizeof g_ignore_case);
+	FP_BYTES(&g_incremental, sizeof g_incremental);
+	#undef FP_BYTES
+	return h;
+}
+
+static int checkpoint_write(void) {
+	if (!g_checkpoint_path || !g_progress) return 0;
+	char tmp[4096];
+	if (snprintf(tmp, sizeof tmp, "%s.tmp", g_checkpoint_path) >= (int)sizeof tmp) return -1;
+	// Owner-only: the stream key in the file regenerates every key of the run
+	int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	FILE *f = fd >= 0 ? fdopen(fd, "w") : NULL;
+	if (!f) { fprintf(stderr, "Checkpoint: cannot write %s: %s\n", tmp, strerror(errno)); if (fd >= 0) close(fd); return -1; }
+	struct keygen_progress *snap = (struct keygen_progress *)calloc((size_t)g_num_threads, sizeof *snap);
+	if (!snap) { fclose(f); return -1; }
+	unsigned long long keys = g_resume_keys;
+	for (int t = 0; t < g_num_threads; ++t) {
+		struct keygen_progress *pr = &g_progress[t];
+		for (;;) {
+			unsigned s0 = atomic_load_explicit(&pr->seq, memory_order_acquire);
+			if (s0 & 1u) { sched_yield(); continue; }
+			snap[t].pos = pr->pos; snap[t].keys = pr->keys; snap[t].walk_active = pr->walk_active;
+			snap[t].walk_idx = pr->walk_idx; snap[t].walk_step = pr->walk_step;
+			atomic_thread_fence(memory_order_acquire);
+			if (atomic_load_explicit(&pr->seq, memory_order_relaxed) == s0) break;
+		}
+		keys += snap[t].keys;
+	}
+	char hex[65];
+	hex_encode_32(g_seed_key, hex);
+	fprintf(f, "# meshtastic_keygen checkpoint\nversion=2\n");
+	if (g_seed_random) fprintf(f, "key=%s\n", hex);
+	else fprintf(f, "seed=%llu\n", g_seed);
+	fprintf(f, "threads=%d\nsearch=%016llx\nkeys=%llu\nfound=%llu\n",
+		g_num_threads, search_fingerprint(), keys, atomic_load_explicit(&g_found_count, memory_order_relaxed));
+	for (int t = 0; t < g_num_threads; ++t)
+		fprintf(f, "thread=%d pos=%llu walk=%d:%llu:%llu\n", t, snap[t].pos, snap[t].walk_active, snap[t].walk_idx, snap[t].walk_step);
+	free(snap);
+	int ok = fflush(f) == 0 && fsync(fileno(f)) == 0;
+	ok = fclose(f) == 0 && ok;
+	if (!ok || rename(tmp, g_checkpoint_path) != 0) {
+		fprintf(stderr, "Checkpoint: cannot write %s: %s\n", g_checkpoint_path, strerror(errno));
+		remove(tmp);
+		return -1;
+	}
+	return 0;
+}
+
+static void checkpoint_tick(void) {
+	static struct timespec last;
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (last.tv_sec == 0) last = now;
+	if (now.tv_sec - last.tv_sec < (time_t)g_checkpoint_sec) return;
+	last = now;
+	checkpoint_write();
+}
+
+// Load a state file written by checkpoint_write; the search fingerprint is checked by the caller
+// once the patterns exist. Sets the stream key (seed=S, or key=HEX from version 2), thread count
+// and counters.
+static int checkpoint_load(const char *path, unsigned long long *fingerprint) {
+	FILE *f = fopen(path, "r");
+	if (!f) { fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno)); return -1; }
+	char line[256];
+	int version = 0, threads = 0, have_seed = 0, seen = 0;
+	unsigned long long found = 0;
+	while (fgets(line, sizeof line, f)) {
+		int tid, wa;
+		unsigned long long pos, wi, ws;
+		if (line[0] == '#' || line[0] == '\n') continue;
+		if (sscanf(line, "version=%d", &version) == 1) continue;
+		if (sscanf(line, "seed=%llu", &g_seed) == 1) { seed_key_from_u64(g_seed, g_seed_key); have_seed = 1; continue; }
+		if (strncmp(line, "key=", 4) == 0 && hex_decode_32(line + 4, g_seed_key) == 0) { g_seed_random = 1; have_seed = 1; continue; }
+		if (sscanf(line, "search=%llx", fingerprint) == 1) continue;
+		if (sscanf(line, "keys=%llu", &g_resume_keys) == 1) continue;
+		if (sscanf(line, "found=%llu", &found) == 1) continue;
+		if (sscanf(line, "threads=%d", &threads) == 1) {
+			if (threads <= 0 || threads > 65535 || g_resume) break;
+			g_resume = (struct keygen_progress *)calloc((size_t)threads, sizeof *g_resume);
+			if (!g_resume) break;
+			continue;
+		}
+		if (sscanf(line, "thread=%d pos=%llu walk=%d:%llu:%llu", &tid, &pos, &wa, &wi, &ws) == 5 &&
+		    g_resume && tid >= 0 && tid < threads) {
+			g_resume[tid].pos = pos; g_resume[tid].walk_active = wa;
+			g_resume[tid].walk_idx = wi; g_resume[tid].walk_step = ws;
+			seen++;
+			continue;
+		}
+		break; // unknown line
+	}
+	fclose(f);
+	if ((version != 1 && version != 2) || !have_seed || !g_resume || seen != threads) {
+		fprintf(stderr, "%s is not a usable checkpoint file\n", path);
+		return -1;
+	}
+	g_seeded = 1;
+	g_num_threads = threads;
+	atomic_store_explicit(&g_found_count, found, memory_order_relaxed);
+	return 0;
+}
+
+// --- Multi-process sharding (--coordinator ADDR / --worker ADDR) ---
+// Workers run the usual seeded search on a shard of stream ids handed out by the coordinator, so
+// no two processes ever draw the same secret (and with --seed S every FOUND record is replayable
+// with --regen). ADDR is HOST:PORT (TCP) or unix:PATH. The protocol is line-based text:
+//   worker -> coordinator: HELLO 2 <search fingerprint> <threads>, then KEYS <delta> and FOUND: ... lines
+//   coordinator -> worker: SHARD <stream key hex> <first stream id> [<seed S>], ERR <reason>, STOP
+// The stream key is 256 random bits unless --seed S was given; like the FOUND lines it travels in
+// the clear, so the link has to be trusted.
+#define COORD_MAX_WORKERS 256
+#define COORD_LINE_MAX 512
+static pthread_mutex_t g_worker_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int net_send_all(int fd, const char *buf, size_t n) {
+	while (n) {
+		ssize_t w = send(fd, buf, n, MSG_NOSIGNAL);
+		if (w < 0 && errno == EINTR) continue;
+		if (w <= 0) return -1;
+		buf += w; n -= (size_t)w;
+	}
+	return 0;
+}
+
+// Open a listening (listen=1) or connected socket for HOST:PORT or unix:PATH; -1 with a message on error
+static int net_open(const char *addr, int listen_mode) {
+	if (strncmp(addr, "unix:", 5) == 0) {
+		struct sockaddr_un sa;
+		memset(&sa, 0, sizeof sa);
+		sa.sun_family = AF_UNIX;
+		if (strlen(addr + 5) >= sizeof sa.sun_path) { fprintf(stderr, "Socket path too long: %s\n", addr + 5); return -1; }
+		strcpy(sa.sun_path, addr + 5);
+		int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd < 0) { perror("socket"); return -1; }
+		if (listen_mode) unlink(sa.sun_path);
+		int rc = listen_mode ? bind(fd, (struct sockaddr *)&sa, sizeof sa) : connect(fd, (struct sockaddr *)&sa, sizeof sa);
+		if (rc != 0 || (listen_mode && listen(fd, 64) != 0)) {
+			fprintf(stderr, "%s %s: %s\n", listen_mode ? "Cannot listen on" : "Cannot connect to", addr, strerror(errno));
+			close(fd);
+			return -1;
+		}
+		return fd;
+	}
+	char host[256];
+	const char *colon = strrchr(addr, ':');
+	if (!colon || colon == addr || (size_t)(colon - addr) >= sizeof host) { fprintf(stderr, "Bad address %s (want HOST:PORT or unix:PATH)\n", addr); return -1; }
+	memcpy(host, addr, (size_t)(colon - addr));
+	host[colon - addr] = '\0';
+	struct addrinfo hints, *res = NULL, *ai;
+	memset(&hints, 0, sizeof hints);
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	if (listen_mode) hints.ai_flags = AI_PASSIVE;
+	int gai = getaddrinfo(strcmp(host, "*") ? host : NULL, colon + 1, &hints, &res);
+	if (gai != 0) { fprintf(stderr, "Cannot resolve %s: %s\n", addr, gai_strerror(gai)); return -1; }
+	int fd = -1;
+	for (ai = res; ai && fd < 0; ai = ai->ai_next) {
+		fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+		if (fd < 0) continue;
+		int one = 1;
+		if (listen_mode) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+		int rc = listen_mode ? bind(fd, ai->ai_addr, ai->ai_addrlen) : connect(fd, ai->ai_addr, ai->ai_addrlen);
+		if (rc != 0 || (listen_mode && listen(fd, 64) != 0)) { close(fd); fd = -1; }
+	}
+	freeaddrinfo(res);
+	if (fd < 0) fprintf(stderr, "%s %s: %s\n", listen_mode ? "Cannot listen on" : "Cannot connect to", addr, strerror(errno));
+	return fd;
+}
+
+// Pop one '\n'-terminated line from buf/len into out (NUL-terminated, newline dropped); 0 if none yet
+static int net_take_line(char *buf, size_t *len, char *out, size_t out_cap) {
+	char *nl = memchr(buf, '\n', *len);
+	if (!nl) return 0;
+	size_t n = (size_t)(nl - buf);
+	size_t c = n < out_cap - 1 ? n : out_cap - 1;
+	memcpy(out, buf, c);
+	out[c] = '\0';
+	memmove(buf, nl + 1, *len - n - 1);
+	*len -= n + 1;
+	return 1;
+}
+
+static void worker_send_found(const char *line) {
+	pthread_mutex_lock(&g_worker_lock);
+	if (g_worker_fd >= 0) net_send_all(g_worker_fd, line, strlen(line));
+	pthread_mutex_unlock(&g_worker_lock);
+}
+
+// Worker side of the handshake: announce the search and thread count, adopt the assigned shard
+static int worker_connect(const char *addr) {
+	int fd = net_open(addr, 0);
+	if (fd < 0) return -1;
+	char msg[COORD_LINE_MAX], buf[COORD_LINE_MAX];
+	size_t len = 0;
+	snprintf(msg, sizeof msg, "HELLO 2 %016llx %d\n", search_fingerprint(), g_num_threads);
+	if (net_send_all(fd, msg, strlen(msg)) != 0) { fprintf(stderr, "Coordinator %s closed the connection\n", addr); close(fd); return -1; }
+	while (!net_take_line(buf, &len, msg, sizeof msg)) {
+		ssize_t r = recv(fd, buf + len, sizeof buf - len, 0);
+		if (r < 0 && errno == EINTR) continue;
+		if (r <= 0 || (len += (size_t)r) == sizeof buf) { fprintf(stderr, "Coordinator %s closed the connection\n", addr); close(fd); return -1; }
+	}
+	char key_hex[80];
+	int fields = sscanf(msg, "SHARD %79s %u %llu", key_hex, &g_stream_base, &g_seed);
+	if (fields < 2 || strlen(key_hex) != 64 || hex_decode_32(key_hex, g_seed_key) != 0) {
+		fprintf(stderr, "Coordinator refused this worker: %s\n", msg);
+		close(fd);
+		return -1;
+	}
+	g_seeded = 1;
+	g_seed_random = fields == 2;
+	g_worker_fd = fd;
+	return 0;
+}
+
+// Worker link thread: forwards key counts once a second and turns STOP (or a lost coordinator)
+// into g_stop; FOUND lines are sent by report_found directly
+static void *worker_link(void *arg) {
+	(void)arg;
+	unsigned long long sent = 0;
+	char buf[COORD_LINE_MAX], line[COORD_LINE_MAX];
+	size_t len = 0;
+	while (!atomic_load(&g_stop.flag)) {
+		struct pollfd pfd = { .fd = g_worker_fd, .events = POLLIN, .revents = 0 };
+		int pr = poll(&pfd, 1, 1000);
+		if (pr > 0) {
+			ssize_t r = recv(g_worker_fd, buf + len, sizeof buf - len, 0);
+			if (r <= 0 && !(r < 0 && errno == EINTR)) {
+				fprintf(stderr, "Coordinator connection lost; stopping\n");
+				atomic_store(&g_stop.flag, 1);
+				break;
+			}
+			if (r > 0) len += (size_t)r;
+			while (net_take_line(buf, &len, line, sizeof line))
+				if (strcmp(line, "STOP") == 0) atomic_store(&g_stop.flag, 1);
+			if (len == sizeof buf) len = 0; // garbage without newlines
+		}
+		unsigned long long total = keys_total();
+		if (total != sent) {
+			char msg[64];
+			snprintf(msg, sizeof msg, "KEYS %llu\n", total - sent);
+			pthread_mutex_lock(&g_worker_lock);
+			net_send_all(g_worker_fd, msg, strlen(msg));
+			pthread_mutex_unlock(&g_worker_lock);
+			sent = total;
+		}
+	}
+	return (void *)(uintptr_t)sent;
+}
+
+// Final key count and close; called after the workers and the link thread are joined
+static void worker_finish(unsigned long long sent) {
+	unsigned long long total = keys_total();
+	char msg[64];
+	snprintf(msg, sizeof msg, "KEYS %llu\n", total - sent);
+	if (total != sent) net_send_all(g_worker_fd, msg, strlen(msg));
+	close(g_worker_fd);
+	g_worker_fd = -1;
+}
+
+struct coord_peer {
+	int fd;
+	int threads;        // 0 until HELLO
+	unsigned base;
+	size_t len;
+	char buf[COORD_LINE_MAX];
+};
+
+static void coord_drop(struct coord_peer *p, const char *why) {
+	if (p->threads) fprintf(stderr, "Worker streams %u..%u left (%s)\n", p->base, p->base + (unsigned)p->threads - 1, why);
+	close(p->fd);
+	p->fd = -1;
+}
+
+// Coordinator: hand out disjoint stream-id shards, sum KEYS into g_key_count, print FOUND lines up to
+// -c and then send STOP to every worker. Runs until the target is met or SIGINT/SIGTERM; the
+// reporter thread prints the aggregate rate as for a local run.
+static int run_coordinator(const char *addr) {
+	int lfd = net_open(addr, 1);
+	if (lfd < 0) return 1;
+	static struct coord_peer peers[COORD_MAX_WORKERS];
+	int npeers = 0;
+	unsigned next_base = 0;
+	unsigned long long fp = search_fingerprint();
+	char key_hex[65];
+	hex_encode_32(g_seed_key, key_hex);
+	if (g_seed_random) fprintf(stderr, "Coordinator: listening on %s (random 256-bit stream key)\n", addr);
+	else fprintf(stderr, "Coordinator: listening on %s (seed=%llu)\n", addr, g_seed);
+	int stopping = 0;
+	struct timespec stop_at = {0, 0};
+	for (;;) {
+		if (!stopping && atomic_load(&g_stop.flag)) {
+			stopping = 1;
+			clock_gettime(CLOCK_MONOTONIC, &stop_at);
+			for (int i = 0; i < npeers; ++i) if (peers[i].fd >= 0) net_send_all(peers[i].fd, "STOP\n", 5);
+		}
+		int live = 0;
+		for (int i = 0; i < npeers; ++i) live += peers[i].fd >= 0;
+		if (stopping) {
+			// Give workers a moment to send their last KEYS and hang up
+			struct timespec now;
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			if (live == 0 || now.tv_sec - stop_at.tv_sec >= 3) break;
+		}
+		struct pollfd pfd[COORD_MAX_WORKERS + 1];
+		int map[COORD_MAX_WORKERS + 1], n = 0;
+		if (!stopping && npeers < COORD_MAX_WORKERS) { pfd[n].fd = lfd; pfd[n].events = POLLIN; map[n++] = -1; }
+		for (int i = 0; i < npeers; ++i) if (peers[i].fd >= 0) { pfd[n].fd = peers[i].fd; pfd[n].events = POLLIN; map[n++] = i; }
+		if (poll(pfd, (nfds_t)n, 200) <= 0) continue;
+		for (int k = 0; k < n; ++k) {
+			if (!pfd[k].revents) continue;
+			if (map[k] < 0) {
+				int cfd = accept(lfd, NULL, NULL);
+				if (cfd < 0) continue;
+				struct coord_peer *p = NULL;
+				for (int i = 0; i < npeers && !p; ++i) if (peers[i].fd < 0) p = &peers[i];
+				if (!p) p = &peers[npeers++];
+				memset(p, 0, sizeof *p);
+				p->fd = cfd;
+				continue;
+			}
+			struct coord_peer *p = &peers[map[k]];
+			ssize_t r = recv(p->fd, p->buf + p->len, sizeof p->buf - p->len, 0);
+			if (r <= 0) { if (!(r < 0 && errno == EINTR)) coord_drop(p, "disconnected"); continue; }
+			p->len += (size_t)r;
+			char line[COORD_LINE_MAX];
+			while (p->fd >= 0 && net_take_line(p->buf, &p->len, line, sizeof line)) {
+				unsigned long long v, wfp;
+				int threads;
+				if (!p->threads) {
+					char reply[128];
+					if (sscanf(line, "HELLO 2 %llx %d", &wfp, &threads) != 2 || threads <= 0 || threads > 65535) {
+						net_send_all(p->fd, "ERR bad hello\n", 14); coord_drop(p, "bad hello");
+					} else if (wfp != fp) {
+						net_send_all(p->fd, "ERR search options differ from the coordinator\n", 48); coord_drop(p, "search mismatch");
+					} else if (next_base > UINT32_MAX - (unsigned)threads) {
+						net_send_all(p->fd, "ERR out of streams\n", 19); coord_drop(p, "out of streams");
+					} else {
+						p->threads = threads; p->base = next_base; next_base += (unsigned)threads;
+						if (g_seed_random) snprintf(reply, sizeof reply, "SHARD %s %u\n", key_hex, p->base);
+						else snprintf(reply, sizeof reply, "SHARD %s %u %llu\n", key_hex, p->base, g_seed);
+						net_send_all(p->fd, reply, strlen(reply));
+						fprintf(stderr, "Worker joined: %d threads, streams %u..%u\n", threads, p->base, p->base + (unsigned)threads - 1);
+						if (stopping) net_send_all(p->fd, "STOP\n", 5);
 					}
+				} else if (sscanf(line, "KEYS %llu", &v) == 1) {
+					atomic_fetch_add_explicit(&g_key_count, v, memory_order_relaxed);
+				} else if (strncmp(line, "FOUND: ", 7) == 0) {
+					// Extra hits that raced the STOP are dropped so exactly -c are reported
+					unsigned long long cur = atomic_load_explicit(&g_found_count, memory_order_relaxed);
+					if (cur >= g_found_target) continue;
+					printf("%s\n", line);
+					fprintf(stderr, "%s\n", line);
+					fflush(stdout); fflush(stderr);
+					if (cur + 1 >= g_found_target) atomic_store(&g_stop.flag, 1);
+					atomic_store_explicit(&g_found_count, cur + 1, memory_order_relaxed);
 				}
 			}
-			local_cnt += (unsigned long long)N;
-			if (local_cnt >= 4096ULL) { atomic_fetch_add_explicit(&g_key_count, local_cnt, memory_order_relaxed); local_cnt = 0; }
-			rand_off += need;
-			if (atomic_load_explicit(&g_stop, memory_order_relaxed)) break;
-			continue; // proceed to next batch
-		}
-
-		// Optional: batched internal ladder path with single batch inversion
-		if (g_use_internal && g_cpu_batch > 1) {
-			int N = g_cpu_batch;
-			size_t need = (size_t)N * 32;
-			size_t remain = sizeof(rand_buf) - rand_off;
-			if (remain < need) {
-				// Refill to satisfy one full batch in a single buffer slice
-				chacha20_next(&drbg, rand_buf, sizeof(rand_buf));
-				rand_off = 0;
+			if (p->fd >= 0 && p->len == sizeof p->buf) coord_drop(p, "line too long");
+		}
+	}
+	for (int i = 0; i < npeers; ++i) if (peers[i].fd >= 0) close(peers[i].fd);
+	close(lfd);
+	if (strncmp(addr, "unix:", 5) == 0) unlink(addr + 5);
+	return 0;
+}
+
+// --- Job daemon (--serve ADDR / --submit ADDR) ---
+// One warm worker pool matches every key against the union of all running jobs' patterns; each
+// pattern records its job, and a hit is re-checked per pattern so it reaches every job it
+// satisfies. Whenever a job starts or ends the daemon publishes a new pattern set, which the
+// workers pick up at their next batch boundary. With no jobs the workers are parked
+// (serve_pause/serve_resume) instead of matching against nothing. A client sends
+//   search STR | contains STR (repeatable), count N, deadline SEC, go
+// and receives OK job=ID, its FOUND lines, then DONE found=N keys=K reason=count|deadline|shutdown.
+// Every line for a client is queued on its job and only the daemon's poll loop writes to sockets,
+// without blocking and never under g_serve_lock; a client that lets SERVE_OUT_MAX bytes pile up
+// is dropped, so a stalled reader cannot hold up the workers or the other jobs.
+#define SERVE_MAX_JOBS 64
+#define SERVE_OUT_MAX (64 * 1024) // queued bytes per client before it counts as stalled
+#define SERVE_CLOSE_SEC 5         // how long a finished job may take to drain its last lines
+static int search_has_only_b64_chars(const char *s);
+static int add_search_string(const char *s);
+static int add_infix_pattern(const char *s);
+enum { JOB_FREE = 0, JOB_SPEC, JOB_READY, JOB_RUNNING, JOB_DONE, JOB_CLOSING };
+struct serve_job {
+	int state;
+	int fd;
+	unsigned id;
+	unsigned long long count, found, keys_start;
+	unsigned deadline_sec;
+	struct timespec started;
+	time_t closing_since;        // JOB_CLOSING: when the last line was queued
+	const char *reason;          // why it ended (JOB_DONE)
+	char **strs;                 // "s STR" / "c STR" as received
+	size_t n_strs;
+	size_t len;
+	char buf[COORD_LINE_MAX];
+	char *out;                   // queued for the client; appended under g_serve_lock
+	size_t out_len, out_cap;
+	char *wbuf;                  // daemon only: taken from out, being sent
+	size_t w_len, w_off, w_cap;
+	int drop;                    // client gone or stalled: close without flushing
+};
+static struct serve_job g_jobs[SERVE_MAX_JOBS];
+static pthread_mutex_t g_serve_lock = PTHREAD_MUTEX_INITIALIZER; // job states, found counts, output queues
+static int g_serve_wake[2] = {-1, -1};                          // worker -> daemon: output queued or a job finished
+
+// Worker parking: the daemon raises g_pause_req and waits until every worker sits in serve_park
+static _Atomic int g_pause_req = 0;
+static int g_parked = 0, g_serve_workers = 0;
+static pthread_mutex_t g_pause_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_parked_cv = PTHREAD_COND_INITIALIZER, g_resume_cv = PTHREAD_COND_INITIALIZER;
+
+static void serve_pause(void) {
+	pthread_mutex_lock(&g_pause_lock);
+	atomic_store(&g_pause_req, 1);
+	while (g_parked < g_serve_workers && !atomic_load(&g_stop.flag)) pthread_cond_wait(&g_parked_cv, &g_pause_lock);
+	pthread_mutex_unlock(&g_pause_lock);
+}
+
+static void serve_resume(void) {
+	pthread_mutex_lock(&g_pause_lock);
+	atomic_store(&g_pause_req, 0);
+	pthread_cond_broadcast(&g_resume_cv);
+	pthread_mutex_unlock(&g_pause_lock);
+}
+
+// Queue a line for a job's client; caller holds g_serve_lock. A client that has not taken
+// SERVE_OUT_MAX bytes is marked to be dropped instead of growing the queue further.
+static void serve_queue(struct serve_job *j, const char *s, size_t n) {
+	if (j->drop || j->fd < 0) return;
+	if (j->out_len + n > j->out_cap) {
+		size_t cap = j->out_cap ? j->out_cap : 1024;
+		while (cap < j->out_len + n) cap *= 2;
+		char *o = j->out_len + n <= SERVE_OUT_MAX ? (char *)realloc(j->out, cap) : NULL;
+		if (!o) { j->drop = 1; return; }
+		j->out = o; j->out_cap = cap;
+	}
+	memcpy(j->out + j->out_len, s, n);
+	j->out_len += n;
+}
+
+// Send what a client has queued without blocking; daemon thread only, called without
+// g_serve_lock. Returns -1 when the client is gone.
+static int serve_flush(struct serve_job *j) {
+	pthread_mutex_lock(&g_serve_lock);
+	if (j->fd < 0 || j->drop) { pthread_mutex_unlock(&g_serve_lock); return 0; }
+	if (j->w_off == j->w_len && j->out_len) {
+		char *b = j->wbuf; size_t c = j->w_cap;
+		j->wbuf = j->out; j->w_cap = j->out_cap; j->w_len = j->out_len; j->w_off = 0;
+		j->out = b; j->out_cap = c; j->out_len = 0;
+	}
+	pthread_mutex_unlock(&g_serve_lock);
+	while (j->w_off < j->w_len) {
+		ssize_t w = send(j->fd, j->wbuf + j->w_off, j->w_len - j->w_off, MSG_NOSIGNAL | MSG_DONTWAIT);
+		if (w < 0 && errno == EINTR) continue;
+		if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+		if (w <= 0) return -1;
+		j->w_off += (size_t)w;
+	}
+	return 0;
+}
+
+// Sink for --serve: deliver the key to every running job with a matching pattern in the set the
+// key was matched against
+static void serve_found(const struct key_match *m, const unsigned char priv[32]) {
+	const struct pattern_set *ps = m->set;
+	uint64_t w[4], be[5];
+	memcpy(w, m->pub, 32);
+	key_words_be(m->pub, be);
+	char b64_priv[BASE64_LEN + 1], line[160];
+	base64_encode_32(priv, b64_priv);
+	int n = snprintf(line, sizeof line, "FOUND: pub=%s priv=%s\n", m->b64_pub, b64_priv);
+	unsigned char sent[SERVE_MAX_JOBS] = {0};
+	int queued = 0;
+	pthread_mutex_lock(&g_serve_lock);
+	for (size_t i = 0; i < ps->count; ++i) {
+		const struct search_pattern *sp = &ps->pats[i];
+		struct serve_job *j = &g_jobs[sp->job];
+		if (sent[sp->job] || j->state != JOB_RUNNING || j->id != sp->job_id || !pattern_matches(sp, w, be)) continue;
+		sent[sp->job] = 1;
+		queued = 1;
+		serve_queue(j, line, (size_t)n);
+		if (j->drop) { j->state = JOB_DONE; j->reason = "stalled"; }
+		else if (++j->found >= j->count) { j->state = JOB_DONE; j->reason = "count"; }
+	}
+	pthread_mutex_unlock(&g_serve_lock);
+	// Wake the daemon to flush; the pipe is non-blocking, and a full pipe already means a wake-up
+	if (queued && write(g_serve_wake[1], "x", 1) < 0) { /* the daemon also polls */ }
+	atomic_fetch_add_explicit(&g_found_count, 1ULL, memory_order_relaxed);
+}
+
+static void serve_job_free(struct serve_job *j) {
+	for (size_t i = 0; i < j->n_strs; ++i) free(j->strs[i]);
+	free(j->strs);
+	free(j->out);
+	free(j->wbuf);
+	if (j->fd >= 0) close(j->fd);
+	memset(j, 0, sizeof *j);
+	j->fd = -1;
+}
+
+// Why a "search STR" / "contains STR" from a client or pattern file is unusable, NULL if it is fine
+static const char *pattern_spec_error(const char *str, int infix) {
+	if (!search_has_only_b64_chars(str)) return "pattern must be Base64 characters or '?'";
+	if (infix && strlen(str) > INFIX_MAX_LEN) return "contains pattern too long";
+	return NULL;
+}
+
+// One spec line from a client; returns 1 on "go", 0 to keep reading, -1 after queueing ERR
+static int serve_job_line(struct serve_job *j, const char *line) {
+	const char *err = NULL;
+	unsigned long long v;
+	if (strncmp(line, "search ", 7) == 0 || strncmp(line, "contains ", 9) == 0) {
+		int infix = line[0] == 'c';
+		const char *str = line + (infix ? 9 : 7);
+		err = pattern_spec_error(str, infix);
+		if (!err) {
+			char **ns = (char **)realloc(j->strs, (j->n_strs + 1) * sizeof *ns);
+			size_t n = strlen(str);
+			char *e = ns ? (char *)malloc(n + 3) : NULL;
+			if (ns) j->strs = ns;
+			if (!e) err = "out of memory";
+			else { e[0] = infix ? 'c' : 's'; e[1] = ' '; memcpy(e + 2, str, n + 1); j->strs[j->n_strs++] = e; }
+		}
+	} else if (sscanf(line, "count %llu", &v) == 1 && v > 0) {
+		j->count = v;
+	} else if (sscanf(line, "deadline %llu", &v) == 1 && v > 0 && v < UINT_MAX) {
+		j->deadline_sec = (unsigned)v;
+	} else if (strcmp(line, "go") == 0) {
+		if (!j->n_strs) err = "no search or contains pattern";
+		else return 1;
+	} else {
+		err = "unknown line (want search, contains, count, deadline or go)";
+	}
+	if (!err) return 0;
+	char msg[128];
+	snprintf(msg, sizeof msg, "ERR %s\n", err);
+	serve_queue(j, msg, strlen(msg));
+	return -1;
+}
+
+// Publish a pattern set for the READY and RUNNING jobs; caller holds g_serve_lock
+static void serve_rebuild(void) {
+	patterns_clear();
+	unsigned long long keys = keys_total();
+	for (int k = 0; k < SERVE_MAX_JOBS; ++k) {
+		struct serve_job *j = &g_jobs[k];
+		if (j->state != JOB_READY && j->state != JOB_RUNNING) continue;
+		g_pattern_job = k;
+		g_pattern_job_id = j->id;
+		int rc = 0;
+		for (size_t i = 0; i < j->n_strs && rc == 0; ++i)
+			rc = j->strs[i][0] == 'c' ? add_infix_pattern(j->strs[i] + 2) : add_search_string(j->strs[i] + 2);
+		if (rc != 0) { j->state = JOB_DONE; j->reason = "error"; continue; }
+		if (j->state == JOB_READY) {
+			j->state = JOB_RUNNING;
+			j->keys_start = keys;
+			clock_gettime(CLOCK_MONOTONIC, &j->started);
+		}
+	}
+	pattern_set_rebuild();
+}
+
+static int run_serve(const char *addr) {
+	int lfd = net_open(addr, 1);
+	if (lfd < 0) return 1;
+	if (pipe(g_serve_wake) != 0) { perror("pipe"); close(lfd); return 1; }
+	for (int e = 0; e < 2; ++e) fcntl(g_serve_wake[e], F_SETFL, fcntl(g_serve_wake[e], F_GETFL) | O_NONBLOCK);
+	for (int k = 0; k < SERVE_MAX_JOBS; ++k) g_jobs[k].fd = -1;
+	fprintf(stderr, "Serving jobs on %s with %d threads\n", addr, g_num_threads);
+	unsigned next_id = 1;
+	int running = 0; // workers released (some job has patterns)
+	while (!atomic_load(&g_stop.flag)) {
+		struct pollfd pfd[SERVE_MAX_JOBS + 2];
+		int map[SERVE_MAX_JOBS + 2], n = 0;
+		pfd[n].fd = lfd; pfd[n].events = POLLIN; map[n++] = -1;
+		pfd[n].fd = g_serve_wake[0]; pfd[n].events = POLLIN; map[n++] = -2;
+		pthread_mutex_lock(&g_serve_lock);
+		for (int k = 0; k < SERVE_MAX_JOBS; ++k) {
+			struct serve_job *j = &g_jobs[k];
+			if (j->state == JOB_FREE || j->fd < 0 || j->drop) continue;
+			pfd[n].fd = j->fd; pfd[n].events = POLLIN;
+			if (j->w_off < j->w_len || j->out_len) pfd[n].events |= POLLOUT;
+			map[n++] = k;
+		}
+		pthread_mutex_unlock(&g_serve_lock);
+		int pr = poll(pfd, (nfds_t)n, 200);
+		int dirty = 0;
+		for (int q = 0; pr > 0 && q < n; ++q) {
+			if (!pfd[q].revents) continue;
+			if (map[q] == -2) { char tmp[64]; if (read(g_serve_wake[0], tmp, sizeof tmp) < 0) { /* drained */ } continue; }
+			if (map[q] == -1) {
+				int cfd = accept(lfd, NULL, NULL);
+				if (cfd < 0) continue;
+				int k = 0;
+				pthread_mutex_lock(&g_serve_lock);
+				while (k < SERVE_MAX_JOBS && g_jobs[k].state != JOB_FREE) ++k;
+				if (k < SERVE_MAX_JOBS) { g_jobs[k].state = JOB_SPEC; g_jobs[k].fd = cfd; g_jobs[k].count = 1; g_jobs[k].id = next_id++; }
+				pthread_mutex_unlock(&g_serve_lock);
+				if (k == SERVE_MAX_JOBS) {
+					if (send(cfd, "ERR too many jobs\n", 18, MSG_NOSIGNAL | MSG_DONTWAIT) < 0) { /* closing anyway */ }
+					close(cfd);
+				}
+				continue;
 			}
-			unsigned char *privs = rand_buf + rand_off;
-			// Ensure reusable buffers are large enough
-			if (batch_cap < N) {
-				fe *newX2 = (fe *)realloc(batch_X2, (size_t)N * sizeof(fe));
-				fe *newZ2 = (fe *)realloc(batch_Z2, (size_t)N * sizeof(fe));
-				fe *newZi = (fe *)realloc(batch_Zinv, (size_t)N * sizeof(fe));
-				if (!newX2 || !newZ2 || !newZi) {
-					if (newX2) batch_X2 = newX2; // keep best effort to avoid leak
-					if (newZ2) batch_Z2 = newZ2;
-					if (newZi) batch_Zinv = newZi;
-					break; // allocation failure; exit thread
+			struct serve_job *j = &g_jobs[map[q]];
+			if (!(pfd[q].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+			ssize_t r = recv(j->fd, j->buf + j->len, sizeof j->buf - j->len, MSG_DONTWAIT);
+			if (r < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) continue;
+			pthread_mutex_lock(&g_serve_lock);
+			if (r <= 0) {
+				// Client went away: the job is cancelled
+				j->drop = 1;
+				if (j->state == JOB_RUNNING || j->state == JOB_READY) { j->state = JOB_DONE; j->reason = "cancelled"; }
+				else if (j->state == JOB_SPEC) serve_job_free(j);
+			} else if (j->state == JOB_SPEC) {
+				j->len += (size_t)r;
+				char line[COORD_LINE_MAX];
+				int rc = 0;
+				while (rc == 0 && net_take_line(j->buf, &j->len, line, sizeof line)) rc = serve_job_line(j, line);
+				if (rc == 0 && j->len == sizeof j->buf) { serve_queue(j, "ERR line too long\n", 18); rc = -1; }
+				if (rc < 0) { j->state = JOB_CLOSING; j->closing_since = time(NULL); }
+				else if (rc > 0) {
+					char ok[48];
+					snprintf(ok, sizeof ok, "OK job=%u\n", j->id);
+					serve_queue(j, ok, strlen(ok));
+					j->state = JOB_READY;
+					dirty = 1;
 				}
-				batch_X2 = newX2; batch_Z2 = newZ2; batch_Zinv = newZi; batch_cap = N;
 			}
-			for (int i = 0; i < N; ++i) {
-				unsigned char *sk = privs + (size_t)i * 32;
-				// Clamp per RFC 7748
-				sk[0] &= 248; sk[31] &= 127; sk[31] |= 64;
-				ladder_get_x2z2(sk, &batch_X2[i], &batch_Z2[i]);
+			pthread_mutex_unlock(&g_serve_lock);
+		}
+		// Hand queued lines to the sockets; whatever does not fit waits for POLLOUT
+		for (int k = 0; k < SERVE_MAX_JOBS; ++k) {
+			struct serve_job *j = &g_jobs[k];
+			if (j->state == JOB_FREE || serve_flush(j) == 0) continue;
+			pthread_mutex_lock(&g_serve_lock);
+			j->drop = 1;
+			if (j->state == JOB_RUNNING || j->state == JOB_READY) { j->state = JOB_DONE; j->reason = "cancelled"; }
+			pthread_mutex_unlock(&g_serve_lock);
+		}
+		// Deadlines, finished jobs and drained or stalled clients
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		time_t wall = time(NULL);
+		pthread_mutex_lock(&g_serve_lock);
+		unsigned long long keys = keys_total();
+		for (int k = 0; k < SERVE_MAX_JOBS; ++k) {
+			struct serve_job *j = &g_jobs[k];
+			if (j->state == JOB_RUNNING && j->deadline_sec && now.tv_sec - j->started.tv_sec >= (time_t)j->deadline_sec) {
+				j->state = JOB_DONE; j->reason = "deadline";
 			}
-			fe_batch_invert(batch_Zinv, batch_Z2, N);
-			for (int i = 0; i < N; ++i) {
-				unsigned char *sk = privs + (size_t)i * 32;
-				fe X; fem(&X, &batch_X2[i], &batch_Zinv[i]);
-				fetobytes(pub_key, &X);
-				// Quick prefix/suffix prefilter on raw bytes to avoid base64 when obviously not matching
-				int likely_match = (g_patterns_count == 0);
-				if (!likely_match) {
-					unsigned char b0 = pub_key[0], b1 = pub_key[1], b2 = pub_key[2];
-					unsigned char p0 = (b0 >> 2) & 0x3F;
-					unsigned char p1 = ((b0 & 0x3) << 4) | (b1 >> 4); p1 &= 0x3F;
-					unsigned char p2 = ((b1 & 0xF) << 2) | (b2 >> 6); p2 &= 0x3F;
-					unsigned char p3 = b2 & 0x3F;
-					unsigned char e30 = pub_key[30], e31 = pub_key[31];
-					unsigned char s41 = (e30 >> 2) & 0x3F;
-					unsigned char s42 = ((e30 & 0x3) << 4) | (e31 >> 4); s42 &= 0x3F;
-					unsigned char s43 = ((e31 & 0xF) << 2); s43 &= 0x3F;
-					for (size_t k = 0; k < g_patterns_count && !likely_match; ++k) {
-						struct search_pattern *sp = &g_patterns[k]; int ok = 1;
-						if (sp->pre_mask_len) {
-							if (sp->pre_mask_len >= 1 && sp->pre_idx[0] != p0) ok = 0;
-							if (ok && sp->pre_mask_len >= 2 && sp->pre_idx[1] != p1) ok = 0;
-							if (ok && sp->pre_mask_len >= 3 && sp->pre_idx[2] != p2) ok = 0;
-							if (ok && sp->pre_mask_len >= 4 && sp->pre_idx[3] != p3) ok = 0;
-						}
-						if (ok && sp->suf_mask_len) {
-							if (sp->suf_mask_len >= 1 && sp->suf_idx[0] != s41) ok = 0;
-							if (ok && sp->suf_mask_len >= 2 && sp->suf_idx[1] != s42) ok = 0;
-							if (ok && sp->suf_mask_len >= 3 && sp->suf_idx[2] != s43) ok = 0;
-						}
-						if (ok) { likely_match = 1; break; }
-					}
-				}
-				if (likely_match) {
-					base64_encode_32(pub_key, b64_pub);
-					int matched = 0;
-					for (size_t k = 0; k < g_patterns_count; ++k) {
-						struct search_pattern *sp = &g_patterns[k];
-						if (sp->prefix_len > 0 && memcmp(b64_pub, sp->prefix, sp->prefix_len) == 0) { matched = 1; break; }
-						if (sp->suffix_len > 0 && memcmp(b64_pub + sp->suffix_off, sp->suffix, sp->suffix_len) == 0) { matched = 1; break; }
-					}
-					if (matched) {
-						base64_encode_32(sk, b64_priv);
-						printf("FOUND: pub=%s priv=%s\n", b64_pub, b64_priv);
-						fprintf(stderr, "FOUND: pub=%s priv=%s\n", b64_pub, b64_priv);
-						fflush(stdout); fflush(stderr);
-						unsigned long long cur = atomic_fetch_add_explicit(&g_found_count, 1ULL, memory_order_relaxed) + 1ULL;
-						if (cur >= g_found_target) { atomic_store_explicit(&g_stop, 1, memory_order_relaxed); }
-					}
+			if (j->state == JOB_CLOSING) {
+				int drained = j->w_off == j->w_len && !j->out_len;
+				if (drained || j->drop || wall - j->closing_since >= SERVE_CLOSE_SEC) serve_job_free(j);
+				continue;
+			}
+			if (j->state != JOB_DONE) continue;
+			char msg[128];
+			snprintf(msg, sizeof msg, "DONE found=%llu keys=%llu reason=%s\n", j->found, keys - j->keys_start, j->reason);
+			serve_queue(j, msg, strlen(msg));
+			fprintf(stderr, "Job %u done: found=%llu keys=%llu reason=%s\n", j->id, j->found, keys - j->keys_start, j->reason);
+			j->state = JOB_CLOSING;
+			j->closing_since = wall;
+			dirty = 1;
+		}
+		pthread_mutex_unlock(&g_serve_lock);
+		if (!dirty) { pattern_set_reclaim(); continue; }
+		// Swap the pattern set under the running workers; park them when no job is left
+		pthread_mutex_lock(&g_serve_lock);
+		serve_rebuild();
+		int active = 0;
+		for (int k = 0; k < SERVE_MAX_JOBS; ++k) active += g_jobs[k].state == JOB_RUNNING;
+		pthread_mutex_unlock(&g_serve_lock);
+		if (active && !running) serve_resume();
+		else if (!active && running) serve_pause();
+		running = active > 0;
+	}
+	// Shutdown: queue DONE for every client, give them a moment to drain, then release parked
+	// workers so they can see g_stop
+	unsigned long long keys = keys_total();
+	pthread_mutex_lock(&g_serve_lock);
+	for (int k = 0; k < SERVE_MAX_JOBS; ++k) {
+		struct serve_job *j = &g_jobs[k];
+		if (j->state == JOB_FREE || j->state == JOB_SPEC || j->state == JOB_CLOSING) continue;
+		char msg[128];
+		snprintf(msg, sizeof msg, "DONE found=%llu keys=%llu reason=shutdown\n", j->found, j->state == JOB_RUNNING ? keys - j->keys_start : 0ULL);
+		serve_queue(j, msg, strlen(msg));
+		j->state = JOB_CLOSING;
+	}
+	pthread_mutex_unlock(&g_serve_lock);
+	for (int tries = 0; tries < 10; ++tries) {
+		struct pollfd pfd[SERVE_MAX_JOBS];
+		int n = 0;
+		for (int k = 0; k < SERVE_MAX_JOBS; ++k) {
+			struct serve_job *j = &g_jobs[k];
+			if (j->state == JOB_FREE || j->fd < 0 || j->drop) continue;
+			if (serve_flush(j) != 0) { j->drop = 1; continue; }
+			if (j->w_off < j->w_len || j->out_len) { pfd[n].fd = j->fd; pfd[n].events = POLLOUT; pfd[n].revents = 0; ++n; }
+		}
+		if (!n || poll(pfd, (nfds_t)n, 100) < 0) break;
+	}
+	pthread_mutex_lock(&g_serve_lock);
+	for (int k = 0; k < SERVE_MAX_JOBS; ++k) if (g_jobs[k].state != JOB_FREE) serve_job_free(&g_jobs[k]);
+	pthread_mutex_unlock(&g_serve_lock);
+	serve_resume();
+	close(lfd);
+	if (strncmp(addr, "unix:", 5) == 0) unlink(addr + 5);
+	return 0;
+}
+
+// --submit: send one job to a --serve daemon and print what comes back; exit status 0 when the
+// job found its count
+static int run_submit(const char *addr, char **searches, size_t n_searches, char **contains, size_t n_contains, unsigned deadline) {
+	int fd = net_open(addr, 0);
+	if (fd < 0) return 1;
+	char line[COORD_LINE_MAX];
+	int ok = 1;
+	for (size_t i = 0; i < n_searches && ok; ++i) { snprintf(line, sizeof line, "search %s\n", searches[i]); ok = net_send_all(fd, line, strlen(line)) == 0; }
+	for (size_t i = 0; i < n_contains && ok; ++i) { snprintf(line, sizeof line, "contains %s\n", contains[i]); ok = net_send_all(fd, line, strlen(line)) == 0; }
+	snprintf(line, sizeof line, "count %llu\n", g_found_target);
+	if (ok) ok = net_send_all(fd, line, strlen(line)) == 0;
+	if (ok && deadline) { snprintf(line, sizeof line, "deadline %u\n", deadline); ok = net_send_all(fd, line, strlen(line)) == 0; }
+	if (ok) ok = net_send_all(fd, "go\n", 3) == 0;
+	char buf[COORD_LINE_MAX];
+	size_t len = 0;
+	unsigned long long found = 0;
+	int rc = 1;
+	while (ok) {
+		while (net_take_line(buf, &len, line, sizeof line)) {
+			if (strncmp(line, "FOUND: ", 7) == 0) { printf("%s\n", line); fflush(stdout); found++; continue; }
+			fprintf(stderr, "%s\n", line);
+			if (strncmp(line, "DONE ", 5) == 0) { rc = found >= g_found_target ? 0 : 3; ok = 0; break; }
+			if (strncmp(line, "ERR ", 4) == 0) { ok = 0; break; }
+		}
+		if (!ok) break;
+		struct pollfd pfd = { .fd = fd, .events = POLLIN, .revents = 0 };
+		if (poll(&pfd, 1, 500) <= 0) { if (atomic_load(&g_stop.flag)) break; continue; } // Ctrl-C cancels the job
+		ssize_t r = recv(fd, buf + len, sizeof buf - len, 0);
+		if (r < 0 && errno == EINTR) continue;
+		if (r <= 0) { fprintf(stderr, "Server closed the connection\n"); break; }
+		len += (size_t)r;
+		if (len == sizeof buf) len = 0;
+	}
+	close(fd);
+	return rc;
+}
+
+// --- Live pattern set (--pattern-file FILE, --control ADDR, --fleet) ---
+// A normal search whose targets change without restarting the workers. The active patterns are the
+// -s/--contains options, the "search STR" / "contains STR" lines of --pattern-file ('#' comments;
+// SIGHUP re-reads it) and whatever --control clients add. A client sends one command per line:
+//   search STR | contains STR            add a pattern
+//   drop search STR | drop contains STR  retire one
+//   reload                               re-read --pattern-file
+//   list                                 one line per pattern, then END
+// and gets OK patterns=N or ERR reason back. Every change compiles a new set and publishes it; the
+// workers keep their streams, counters and --top boards and switch at their next batch.
+//
+// --fleet: every spec is a target that needs exactly one key. The sink hands a key to the first
+// open target it matches, marks it done and wakes the control thread, which compiles the set
+// without it; keys a worker still finds on the old set for a done target are dropped. The run
+// stops when no target is open and prints one TARGET line per target.
+#define LIVE_MAX_CLIENTS 8
+struct live_spec {
+	char *str;
+	unsigned char infix;     // --contains / "contains STR"
+	unsigned char from_file; // replaced when --pattern-file is re-read
+	unsigned id;             // stable; compiled into search_pattern.job_id (--fleet: index in g_fleet)
+};
+static struct live_spec *g_live = NULL;
+static size_t g_live_count = 0, g_live_cap = 0;
+static unsigned g_live_next_id = 0;
+static const char *g_pattern_file = NULL;
+static int g_control_fd = -1;
+static int g_live_wake[2] = {-1, -1}; // sink -> control thread: a --fleet target was satisfied
+static _Atomic int g_reload_req = 0; // SIGHUP
+
+enum { FLEET_OPEN = 0, FLEET_DONE, FLEET_DROPPED };
+struct fleet_target {
+	char *str;
+	unsigned char infix;
+	int state;
+	unsigned long long keys_start; // g_key_count when the target was added
+	unsigned long long keys;       // keys checked until it was satisfied (or dropped)
+	char b64_pub[BASE64_LEN + 1], b64_priv[BASE64_LEN + 1];
+};
+static int g_fleet_mode = 0;
+static struct fleet_target *g_fleet = NULL; // indexed by live_spec.id; grows, never shrinks
+static size_t g_fleet_count = 0, g_fleet_cap = 0, g_fleet_open = 0;
+static pthread_mutex_t g_fleet_lock = PTHREAD_MUTEX_INITIALIZER; // g_fleet: sinks and control thread
+
+// Close an open target (done or dropped); stops the run when it was the last one. Caller holds g_fleet_lock.
+static void fleet_close_locked(struct fleet_target *ft, int state) {
+	if (ft->state != FLEET_OPEN) return;
+	ft->state = state;
+	ft->keys = keys_total() - ft->keys_start;
+	if (--g_fleet_open == 0) atomic_store(&g_stop.flag, 1);
+}
+
+static int live_add(const char *str, int infix, int from_file) {
+	if (g_live_count == g_live_cap) {
+		size_t new_cap = g_live_cap ? g_live_cap * 2 : 8;
+		void *np = realloc(g_live, new_cap * sizeof *g_live);
+		if (!np) return -1;
+		g_live = (struct live_spec *)np;
+		g_live_cap = new_cap;
+	}
+	char *d = strdup(str);
+	if (!d) return -1;
+	if (g_fleet_mode) {
+		pthread_mutex_lock(&g_fleet_lock);
+		int ok = 1;
+		if (g_fleet_count == g_fleet_cap) {
+			size_t new_cap = g_fleet_cap ? g_fleet_cap * 2 : 8;
+			void *np = realloc(g_fleet, new_cap * sizeof *g_fleet);
+			if (np) { g_fleet = (struct fleet_target *)np; g_fleet_cap = new_cap; } else ok = 0;
+		}
+		char *fd = ok ? strdup(str) : NULL;
+		if (fd) {
+			struct fleet_target *ft = &g_fleet[g_fleet_count++];
+			memset(ft, 0, sizeof *ft);
+			ft->str = fd;
+			ft->infix = (unsigned char)infix;
+			ft->keys_start = keys_total();
+			g_fleet_open++;
+		}
+		pthread_mutex_unlock(&g_fleet_lock);
+		if (!fd) { free(d); return -1; }
+	}
+	g_live[g_live_count].str = d;
+	g_live[g_live_count].infix = (unsigned char)infix;
+	g_live[g_live_count].from_file = (unsigned char)from_file;
+	g_live[g_live_count++].id = g_live_next_id++;
+	return 0;
+}
+
+// Remove spec i; under --fleet its target is dropped if still open
+static void live_remove(size_t i) {
+	if (g_fleet_mode) {
+		pthread_mutex_lock(&g_fleet_lock);
+		fleet_close_locked(&g_fleet[g_live[i].id], FLEET_DROPPED);
+		pthread_mutex_unlock(&g_fleet_lock);
+	}
+	free(g_live[i].str);
+	memmove(&g_live[i], &g_live[i + 1], (g_live_count - i - 1) * sizeof *g_live);
+	g_live_count--;
+}
+
+// Remove the first spec equal to str (and kind); 1 when one was found
+static int live_drop(const char *str, int infix) {
+	for (size_t i = 0; i < g_live_count; ++i) {
+		if (g_live[i].infix != infix || strcmp(g_live[i].str, str) != 0) continue;
+		live_remove(i);
+		return 1;
+	}
+	return 0;
+}
+
+// Re-read the pattern file: lines already loaded keep their spec (and --fleet target), new lines are
+// added and vanished ones removed. The whole file is checked first; on any error nothing changes.
+static int live_load_file(const char *path) {
+	FILE *f = fopen(path, "r");
+	if (!f) { fprintf(stderr, "Cannot open pattern file %s: %s\n", path, strerror(errno)); return -1; }
+	char **lines = NULL;
+	size_t n = 0, cap = 0;
+	char line[COORD_LINE_MAX];
+	unsigned lineno = 0;
+	int rc = 0;
+	while (rc == 0 && fgets(line, sizeof line, f)) {
+		++lineno;
+		line[strcspn(line, "\r\n")] = '\0';
+		if (line[0] == '\0' || line[0] == '#') continue;
+		int infix = strncmp(line, "contains ", 9) == 0;
+		const char *err = NULL;
+		if (!infix && strncmp(line, "search ", 7) != 0) err = "want search STR or contains STR";
+		else err = pattern_spec_error(line + (infix ? 9 : 7), infix);
+		if (err) { fprintf(stderr, "%s:%u: %s\n", path, lineno, err); rc = -1; break; }
+		if (n == cap) {
+			cap = cap ? cap * 2 : 16;
+			char **nl = (char **)realloc(lines, cap * sizeof *lines);
+			if (!nl) { rc = -1; break; }
+			lines = nl;
+		}
+		if (!(lines[n] = strdup(line))) { rc = -1; break; }
+		n++;
+	}
+	fclose(f);
+	if (rc == 0) {
+		// Keep the file specs still listed (each line claims one), remove the rest, add what is new
+		for (size_t i = 0; i < g_live_count;) {
+			size_t k = n;
+			if (g_live[i].from_file) {
+				for (k = 0; k < n; ++k) {
+					if (!lines[k]) continue;
+					int infix = lines[k][0] == 'c';
+					if (infix == g_live[i].infix && strcmp(lines[k] + (infix ? 9 : 7), g_live[i].str) == 0) break;
 				}
+				if (k == n) { live_remove(i); continue; }
+				free(lines[k]); lines[k] = NULL;
+			}
+			++i;
+		}
+		for (size_t k = 0; k < n && rc == 0; ++k) {
+			if (!lines[k]) continue;
+			int infix = lines[k][0] == 'c';
+			if (live_add(lines[k] + (infix ? 9 : 7), infix, 1) != 0) { fprintf(stderr, "Out of memory\n"); rc = -1; }
+		}
+	}
+	for (size_t k = 0; k < n; ++k) free(lines[k]);
+	free(lines);
+	return rc;
+}
+
+// Fill g_patterns from the specs, leaving out --fleet targets that are no longer open; returns the
+// number of specs compiled, -1 on failure
+static long live_fill(void) {
+	long n = 0;
+	patterns_clear();
+	for (size_t i = 0; i < g_live_count; ++i) {
+		if (g_fleet_mode) {
+			pthread_mutex_lock(&g_fleet_lock);
+			int open = g_fleet[g_live[i].id].state == FLEET_OPEN;
+			pthread_mutex_unlock(&g_fleet_lock);
+			if (!open) continue;
+		}
+		g_pattern_job_id = g_live[i].id;
+		int rc = g_live[i].infix ? add_infix_pattern(g_live[i].str) : add_search_string(g_live[i].str);
+		if (rc != 0) return -1;
+		n++;
+	}
+	return n;
+}
+
+// Compile and publish the specs; returns the number of active specs, -1 on failure
+static long live_publish(const char *why) {
+	long n = live_fill();
+	if (n < 0 || !pattern_set_rebuild()) { fprintf(stderr, "Patterns: %s failed, keeping the previous set\n", why); return -1; }
+	fprintf(stderr, "Patterns: %ld active (%s)\n", n, why);
+	return n;
+}
+
+static void live_free(void) {
+	for (size_t i = 0; i < g_live_count; ++i) free(g_live[i].str);
+	free(g_live);
+	g_live = NULL;
+	g_live_count = g_live_cap = 0;
+	for (size_t i = 0; i < g_fleet_count; ++i) free(g_fleet[i].str);
+	free(g_fleet);
+	g_fleet = NULL;
+	g_fleet_count = g_fleet_cap = 0;
+}
+
+// Sink for --fleet: the key goes to the first open target it matches in the set it was matched
+// against, and is printed with that target; a key for targets that are all done is dropped
+static void fleet_found(const struct key_match *m, const unsigned char priv[32]) {
+	const struct pattern_set *ps = m->set;
+	uint64_t w[4], be[5];
+	memcpy(w, m->pub, 32);
+	key_words_be(m->pub, be);
+	char target[INFIX_MAX_LEN + BASE64_LEN + 16] = "";
+	pthread_mutex_lock(&g_fleet_lock);
+	for (size_t i = 0; i < ps->count && !target[0]; ++i) {
+		const struct search_pattern *sp = &ps->pats[i];
+		struct fleet_target *ft = &g_fleet[sp->job_id];
+		if (ft->state != FLEET_OPEN || !pattern_matches(sp, w, be)) continue;
+		memcpy(ft->b64_pub, m->b64_pub, sizeof ft->b64_pub);
+		base64_encode_32(priv, ft->b64_priv);
+		snprintf(target, sizeof target, " %s=%s", ft->infix ? "contains" : "search", ft->str);
+		fleet_close_locked(ft, FLEET_DONE);
+	}
+	pthread_mutex_unlock(&g_fleet_lock);
+	if (!target[0]) return;
+	if (write(g_live_wake[1], "x", 1) < 0) { /* the control thread also polls */ }
+	struct key_match fm = *m;
+	fm.target = target;
+	report_found(&fm, priv);
+}
+
+// Final --fleet report on stdout: one line per target, with the keys checked while it was open
+static void fleet_print(void) {
+	unsigned long long keys = keys_total();
+	size_t done = 0;
+	pthread_mutex_lock(&g_fleet_lock);
+	for (size_t i = 0; i < g_fleet_count; ++i) {
+		const struct fleet_target *ft = &g_fleet[i];
+		const char *kind = ft->infix ? "contains" : "search";
+		if (ft->state == FLEET_DONE) {
+			printf("TARGET: %s=%s pub=%s priv=%s keys=%llu\n", kind, ft->str, ft->b64_pub, ft->b64_priv, ft->keys);
+			done++;
+		} else {
+			printf("TARGET: %s=%s %s keys=%llu\n", kind, ft->str, ft->state == FLEET_DROPPED ? "dropped" : "unmatched",
+				ft->state == FLEET_DROPPED ? ft->keys : keys - ft->keys_start);
+		}
+	}
+	fprintf(stderr, "Fleet: %zu of %zu targets have a key\n", done, g_fleet_count);
+	pthread_mutex_unlock(&g_fleet_lock);
+	fflush(stdout);
+}
+
+// One --control command; the reply goes to fd
+static void live_command(int fd, const char *line) {
+	char msg[COORD_LINE_MAX + 32];
+	const char *err = NULL;
+	long n = -1;
+	int drop = strncmp(line, "drop ", 5) == 0;
+	const char *cmd = drop ? line + 5 : line;
+	if (strncmp(cmd, "search ", 7) == 0 || strncmp(cmd, "contains ", 9) == 0) {
+		int infix = cmd[0] == 'c';
+		const char *str = cmd + (infix ? 9 : 7);
+		err = pattern_spec_error(str, infix);
+		if (!err && drop && !live_drop(str, infix)) err = "no such pattern";
+		if (!err && !drop && live_add(str, infix, 0) != 0) err = "out of memory";
+		if (!err && (n = live_publish(drop ? "drop" : "add")) < 0) err = "cannot compile the pattern set";
+	} else if (strcmp(line, "reload") == 0) {
+		if (!g_pattern_file) err = "no --pattern-file";
+		else if (live_load_file(g_pattern_file) != 0) err = "pattern file rejected, previous set kept";
+		else if ((n = live_publish("reload")) < 0) err = "cannot compile the pattern set";
+	} else if (strcmp(line, "list") == 0) {
+		for (size_t i = 0; i < g_live_count; ++i) {
+			int done = 0;
+			if (g_fleet_mode) {
+				pthread_mutex_lock(&g_fleet_lock);
+				done = g_fleet[g_live[i].id].state == FLEET_DONE;
+				pthread_mutex_unlock(&g_fleet_lock);
+			}
+			snprintf(msg, sizeof msg, "%s %s%s\n", g_live[i].infix ? "contains" : "search", g_live[i].str, done ? " done" : "");
+			net_send_all(fd, msg, strlen(msg));
+		}
+		net_send_all(fd, "END\n", 4);
+		return;
+	} else {
+		err = "unknown command (want search, contains, drop, reload or list)";
+	}
+	if (err) snprintf(msg, sizeof msg, "ERR %s\n", err);
+	else snprintf(msg, sizeof msg, "OK patterns=%ld\n", n);
+	net_send_all(fd, msg, strlen(msg));
+}
+
+// Control thread: SIGHUP reloads, --control clients edit the set, satisfied --fleet targets are
+// retired and replaced sets are reclaimed
+static void *live_control(void *arg) {
+	(void)arg;
+	struct { int fd; size_t len; char buf[COORD_LINE_MAX]; } cl[LIVE_MAX_CLIENTS];
+	for (int k = 0; k < LIVE_MAX_CLIENTS; ++k) cl[k].fd = -1;
+	while (!atomic_load(&g_stop.flag)) {
+		struct pollfd pfd[LIVE_MAX_CLIENTS + 2];
+		int map[LIVE_MAX_CLIENTS + 2], n = 0;
+		pfd[n].fd = g_live_wake[0]; pfd[n].events = POLLIN; map[n++] = -2;
+		if (g_control_fd >= 0) { pfd[n].fd = g_control_fd; pfd[n].events = POLLIN; map[n++] = -1; }
+		for (int k = 0; k < LIVE_MAX_CLIENTS; ++k)
+			if (cl[k].fd >= 0) { pfd[n].fd = cl[k].fd; pfd[n].events = POLLIN; map[n++] = k; }
+		int pr = poll(pfd, (nfds_t)n, 200);
+		if (atomic_exchange(&g_reload_req, 0) && g_pattern_file) {
+			if (live_load_file(g_pattern_file) == 0) live_publish("SIGHUP");
+			else fprintf(stderr, "Patterns: %s rejected, keeping the previous set\n", g_pattern_file);
+		}
+		for (int q = 0; pr > 0 && q < n; ++q) {
+			if (!pfd[q].revents) continue;
+			if (map[q] == -2) {
+				char tmp[64];
+				if (read(g_live_wake[0], tmp, sizeof tmp) < 0) { /* drained */ }
+				if (!atomic_load(&g_stop.flag)) live_publish("retire");
+				continue;
+			}
+			if (map[q] == -1) {
+				int cfd = accept(g_control_fd, NULL, NULL);
+				if (cfd < 0) continue;
+				int k = 0;
+				while (k < LIVE_MAX_CLIENTS && cl[k].fd >= 0) ++k;
+				if (k == LIVE_MAX_CLIENTS) { net_send_all(cfd, "ERR too many clients\n", 21); close(cfd); }
+				else { cl[k].fd = cfd; cl[k].len = 0; }
+				continue;
+			}
+			int k = map[q];
+			ssize_t r = recv(cl[k].fd, cl[k].buf + cl[k].len, sizeof cl[k].buf - cl[k].len, 0);
+			if (r < 0 && errno == EINTR) continue;
+			if (r <= 0) { close(cl[k].fd); cl[k].fd = -1; continue; }
+			cl[k].len += (size_t)r;
+			char line[COORD_LINE_MAX];
+			while (net_take_line(cl[k].buf, &cl[k].len, line, sizeof line)) live_command(cl[k].fd, line);
+			if (cl[k].len == sizeof cl[k].buf) { net_send_all(cl[k].fd, "ERR line too long\n", 18); close(cl[k].fd); cl[k].fd = -1; }
+		}
+		pattern_set_reclaim();
+	}
+	for (int k = 0; k < LIVE_MAX_CLIENTS; ++k) if (cl[k].fd >= 0) close(cl[k].fd);
+	return NULL;
+}
+
+// --- Per-thread key pipeline: source -> derive -> prefilter -> verify -> sink ---
+// Each worker picks one implementation per stage when it starts (keygen_pipeline_select) and then
+// pushes whole batches through them, so the hot loop carries no per-key mode checks and any
+// derivation backend runs with any matcher. Sources fill t->sks with clamped secrets (the
+// incremental walk writes t->pubs directly and has no derive stage); derive stages turn t->sks into
+// t->pubs. Stage functions return 1 on success, 0 to skip this batch, -1 to end the thread.
+enum { RAND_KEYS_BATCH = 4096 }; // DRBG buffer in keys; also the largest pipeline batch
+#define PIPE_OPENSSL_BATCH 64     // keys per pass for the per-key OpenSSL/lib25519 derive stage
+
+struct keygen_thread;
+struct keygen_pipeline {
+	int (*source)(struct keygen_thread *t);
+	int (*derive)(struct keygen_thread *t);
+	// Matchers are tried in order; a key is a candidate for one when its prefilter passes
+	int n_match;
+	struct {
+		int (*prefilter)(const struct pattern_set *ps, const unsigned char pub[32]);
+		int (*verify)(const struct pattern_set *ps, const unsigned char pub[32], struct key_match *m);
+	} match[3];
+	// --top: score of a key that no matcher took (NULL when off)
+	int (*score)(const struct pattern_set *ps, const unsigned char pub[32]);
+	// Secret behind t->pubs[idx] for the sink, with its origin in m; 0 drops the candidate
+	int (*secret)(struct keygen_thread *t, int idx, unsigned char sk[32], struct key_match *m);
+	// --top: the same secret for a board entry, with no checks or side effects (top_print verifies)
+	int (*peek)(struct keygen_thread *t, int idx, unsigned char sk[32], struct key_match *m);
+	void (*sink)(const struct key_match *m, const unsigned char sk[32]);
+	// --export, --derive: takes each whole batch in place of the matchers (NULL otherwise); returns
+	// the keys used, -1 to end the thread
+	int (*emit)(struct keygen_thread *t);
+};
+
+struct keygen_thread {
+	struct keygen_pipeline p;
+	int tid;
+	int batch;                  // keys per pass (lane backends round it to their width)
+	unsigned char *sks;         // batch * 32 clamped secrets (a slice of rand_buf)
+	unsigned char *pubs;        // batch * 32 public keys
+	void *scratch;              // derive-stage scratch: X2, Z2, Zinv arrays of the backend's element type
+	int abort_batch;            // set by a stage to discard the rest of the current batch
+	struct top_board *board;    // --top: this thread's leaderboard
+	struct keygen_progress *progress; // --checkpoint: published stream position
+	int top_floor;              // --top: a key must score above this to enter the board
+	const struct pattern_set *ps; // set the matchers read, swapped only at a batch boundary
+	unsigned long long ps_epoch;  // g_pset_epoch when ps was loaded (0: none held)
+	struct pset_reader *reader;   // this worker's slot in g_pset_readers
+	struct export_buf *xbuf;      // --export, --derive: buffer being filled
+	struct keygen_stats *stats;   // this worker's slot in g_stats
+	unsigned long long keys;      // keys checked by this worker (published to stats->keys)
+	int derive_n, derive_pos, derive_cur; // --derive: secrets claimed into rand_buf, next one, keys in this batch
+	chacha20_ctx drbg;          // per-thread DRBG to avoid RAND_bytes in the hot loop
+	size_t rand_off;
+	unsigned long long rand_end;  // stream keys produced so far (rand_buf holds the last RAND_KEYS_BATCH)
+	unsigned long long take_idx;  // stream key index of the last keygen_rand_take slice
+	unsigned long long sks_idx;   // ... of t->sks[0]
+	unsigned char rand_buf[RAND_KEYS_BATCH * 32];
+	struct incr_walk walk;      // incremental mode: current walk (restarted on a match or when exhausted)
+	int walk_active;
+	unsigned long long walk_idx;  // stream key index the walk started from
+	unsigned long long walk_base;
+};
+
+// Next n*32 DRBG bytes as one contiguous slice. When it runs short, the unused tail (from its ChaCha
+// block boundary) moves to the front and the refill continues the stream behind it, so every stream
+// key is served in order whatever the batch sizes; only a full-buffer take after an odd one skips a key.
+static unsigned char *keygen_rand_take(struct keygen_thread *t, size_t n) {
+	if (sizeof(t->rand_buf) - t->rand_off < n) {
+		size_t head = t->rand_off & 63, keep = sizeof(t->rand_buf) - (t->rand_off - head);
+		if (head + n > sizeof(t->rand_buf)) keep = head = 0;
+		memmove(t->rand_buf, t->rand_buf + sizeof(t->rand_buf) - keep, keep);
+		chacha20_next(&t->drbg, t->rand_buf + keep, sizeof(t->rand_buf) - keep);
+		t->rand_end += (sizeof(t->rand_buf) - keep) / 32;
+		t->rand_off = head;
+	}
+	unsigned char *r = t->rand_buf + t->rand_off;
+	t->take_idx = t->rand_end - RAND_KEYS_BATCH + t->rand_off / 32;
+	t->rand_off += n;
+	return r;
+}
+
+// Restart the DRBG so the next take begins at stream key index pos (--resume; --seed streams only)
+static void keygen_rand_seek(struct keygen_thread *t, unsigned long long pos) {
+	seed_stream_init(&t->drbg, g_seed_key, (uint32_t)t->tid, pos / 2);
+	chacha20_next(&t->drbg, t->rand_buf, sizeof(t->rand_buf));
+	t->rand_end = (pos & ~1ULL) + RAND_KEYS_BATCH;
+	t->rand_off = (size_t)(pos & 1) * 32;
+}
+
+// After each batch: every stream key before pos has been checked and none after it, so a resume from
+// here neither repeats nor skips keys. Written by the owner thread only, read under the seqlock.
+static void keygen_progress_publish(struct keygen_thread *t, int done) {
+	struct keygen_progress *pr = t->progress;
+	unsigned seq = atomic_load_explicit(&pr->seq, memory_order_relaxed);
+	atomic_store_explicit(&pr->seq, seq + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	pr->pos = t->rand_end - RAND_KEYS_BATCH + t->rand_off / 32;
+	pr->keys += (unsigned long long)done;
+	pr->walk_active = t->walk_active;
+	pr->walk_idx = t->walk_idx;
+	pr->walk_step = t->walk.step;
+	atomic_store_explicit(&pr->seq, seq + 2, memory_order_release);
+}
+
+// Source: batch of random secrets, clamped per RFC 7748
+static int source_random(struct keygen_thread *t) {
+	unsigned char *sks = keygen_rand_take(t, (size_t)t->batch * 32);
+	t->sks_idx = t->take_idx;
+	for (int i = 0; i < t->batch; ++i) {
+		unsigned char *sk = sks + (size_t)i * 32;
+		sk[0] &= 248; sk[31] &= 127; sk[31] |= 64;
+	}
+	t->sks = sks;
+	return 1;
+}
+
+static int secret_random(struct keygen_thread *t, int idx, unsigned char sk[32], struct key_match *m) {
+	memcpy(sk, t->sks + (size_t)idx * 32, 32);
+	m->thread = t->tid; m->index = t->sks_idx + (unsigned long long)idx; m->step = -1;
+	return 1;
+}
+
+// Source: incremental-scalar walk. One ladder pair per walk start, then one differential addition
+// per key and a single shared inversion per batch; produces public keys, secrets on demand.
+static int source_walk(struct keygen_thread *t) {
+	int n = t->batch;
+	fe51 *X2 = (fe51 *)t->scratch, *Z2 = X2 + n, *Zi = Z2 + n;
+	if (!t->walk_active || t->walk.step + (unsigned long long)n > INCR_WALK_MAX_STEPS) {
+		t->walk_active = walk_start(&t->walk, keygen_rand_take(t, 32), 0);
+		if (!t->walk_active) return 0;
+		t->walk_idx = t->take_idx;
+	}
+	t->walk_base = t->walk.step;
+	walk_fill(&t->walk, X2, Z2, n);
+	PROF_LAP(PROF_LADDER);
+	fe51_batch_invert(Zi, Z2, n);
+	PROF_LAP(PROF_INVERT);
+	for (int i = 0; i < n; ++i) {
+		fe51 X; fe51_mul(&X, &X2[i], &Zi[i]);
+		fe51_tobytes(t->pubs + (size_t)i * 32, &X);
+	}
+	PROF_LAP(PROF_FINISH);
+	return 1;
+}
+
+// Board offers only need k0 + 8*step; the walk carries on
+static int peek_walk(struct keygen_thread *t, int idx, unsigned char sk[32], struct key_match *m) {
+	walk_secret(&t->walk, t->walk_base + (unsigned long long)idx, sk);
+	m->thread = t->tid; m->index = t->walk_idx; m->step = (long long)(t->walk_base + (unsigned long long)idx);
+	return 1;
+}
+
+static int secret_walk(struct keygen_thread *t, int idx, unsigned char sk[32], struct key_match *m) {
+	// Re-derive through OpenSSL before printing; never emit a key we cannot reproduce
+	unsigned char ref_pub[32];
+	peek_walk(t, idx, sk, m);
+	int ok = x25519_pub_openssl(ref_pub, sk) && memcmp(ref_pub, t->pubs + (size_t)idx * 32, 32) == 0;
+	if (!ok) fprintf(stderr, "Incremental walk: OpenSSL re-derivation mismatch, candidate dropped\n");
+	// Keys on one walk are related (k + 8i): restart so no two printed keys share a walk
+	t->walk_active = 0; t->abort_batch = 1;
+	return ok;
+}
+
+// Derive: one key at a time through lib25519 or OpenSSL
+static int derive_openssl(struct keygen_thread *t) {
+	for (int i = 0; i < t->batch; ++i) {
+		const unsigned char *sk = t->sks + (size_t)i * 32;
+		unsigned char *pub = t->pubs + (size_t)i * 32;
+#ifdef ME_USE_LIB25519
+		// X25519 public key = X25519(secret, basepoint). lib25519_dh(k,pk,sk) computes k = X25519(sk, pk).
+		// So we set pk = basepoint, and the secret input as sk; the output "k" is the public key.
+		lib25519_dh(pub, X25519_BASEPOINT, sk);
+#else
+		// Try fast X25519_public_from_private if available, else EVP; the internal ladder backs up an EVP failure
+		if (!x25519_pub_from_priv_dyn(pub, sk) && !x25519_pub_openssl(pub, sk)) x25519_basepoint_mul_fe51(sk, pub);
+#endif
+	}
+	return 1;
+}
+
+// Derive: native 5x51 projective multiples (ladder or fixed-base comb via g_fe51_x2z2), one shared inversion
+static int derive_fe51(struct keygen_thread *t) {
+	fe51 *X2 = (fe51 *)t->scratch;
+	x25519_base_batch_fe51(t->sks, t->batch, t->pubs, X2, X2 + t->batch, X2 + 2 * t->batch);
+	return 1;
+}
+
+// Derive: one key on the selected fe backend (batch 1, the default for MEKG_CPU_FE=baseline|adx|avx2|ifma);
+// the plain ladder with its own inversion, no scratch
+static int derive_fe_one(struct keygen_thread *t) {
+	x25519_basepoint_mul_cpu(t->sks, t->pubs);
+	PROF_LAP(PROF_LADDER);
+	return 1;
+}
+
+// Derive: ref10-limb ladder on the selected fe backend (MEKG_CPU_FE=baseline|adx|avx2|ifma), one shared inversion
+static int derive_fe(struct keygen_thread *t) {
+	int n = t->batch;
+	fe *X2 = (fe *)t->scratch, *Z2 = X2 + n, *Zi = Z2 + n;
+	for (int i = 0; i < n; ++i) ladder_get_x2z2(t->sks + (size_t)i * 32, &X2[i], &Z2[i]);
+	PROF_LAP(PROF_LADDER);
+	fe_batch_invert(Zi, Z2, n);
+	PROF_LAP(PROF_INVERT);
+	for (int i = 0; i < n; ++i) {
+		fe X; fem(&X, &X2[i], &Zi[i]);
+		fetobytes(t->pubs + (size_t)i * 32, &X);
+	}
+	PROF_LAP(PROF_FINISH);
+	return 1;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Derive: 4-lane AVX2 ladder, batch is a multiple of 4
+static int derive_avx2(struct keygen_thread *t) {
+	int n4 = t->batch / 4;
+	fe_soa4 *X2 = (fe_soa4 *)t->scratch;
+	x25519_base_batch_avx2(t->sks, n4, t->pubs, X2, X2 + n4, X2 + 2 * n4);
+	return 1;
+}
+
+// Derive: 8-lane AVX-512 IFMA ladder, batch is a multiple of 8
+static int derive_ifma(struct keygen_thread *t) {
+	int n8 = t->batch / 8;
+	fe_soa8 *X2 = (fe_soa8 *)t->scratch;
+	x25519_base_batch_ifma(t->sks, n8, t->pubs, X2, X2 + n8, X2 + 2 * n8);
+	return 1;
+}
+#endif
+
+// --- Bulk export (--export N): plain keypairs, no matching ---
+// The emit stage takes whole batches instead of the matchers. Each worker appends 64-byte
+// (priv, pub) records, or "PRIV PUB\n" Base64 lines, to its own 1 MiB page-aligned buffer and hands
+// full buffers to a single writer thread, which issues one large write(2) per buffer. Workers never
+// touch stdio. Keys are claimed a batch at a time from g_export_claimed, so exactly N records are
+// written. When the buffer pool runs dry (slow disk or pipe) the workers wait for the writer.
+// The first key of every buffer is re-derived through OpenSSL before it can be written.
+// Raw output starts with a 64-byte little-endian header:
+//   0 "MEKGKEYS", 8 version (1), 12 header bytes (64), 16 record bytes (64), 20 priv offset (0),
+//   24 pub offset (32), 28 flags (bit 0: secrets clamped per RFC 7748, bit 1: --seed streams),
+//   32 record count, 40 seed (0 without --seed), 48..63 zero
+// Base64 output starts with one '#' line carrying the same facts.
+#define EXPORT_BUF_BYTES (1u << 20)
+#define EXPORT_B64_LINE (2 * BASE64_LEN + 2) // "PRIV PUB\n"
+#define EXPORT_DEFAULT_BATCH 256             // internal-ladder batch unless MEKG_CPU_BATCH is set
+#define EXPORT_COUNT_OFF_RAW 32
+struct export_buf {
+	unsigned char *data;
+	size_t len;
+	unsigned long long seq;     // --derive: input chunk number, written in this order
+	struct export_buf *next;
+};
+static unsigned long long g_export_n = 0;    // --export N (0 = off)
+static int g_export_b64 = 0;                 // --export-base64
+static int g_export_fd = -1;
+static size_t g_export_rec = 64;             // output bytes per key
+static int g_export_ordered = 0;             // write buffers by seq (--derive) rather than as they fill
+static unsigned long long g_export_next_seq = 0;
+static size_t g_export_count_off = 0;        // where the header's record count sits (rewritten on a short run)
+static _Atomic unsigned long long g_export_claimed = 0;
+static unsigned long long g_export_written = 0; // records written (writer thread)
+static int g_export_failed = 0;
+static int g_export_closing = 0;
+static struct export_buf *g_export_free = NULL, *g_export_full = NULL;
+static pthread_mutex_t g_export_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_export_full_cv = PTHREAD_COND_INITIALIZER, g_export_free_cv = PTHREAD_COND_INITIALIZER;
+
+static void export_put_le(unsigned char *p, unsigned long long v, int n) {
+	for (int i = 0; i < n; ++i) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static int export_write_all(const unsigned char *p, size_t n) {
+	while (n) {
+		ssize_t w = write(g_export_fd, p, n);
+		if (w < 0 && errno == EINTR) continue;
+		if (w <= 0) return -1;
+		p += w; n -= (size_t)w;
+	}
+	return 0;
+}
+
+// Header for count records; the count is rewritten in place if the run stops early
+static int export_write_header(unsigned long long count) {
+	if (g_export_b64) {
+		char h[160];
+		int n = snprintf(h, sizeof h, "# meshtastic_keygen export v1: X25519 keypairs, one \"PRIV PUB\" Base64 line each, records=%020llu seed=%llu\n",
+			count, g_seeded ? g_seed : 0ULL);
+		g_export_count_off = (size_t)(strstr(h, "records=") - h) + 8;
+		return export_write_all((const unsigned char *)h, (size_t)n);
+	}
+	unsigned char h[64] = {0};
+	memcpy(h, "MEKGKEYS", 8);
+	export_put_le(h + 8, 1, 4);
+	export_put_le(h + 12, 64, 4);
+	export_put_le(h + 16, 64, 4);
+	export_put_le(h + 20, 0, 4);
+	export_put_le(h + 24, 32, 4);
+	export_put_le(h + 28, 1u | (g_seeded ? 2u : 0u), 4);
+	export_put_le(h + EXPORT_COUNT_OFF_RAW, count, 8);
+	export_put_le(h + 40, g_seeded ? g_seed : 0ULL, 8);
+	g_export_count_off = EXPORT_COUNT_OFF_RAW;
+	return export_write_all(h, sizeof h);
+}
+
+// Buffer pool: two per worker, so one can fill while the other is written
+static int export_pool_init(int nbufs) {
+	for (int i = 0; i < nbufs; ++i) {
+		struct export_buf *b = (struct export_buf *)calloc(1, sizeof *b);
+		if (b) b->data = (unsigned char *)aligned_alloc(4096, EXPORT_BUF_BYTES);
+		if (!b || !b->data) { free(b); return -1; }
+		b->next = g_export_free;
+		g_export_free = b;
+	}
+	return 0;
+}
+
+static void export_pool_free(void) {
+	while (g_export_free) {
+		struct export_buf *b = g_export_free;
+		g_export_free = b->next;
+		free(b->data);
+		free(b);
+	}
+}
+
+// An empty buffer for a worker; NULL once the writer has failed
+static struct export_buf *export_take(void) {
+	pthread_mutex_lock(&g_export_lock);
+	while (!g_export_free && !g_export_failed) pthread_cond_wait(&g_export_free_cv, &g_export_lock);
+	struct export_buf *b = g_export_failed ? NULL : g_export_free;
+	if (b) g_export_free = b->next;
+	pthread_mutex_unlock(&g_export_lock);
+	return b;
+}
+
+// Queue a buffer for the writer, in seq order when ordered (an empty one goes straight back to the pool)
+static void export_put(struct export_buf *b) {
+	pthread_mutex_lock(&g_export_lock);
+	if (b->len) {
+		struct export_buf **pp = &g_export_full;
+		while (*pp && (!g_export_ordered || (*pp)->seq < b->seq)) pp = &(*pp)->next;
+		b->next = *pp;
+		*pp = b;
+		pthread_cond_signal(&g_export_full_cv);
+	} else {
+		b->next = g_export_free;
+		g_export_free = b;
+		pthread_cond_signal(&g_export_free_cv);
+	}
+	pthread_mutex_unlock(&g_export_lock);
+}
+
+// Head of the queue if it may be written now
+static struct export_buf *export_ready(void) {
+	struct export_buf *b = g_export_full;
+	return b && (!g_export_ordered || b->seq == g_export_next_seq) ? b : NULL;
+}
+
+static void *export_writer(void *arg) {
+	(void)arg;
+	pthread_mutex_lock(&g_export_lock);
+	for (;;) {
+		while (!export_ready() && !g_export_closing) pthread_cond_wait(&g_export_full_cv, &g_export_lock);
+		struct export_buf *b = export_ready();
+		if (!b) break;
+		g_export_full = b->next;
+		g_export_next_seq++;
+		pthread_mutex_unlock(&g_export_lock);
+		int failed = export_write_all(b->data, b->len) != 0;
+		if (failed) { perror("Export write"); atomic_store(&g_stop.flag, 1); }
+		pthread_mutex_lock(&g_export_lock);
+		if (failed) g_export_failed = 1;
+		else g_export_written += b->len / g_export_rec;
+		b->len = 0;
+		b->next = g_export_free;
+		g_export_free = b;
+		pthread_cond_broadcast(&g_export_free_cv);
+	}
+	// Ordered output stops at the first missing chunk (a run cut short); later ones are dropped
+	while (g_export_full) {
+		struct export_buf *b = g_export_full;
+		g_export_full = b->next;
+		b->len = 0;
+		b->next = g_export_free;
+		g_export_free = b;
+	}
+	pthread_mutex_unlock(&g_export_lock);
+	return NULL;
+}
+
+// After the workers have flushed: drain the queue, stop the writer and fix the header count
+static unsigned long long export_finish(pthread_t writer) {
+	pthread_mutex_lock(&g_export_lock);
+	g_export_closing = 1;
+	pthread_cond_signal(&g_export_full_cv);
+	pthread_mutex_unlock(&g_export_lock);
+	pthread_join(writer, NULL);
+	if (g_export_n && g_export_written != g_export_n) {
+		// Short run (Ctrl-C or a write error): a seekable file gets the real count
+		unsigned char le[8];
+		char dec[24];
+		snprintf(dec, sizeof dec, "%020llu", g_export_written);
+		export_put_le(le, g_export_written, 8);
+		if (pwrite(g_export_fd, g_export_b64 ? (const void *)dec : (const void *)le, g_export_b64 ? 20 : 8, (off_t)g_export_count_off) < 0 && errno != ESPIPE)
+			perror("Export header");
+	}
+	return g_export_written;
+}
+
+// Re-derive one key through OpenSSL; a mismatch fails the whole run
+static int export_spot_check(const unsigned char sk[32], const unsigned char pub[32]) {
+	unsigned char ref[32];
+	if (x25519_pub_openssl(ref, sk) && memcmp(ref, pub, 32) == 0) return 1;
+	fprintf(stderr, "%s: OpenSSL re-derivation mismatch, stopping\n", g_export_n ? "Export" : "Derive");
+	pthread_mutex_lock(&g_export_lock);
+	g_export_failed = 1;
+	pthread_cond_broadcast(&g_export_free_cv);
+	pthread_mutex_unlock(&g_export_lock);
+	atomic_store(&g_stop.flag, 1);
+	return 0;
+}
+
+// Emit stage: claim up to one batch of the N records and append them to this worker's buffer.
+// Returns the keys consumed, -1 when the export is complete or has failed.
+static int emit_export(struct keygen_thread *t) {
+	unsigned long long base = atomic_fetch_add_explicit(&g_export_claimed, (unsigned long long)t->batch, memory_order_relaxed);
+	if (base >= g_export_n) return -1;
+	int n = g_export_n - base < (unsigned long long)t->batch ? (int)(g_export_n - base) : t->batch;
+	size_t rec = g_export_rec;
+	for (int i = 0; i < n; ++i) {
+		const unsigned char *sk = t->sks + (size_t)i * 32, *pub = t->pubs + (size_t)i * 32;
+		if (!t->xbuf || EXPORT_BUF_BYTES - t->xbuf->len < rec) {
+			if (t->xbuf) export_put(t->xbuf);
+			t->xbuf = export_take();
+			if (!t->xbuf || !export_spot_check(sk, pub)) return -1;
+		}
+		unsigned char *d = t->xbuf->data + t->xbuf->len;
+		if (g_export_b64) {
+			base64_encode_32(sk, (char *)d);
+			d[BASE64_LEN] = ' ';
+			base64_encode_32(pub, (char *)d + BASE64_LEN + 1);
+			d[2 * BASE64_LEN + 1] = '\n';
+		} else {
+			memcpy(d, sk, 32);
+			memcpy(d + 32, pub, 32);
+		}
+		t->xbuf->len += rec;
+	}
+	if (base + (unsigned long long)n >= g_export_n) atomic_store(&g_stop.flag, 1);
+	return n;
+}
+
+// --- Batch derivation (--derive FILE): public keys for existing secrets ---
+// Input is raw 32-byte secrets, an --export file (recognized by its MEKGKEYS header), or with
+// --derive-base64 one Base64 secret per line (first field; blank and '#' lines skipped, so
+// --export-base64 output reads back as is). A file is memory-mapped; "-" reads stdin. Workers
+// claim up to RAND_KEYS_BATCH secrets at a time under g_derive_lock, derive them on the selected
+// batched backend and fill one export buffer per chunk. Chunks carry a sequence number and the
+// writer emits them in input order, so stdout gets raw 32-byte public keys or Base64 lines in
+// the order the secrets came. Secrets are clamped as X25519 does; the public key is the same.
+struct derive_input {
+	const unsigned char *map;   // mapped file (NULL for stdin)
+	size_t map_len, pos;
+	FILE *f;
+	unsigned char head[64];     // stdin: first record read while looking for a header
+	size_t head_len;
+	size_t rec, priv_off;       // raw record size and secret offset (32/0, or from the header)
+	unsigned long long expect;  // records promised by an export header (ULLONG_MAX: none)
+	unsigned long long line, seq, records;
+	int eof, error;
+};
+static const char *g_derive_path = NULL;     // --derive FILE ("-" = stdin)
+static int g_derive_b64 = 0;                 // --derive-base64
+static struct derive_input g_derive_in;
+static pthread_mutex_t g_derive_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Strict decode of a 44-char Base64 32-byte value; returns 0 if it is not one
+static int base64_decode_32(const char *in, unsigned char out[32]) {
+	uint32_t v = 0;
+	for (int i = 0; i < 43; ++i) {
+		unsigned char c = b64_index((unsigned char)in[i]);
+		if (c == 0xFFu) return 0;
+		v = (v << 6) | c;
+		if (i % 4 == 3) { out[i / 4 * 3] = (unsigned char)(v >> 16); out[i / 4 * 3 + 1] = (unsigned char)(v >> 8); out[i / 4 * 3 + 2] = (unsigned char)v; v = 0; }
+	}
+	if (in[43] != '=' || (v & 3)) return 0;
+	out[30] = (unsigned char)(v >> 10); out[31] = (unsigned char)(v >> 2);
+	return 1;
+}
+
+// Export header at p: sets the record layout; returns 0 if it is not a usable one
+static int derive_parse_header(struct derive_input *in, const unsigned char *p) {
+	uint32_t f[6];
+	for (int i = 0; i < 6; ++i) f[i] = (uint32_t)p[8 + 4 * i] | (uint32_t)p[9 + 4 * i] << 8 | (uint32_t)p[10 + 4 * i] << 16 | (uint32_t)p[11 + 4 * i] << 24;
+	// version, header bytes, record bytes, priv offset
+	if (f[0] != 1 || f[1] != 64 || f[2] < 32 || f[2] > 4096 || f[3] > f[2] - 32) return 0;
+	in->rec = f[2];
+	in->priv_off = f[3];
+	in->expect = 0;
+	for (int i = 7; i >= 0; --i) in->expect = in->expect << 8 | p[32 + i];
+	return 1;
+}
+
+static int derive_open(const char *path) {
+	struct derive_input *in = &g_derive_in;
+	memset(in, 0, sizeof *in);
+	in->rec = 32;
+	in->expect = ULLONG_MAX;
+	if (strcmp(path, "-") == 0) {
+		in->f = stdin;
+		setvbuf(stdin, NULL, _IOFBF, EXPORT_BUF_BYTES);
+		if (!g_derive_b64) {
+			in->head_len = fread(in->head, 1, 32, stdin);
+			if (in->head_len == 32 && memcmp(in->head, "MEKGKEYS", 8) == 0) {
+				if (fread(in->head + 32, 1, 32, stdin) != 32 || !derive_parse_header(in, in->head)) { fprintf(stderr, "Derive: unsupported export header on stdin\n"); return -1; }
+				in->head_len = 0;
 			}
-			local_cnt += (unsigned long long)N;
-			if (local_cnt >= 4096ULL) { atomic_fetch_add_explicit(&g_key_count, local_cnt, memory_order_relaxed); local_cnt = 0; }
-			rand_off += need;
-			if (atomic_load_explicit(&g_stop, memory_order_relaxed)) break;
-			continue; // proceed to next batch without running single-key path
-		}
-		unsigned char *priv = rand_buf + rand_off;
-		rand_off += 32;
-
-	// Clamp private key per X25519 spec
-	priv[0] &= 248;
-	priv[31] &= 127;
-	priv[31] |= 64;
-
-		// Derive public key
-		int have_pub = 0;
-#ifdef ME_KEYGEN_OPENCL
-		if (g_use_internal) {
-			x25519_basepoint_mul_cpu(priv, pub_key);
-			have_pub = 1;
 		}
-#endif
-#ifdef ME_USE_LIB25519
-		if (!have_pub) {
-			// X25519 public key = X25519(secret, basepoint). lib25519_dh(k,pk,sk) computes k = X25519(sk, pk).
-			// So we set pk = basepoint, and the secret input as sk; the output "k" is the public key.
-			lib25519_dh(pub_key, X25519_BASEPOINT, priv);
-			have_pub = 1;
+		return 0;
+	}
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) { fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno)); return -1; }
+	struct stat st;
+	if (fstat(fd, &st) != 0) { fprintf(stderr, "Cannot stat %s: %s\n", path, strerror(errno)); close(fd); return -1; }
+	if (st.st_size > 0) {
+		void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map == MAP_FAILED) { fprintf(stderr, "Cannot map %s: %s\n", path, strerror(errno)); close(fd); return -1; }
+		madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+		in->map = (const unsigned char *)map;
+		in->map_len = (size_t)st.st_size;
+	}
+	close(fd);
+	if (!g_derive_b64 && in->map_len >= 64 && memcmp(in->map, "MEKGKEYS", 8) == 0) {
+		if (!derive_parse_header(in, in->map)) { fprintf(stderr, "Derive: unsupported export header in %s\n", path); return -1; }
+		in->pos = 64;
+	}
+	return 0;
+}
+
+static void derive_close(void) {
+	if (g_derive_in.map) munmap((void *)g_derive_in.map, g_derive_in.map_len);
+	g_derive_in.map = NULL;
+}
+
+// Next raw record, NULL at the end; a trailing partial record is an error
+static const unsigned char *derive_next_record(struct derive_input *in, unsigned char *tmp) {
+	if (in->map) {
+		if (in->pos == in->map_len) return NULL;
+		if (in->map_len - in->pos < in->rec) { fprintf(stderr, "Derive: %zu trailing bytes are not a whole record\n", in->map_len - in->pos); in->error = 1; return NULL; }
+		in->pos += in->rec;
+		return in->map + in->pos - in->rec;
+	}
+	if (!in->f) return NULL; // empty file
+	size_t got;
+	if (in->head_len) {
+		memcpy(tmp, in->head, in->head_len);
+		got = in->head_len + fread(tmp + in->head_len, 1, in->rec - in->head_len, in->f);
+		in->head_len = 0;
+	} else {
+		got = fread(tmp, 1, in->rec, in->f);
+	}
+	if (got == in->rec) return tmp;
+	if (ferror(in->f)) { perror("Derive: read"); in->error = 1; }
+	else if (got) { fprintf(stderr, "Derive: %zu trailing bytes are not a whole record\n", got); in->error = 1; }
+	return NULL;
+}
+
+// Next input line without its newline, NULL at the end
+static const char *derive_next_line(struct derive_input *in, char *tmp, size_t cap, size_t *len) {
+	const char *line;
+	if (in->map) {
+		if (in->pos >= in->map_len) return NULL;
+		line = (const char *)in->map + in->pos;
+		const char *eol = memchr(line, '\n', in->map_len - in->pos);
+		*len = eol ? (size_t)(eol - line) : in->map_len - in->pos;
+		in->pos += *len + 1;
+	} else {
+		if (!in->f || !fgets(tmp, (int)cap, in->f)) {
+			if (in->f && ferror(in->f)) { perror("Derive: read"); in->error = 1; }
+			return NULL;
 		}
-#else
-		if (!have_pub) {
-			// Try fast X25519_public_from_private if available, else EVP fallback
-			if (!x25519_pub_from_priv_dyn(pub_key, priv)) {
-				EVP_PKEY *pkey = EVP_PKEY_new_raw_private_key(EVP_PKEY_X25519, NULL, priv, 32);
-				if (!pkey) continue;
-				size_t len = 32;
-				if (EVP_PKEY_get_raw_public_key(pkey, pub_key, &len) <= 0) { EVP_PKEY_free(pkey); continue; }
-				EVP_PKEY_free(pkey);
+		*len = strlen(tmp);
+		if (*len && tmp[*len - 1] == '\n') --*len;
+		else if (*len == cap - 1 && !feof(in->f)) { fprintf(stderr, "Derive: line %llu is too long\n", in->line + 1); in->error = 1; return NULL; }
+		line = tmp;
+	}
+	in->line++;
+	if (*len && line[*len - 1] == '\r') --*len;
+	return line;
+}
+
+// Fill t->rand_buf with the next chunk of clamped secrets and tag t->xbuf with its sequence number.
+// Returns the secrets read; 0 once the input is exhausted or broken.
+static int derive_claim(struct keygen_thread *t) {
+	struct derive_input *in = &g_derive_in;
+	int cap = RAND_KEYS_BATCH / t->batch * t->batch, n = 0;
+	unsigned char tmp[4096];
+	pthread_mutex_lock(&g_derive_lock);
+	while (!in->eof && n < cap) {
+		unsigned char *sk = t->rand_buf + (size_t)n * 32;
+		if (g_derive_b64) {
+			size_t len;
+			const char *line = derive_next_line(in, (char *)tmp, sizeof tmp, &len);
+			if (!line) { in->eof = 1; break; }
+			while (len && (*line == ' ' || *line == '\t')) { ++line; --len; }
+			if (len == 0 || *line == '#') continue;
+			size_t field = 0;
+			while (field < len && line[field] != ' ' && line[field] != '\t') ++field;
+			if (field != BASE64_LEN || !base64_decode_32(line, sk)) {
+				fprintf(stderr, "Derive: line %llu does not start with a Base64 32-byte secret\n", in->line);
+				in->error = in->eof = 1;
+				break;
 			}
+		} else {
+			const unsigned char *r = derive_next_record(in, tmp);
+			if (!r) { in->eof = 1; break; }
+			memcpy(sk, r + in->priv_off, 32);
 		}
+		sk[0] &= 248; sk[31] &= 127; sk[31] |= 64;
+		n++;
+	}
+	if (n) {
+		t->xbuf->seq = in->seq++;
+		in->records += (unsigned long long)n;
+	}
+	pthread_mutex_unlock(&g_derive_lock);
+	return n;
+}
+
+// Source: the next batch of the claimed chunk (a short last batch is padded with its first secret).
+// The output buffer is taken before the chunk is claimed, so the oldest unwritten chunk always
+// has one and the ordered writer cannot starve.
+static int source_derive(struct keygen_thread *t) {
+	if (t->derive_pos == t->derive_n) {
+		t->xbuf = export_take();
+		if (!t->xbuf) return -1;
+		t->derive_n = derive_claim(t);
+		t->derive_pos = 0;
+		if (t->derive_n == 0) return -1;
+	}
+	int n = t->derive_n - t->derive_pos < t->batch ? t->derive_n - t->derive_pos : t->batch;
+	t->sks = t->rand_buf + (size_t)t->derive_pos * 32;
+	for (int i = n; i < t->batch; ++i) memcpy(t->sks + (size_t)i * 32, t->sks, 32);
+	t->derive_cur = n;
+	return 1;
+}
+
+// Emit stage: append this batch's public keys; a finished chunk goes to the writer
+static int emit_derive(struct keygen_thread *t) {
+	int n = t->derive_cur;
+	if (t->derive_pos == 0 && !export_spot_check(t->sks, t->pubs)) return -1;
+	unsigned char *d = t->xbuf->data + t->xbuf->len;
+	for (int i = 0; i < n; ++i, d += g_export_rec) {
+		const unsigned char *pub = t->pubs + (size_t)i * 32;
+		if (g_derive_b64) {
+			base64_encode_32(pub, (char *)d);
+			d[BASE64_LEN] = '\n';
+		} else {
+			memcpy(d, pub, 32);
+		}
+	}
+	t->xbuf->len += (size_t)n * g_export_rec;
+	t->derive_pos += n;
+	if (t->derive_pos == t->derive_n) {
+		export_put(t->xbuf);
+		t->xbuf = NULL;
+	}
+	return n;
+}
+
+// Matcher, score and sink stages for the pattern set in t->ps
+static void keygen_pipeline_matchers(struct keygen_thread *t) {
+	const struct pattern_set *ps = t->ps;
+	t->p.n_match = 0;
+	if (ps->count > ps->infix_count) {
+		t->p.match[t->p.n_match].prefilter = ps->pre_bitmap ? prefilter_bitmap : prefilter_linear;
+		t->p.match[t->p.n_match++].verify = verify_bits;
+	}
+	if (ps->infix_count) {
+		t->p.match[t->p.n_match].prefilter = prefilter_infix;
+		t->p.match[t->p.n_match++].verify = verify_bits;
+	}
+	if (g_wordlist.n) {
+		t->p.match[t->p.n_match].prefilter = prefilter_wordlist;
+		t->p.match[t->p.n_match++].verify = verify_wordlist;
+	}
+	t->p.score = g_top_k ? score_patterns : NULL;
+	t->p.sink = g_serve ? serve_found : g_fleet_mode ? fleet_found : report_found;
+}
+
+// Pick the stages for this run from the global knobs and size the per-thread buffers.
+// Precedence: incremental walk, then (with MEKG_CPU_INTERNAL) IFMA 8-lane unless an explicit
+// MEKG_EXPERIMENTAL_AVX2_MULTI asks otherwise, AVX2 4-lane, 2-lane, the batched scalar ladder;
+// everything else derives through lib25519/OpenSSL. Returns 0 on allocation failure.
+static int keygen_pipeline_select(struct keygen_thread *t) {
+	size_t elem = 0; // scratch bytes per key-slot group (times 3 for X2, Z2, Zinv)
+	int groups = 0;
+	t->p.source = source_random;
+	t->p.secret = t->p.peek = secret_random;
+	t->p.emit = g_export_n ? emit_export : g_derive_path ? emit_derive : NULL;
+	if (g_derive_path) t->p.source = source_derive;
+	if (g_incremental) {
+		t->batch = g_cpu_batch > 1 ? g_cpu_batch : INCR_DEFAULT_BATCH;
+		t->p.source = source_walk; t->p.secret = secret_walk; t->p.peek = peek_walk; t->p.derive = NULL;
+		elem = sizeof(fe51); groups = t->batch;
+	}
+#if defined(__x86_64__) || defined(__i386__)
+	else if (g_use_internal && g_use_ifma8 && g_avx2_multi_lanes == 0) {
+		t->batch = g_cpu_batch > 1 ? (g_cpu_batch + 7) & ~7 : 8;
+		t->p.derive = derive_ifma;
+		elem = sizeof(fe_soa8); groups = t->batch / 8;
+	} else if (g_use_internal && g_avx2_multi_lanes == 4) {
+		t->batch = g_cpu_batch > 1 ? (g_cpu_batch + 3) & ~3 : 4;
+		t->p.derive = derive_avx2;
+		elem = sizeof(fe_soa4); groups = t->batch / 4;
+	}
+#endif
+	else if (g_use_internal) {
+		// 2 lanes is a plain batch of two on the scalar ladder
+		t->batch = g_avx2_multi_lanes >= 2 ? g_avx2_multi_lanes : (g_cpu_batch > 1 ? g_cpu_batch : 1);
+		t->p.derive = g_use_fe51 ? derive_fe51 : t->batch == 1 ? derive_fe_one : derive_fe;
+		elem = g_use_fe51 ? sizeof(fe51) : sizeof(fe); groups = t->p.derive == derive_fe_one ? 0 : t->batch;
+	} else {
+		t->batch = PIPE_OPENSSL_BATCH;
+		t->p.derive = derive_openssl;
+	}
+	t->pubs = (unsigned char *)malloc((size_t)t->batch * 32);
+	if (!t->pubs) return 0;
+	if (groups) {
+		t->scratch = malloc(elem * 3 * (size_t)groups);
+		if (!t->scratch) return 0;
+	}
+	return 1;
+}
+
+// After each batch: publish this worker's running key total and the CPU it ran on, both to its own line
+static inline void keygen_stats_publish(struct keygen_thread *t, int done) {
+	t->keys += (unsigned long long)done;
+	atomic_store_explicit(&t->stats->keys, t->keys, memory_order_relaxed);
+	int cpu = sched_getcpu();
+	if (cpu != atomic_load_explicit(&t->stats->cpu, memory_order_relaxed)) atomic_store_explicit(&t->stats->cpu, cpu, memory_order_relaxed);
+#ifdef ME_KEYGEN_PROFILE
+	for (int i = 0; i < PROF_NSTAGES; ++i) atomic_store_explicit(&t->stats->prof[i], tl_prof.t[i], memory_order_relaxed);
 #endif
+}
 
-		// Quick prefix/suffix prefilter on raw bytes to avoid base64 when obviously not matching
-		int likely_match = (g_patterns_count == 0);
-		if (!likely_match) {
-			// Compute first up to 4 Base64 indices from first 3 bytes
-			unsigned char b0 = pub_key[0], b1 = pub_key[1], b2 = pub_key[2];
-			unsigned char p0 = (b0 >> 2) & 0x3F;
-			unsigned char p1 = ((b0 & 0x3) << 4) | (b1 >> 4);
-			p1 &= 0x3F;
-			unsigned char p2 = ((b1 & 0xF) << 2) | (b2 >> 6);
-			p2 &= 0x3F;
-			unsigned char p3 = b2 & 0x3F;
-			// Compute last up to 3 Base64 indices from last 2 bytes (positions 41..43 before '=')
-			unsigned char e30 = pub_key[30];
-			unsigned char e31 = pub_key[31];
-			unsigned char s41 = (e30 >> 2) & 0x3F;
-			unsigned char s42 = ((e30 & 0x3) << 4) | (e31 >> 4); s42 &= 0x3F;
-			unsigned char s43 = ((e31 & 0xF) << 2); s43 &= 0x3F; // last char (index 43) is '=' in output, so ignore
-			for (size_t i = 0; i < g_patterns_count && !likely_match; ++i) {
-				struct search_pattern *sp = &g_patterns[i];
-				int ok = 1;
-				// Prefix check
-				if (sp->pre_mask_len) {
-					if (sp->pre_mask_len >= 1 && sp->pre_idx[0] != p0) ok = 0;
-					if (ok && sp->pre_mask_len >= 2 && sp->pre_idx[1] != p1) ok = 0;
-					if (ok && sp->pre_mask_len >= 3 && sp->pre_idx[2] != p2) ok = 0;
-					if (ok && sp->pre_mask_len >= 4 && sp->pre_idx[3] != p3) ok = 0;
-				}
-				// Suffix check (last indices before '='): positions 41,42,43
-				if (ok && sp->suf_mask_len) {
-					// Map suf_idx[0..n-1] to s41,s42,s43 (we stored in ascending order)
-					if (sp->suf_mask_len >= 1 && sp->suf_idx[0] != s41) ok = 0;
-					if (ok && sp->suf_mask_len >= 2 && sp->suf_idx[1] != s42) ok = 0;
-					if (ok && sp->suf_mask_len >= 3 && sp->suf_idx[2] != s43) ok = 0;
-				}
-				if (ok) { likely_match = 1; break; }
+// Batch boundary: nothing to do unless a new pattern set was published since t->ps was loaded
+static inline int pattern_set_changed(const struct keygen_thread *t) {
+	return atomic_load_explicit(&g_pset_epoch, memory_order_acquire) != t->ps_epoch;
+}
+
+// Drop the held set (announcing the epoch says so) and take the current one with its matchers.
+// Seq-cst on both sides: a publisher that saw this slot offline must not free what is loaded here.
+static void pattern_set_enter(struct keygen_thread *t) {
+	unsigned long long e = atomic_load(&g_pset_epoch);
+	atomic_store(&t->reader->epoch, e);
+	t->ps = atomic_load(&g_pset);
+	t->ps_epoch = e;
+	keygen_pipeline_matchers(t);
+}
+
+// Hold no set while parked or after exiting; the next batch enters again
+static void pattern_set_leave(struct keygen_thread *t) {
+	atomic_store(&t->reader->epoch, PSET_OFFLINE);
+	t->ps = NULL;
+	t->ps_epoch = 0;
+}
+
+// --serve: register this worker (first=1) or park it while no job is running
+static void serve_park(struct keygen_thread *t, int first) {
+	pattern_set_leave(t);
+	pthread_mutex_lock(&g_pause_lock);
+	if (first) g_serve_workers++;
+	g_parked++;
+	pthread_cond_broadcast(&g_parked_cv);
+	while (atomic_load(&g_pause_req) && !atomic_load(&g_stop.flag)) pthread_cond_wait(&g_resume_cv, &g_pause_lock);
+	g_parked--;
+	pthread_mutex_unlock(&g_pause_lock);
+}
+
+void *generate_keys(void *arg) {
+	// Optional: pin thread to a CPU for better cache locality
+	long tid = (long)(intptr_t)arg;
+#ifdef __linux__
+	if (g_affinity) {
+		int ncpu = (int)sysconf(_SC_NPROCESSORS_ONLN);
+		if (ncpu > 0) {
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			if (g_core_order && g_core_order_count==ncpu) { // P-cores first and/or one thread per core first
+				int cpu = g_core_order[(int)(tid % ncpu)];
+				CPU_SET((unsigned)cpu, &set);
+			} else {
+				CPU_SET((unsigned)(tid % ncpu), &set);
 			}
+			(void)pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
 		}
-	if (likely_match) { base64_encode_32(pub_key, b64_pub); }
+	}
+#endif
 
-		// Count this generated key regardless of match (batch to reduce contention)
-		if (++local_cnt >= 4096) {
-			atomic_fetch_add_explicit(&g_key_count, local_cnt, memory_order_relaxed);
-			local_cnt = 0;
+	struct keygen_thread *t = (struct keygen_thread *)calloc(1, sizeof *t);
+	if (!t) return NULL;
+	if (g_top_boards) t->board = &g_top_boards[tid];
+	t->reader = &g_pset_readers[tid];
+	t->stats = &g_stats[tid];
+	t->tid = (int)(g_stream_base + (unsigned)tid); // stream id; differs from tid only for --worker
+	if (g_seeded) {
+		seed_stream_init(&t->drbg, g_seed_key, (uint32_t)t->tid, 0);
+	} else {
+		unsigned char seed_key[32], seed_nonce[12];
+		if (RAND_bytes(seed_key, sizeof seed_key) != 1 || RAND_bytes(seed_nonce, sizeof seed_nonce) != 1) {
+			// Fallback: zero seed; still functional but lower entropy (unlikely path)
+			memset(seed_key, 0, sizeof seed_key);
+			memset(seed_nonce, 0, sizeof seed_nonce);
 		}
+		chacha20_init(&t->drbg, seed_key, seed_nonce, 1u);
+	}
+	t->rand_off = sizeof(t->rand_buf); // force initial refill
 
-		int matched = 0;
-		for (size_t i = 0; i < g_patterns_count; ++i) {
-			struct search_pattern *sp = &g_patterns[i];
-			if (sp->prefix_len > 0 && memcmp(b64_pub, sp->prefix, sp->prefix_len) == 0) { matched = 1; break; }
-			if (sp->suffix_len > 0 && memcmp(b64_pub + sp->suffix_off, sp->suffix, sp->suffix_len) == 0) { matched = 1; break; }
-		}
-		if (matched) {
-			// Encode private key only when we have a match
-			base64_encode_32(priv, b64_priv);
-			printf("FOUND: pub=%s priv=%s\n", b64_pub, b64_priv);
-			fprintf(stderr, "FOUND: pub=%s priv=%s\n", b64_pub, b64_priv);
-			fflush(stdout);
-			fflush(stderr);
-			unsigned long long cur = atomic_fetch_add_explicit(&g_found_count, 1ULL, memory_order_relaxed) + 1ULL;
-			if (cur >= g_found_target) {
-				atomic_store_explicit(&g_stop, 1, memory_order_relaxed);
+	struct key_match m;
+	memset(&m, 0, sizeof m);
+	if (keygen_pipeline_select(t)) {
+		if (g_resume) {
+			const struct keygen_progress *r = &g_resume[tid];
+			keygen_rand_seek(t, r->pos);
+			if (g_incremental && r->walk_active) {
+				unsigned char rnd[32];
+				seed_stream_key(g_seed_key, (uint32_t)t->tid, r->walk_idx, rnd);
+				t->walk_active = walk_start(&t->walk, rnd, r->walk_step);
+				t->walk_idx = r->walk_idx;
+			}
+		}
+		if (g_progress) {
+			t->progress = &g_progress[tid];
+			keygen_progress_publish(t, 0);
+		}
+		struct keygen_pipeline p = t->p;
+		const struct pattern_set *ps = NULL;
+		if (g_serve) serve_park(t, 1);
+		PROF_MARK();
+		while (!atomic_load_explicit(&g_stop.flag, memory_order_relaxed)) {
+			if (g_serve && atomic_load_explicit(&g_pause_req, memory_order_relaxed)) {
+				serve_park(t, 0);
+				PROF_MARK(); // parked time is nobody's
+				continue;
+			}
+			if (pattern_set_changed(t)) {
+				pattern_set_enter(t);
+				p = t->p;
+				ps = m.set = t->ps;
+			}
+			int rc = p.source(t);
+			PROF_LAP(PROF_RNG);
+			if (rc > 0 && p.derive) {
+				rc = p.derive(t);
+				PROF_LAP(PROF_LADDER); // all of it for OpenSSL; the batch backends lap inside
 			}
+			if (rc < 0) break;
+			if (rc == 0) continue;
+			if (p.emit) {
+				int n = p.emit(t);
+				PROF_LAP(PROF_SINK);
+				if (n < 0) break;
+				keygen_stats_publish(t, n);
+				PROF_LAP(PROF_OTHER);
+				continue;
+			}
+			int done = t->batch;
+			t->abort_batch = 0;
+			for (int i = 0; i < t->batch; ++i) {
+				const unsigned char *pub = t->pubs + (size_t)i * 32;
+				int hit = 0;
+				for (int j = 0; j < p.n_match && !hit; ++j) hit = p.match[j].prefilter(ps, pub) && p.match[j].verify(ps, pub, &m);
+				unsigned char sk[32];
+				if (hit) {
+					PROF_LAP(PROF_MATCH);
+					if (p.secret(t, i, sk, &m)) p.sink(&m, sk);
+					PROF_LAP(PROF_SINK);
+				} else if (p.score) {
+					// Only keys that make this thread's board pay for the secret and the Base64; only a
+					// key that goes on to the FOUND sink takes the full secret step (walk restart)
+					int sc = p.score(ps, pub);
+					if (sc > t->top_floor) {
+						PROF_LAP(PROF_MATCH);
+						if (p.peek(t, i, sk, &m)) {
+							t->top_floor = top_offer(t->board, sc, pub, sk);
+							if (g_top_stop && sc >= g_top_stop && p.secret(t, i, sk, &m)) {
+								base64_encode_32(pub, m.b64_pub);
+								m.pub = pub;
+								m.word = NULL; m.word_len = 0;
+								p.sink(&m, sk);
+							}
+						}
+						PROF_LAP(PROF_SINK);
+					}
+				}
+				if (t->abort_batch) { done = i + 1; break; }
+			}
+			PROF_LAP(PROF_MATCH);
+			// Count generated keys regardless of match
+			keygen_stats_publish(t, done);
+			if (t->progress) keygen_progress_publish(t, done);
+			PROF_LAP(PROF_OTHER);
+		}
+		pattern_set_leave(t);
+		if (g_serve) {
+			pthread_mutex_lock(&g_pause_lock);
+			g_serve_workers--;
+			pthread_cond_broadcast(&g_parked_cv);
+			pthread_mutex_unlock(&g_pause_lock);
 		}
 	}
 
-	// Cleanup reusable buffers
-	if (batch_X2) free(batch_X2);
-	if (batch_Z2) free(batch_Z2);
-	if (batch_Zinv) free(batch_Zinv);
-
-	// Flush any remaining counts
-	if (local_cnt) {
-		atomic_fetch_add_explicit(&g_key_count, local_cnt, memory_order_relaxed);
+	if (t->xbuf) {
+		if (g_derive_path) t->xbuf->len = 0; // an unfinished chunk is not written; output ends before it
+		export_put(t->xbuf);
 	}
+	free(t->pubs);
+	free(t->scratch);
+	free(t);
 	return NULL;
 }
 
+// '?' is a single-character wildcard
 static int search_has_only_b64_chars(const char *s) {
 	if (!s || !*s) return 0;
 	for (const unsigned char *p = (const unsigned char *)s; *p; ++p) {
 		unsigned char c = *p;
-		if (isalnum(c) || c == '+' || c == '/') {
+		if (isalnum(c) || c == '+' || c == '/' || c == '?') {
 			continue;
 		}
 		// '=' not allowed in search (we add it for suffix)
@@ -1423,6 +5384,53 @@ static int search_has_only_b64_chars(const char *s) {
 	return 1;
 }
 
+// Compile n Base64 chars placed at string position pos into a mask/value over the raw key
+// (word layout as memcpy'd from the 32 bytes); '?' contributes no bits and, under --ignore-case,
+// letters go to cf instead. Returns 0 when no 32-byte key can encode to them: past position 42,
+// or a char at 42 whose low 2 bits would fall in the zero padding before '='.
+static int pattern_bits(const char *str, size_t n, size_t pos, uint64_t mask[4], uint64_t val[4], struct case_fold *cf) {
+	unsigned char m[32] = {0}, v[32] = {0};
+	for (size_t i = 0; i < n; ++i) {
+		if (str[i] == '?') continue;
+		if (g_ignore_case && isalpha((unsigned char)str[i])) {
+			if (pos + i >= BASE64_LEN - 1) return 0;
+			cf->pos[cf->n] = (unsigned char)(pos + i);
+			cf->upper[cf->n++] = (unsigned char)(toupper((unsigned char)str[i]) - 'A');
+			continue;
+		}
+		unsigned char c = b64_index((unsigned char)str[i]);
+		if (c == 0xFFu) return 0;
+		for (unsigned j = 0; j < 6; ++j) {
+			size_t bit = (pos + i) * 6 + j; // big-endian bit index into the key
+			unsigned char b = (c >> (5 - j)) & 1;
+			if (bit >= 256) { if (b) return 0; continue; }
+			m[bit >> 3] |= (unsigned char)(0x80u >> (bit & 7));
+			v[bit >> 3] |= (unsigned char)((unsigned)b << (7 - (bit & 7)));
+		}
+	}
+	memcpy(mask, m, 32);
+	memcpy(val, v, 32);
+	return 1;
+}
+
+// --top scoring layout for up to SCORE_MAX_CHARS chars of one side: prefix char i at bits
+// 63-6i..58-6i (top of be[0]), suffix char d places before '=' at bits 6d+5..6d (bottom of
+// be[3] << 2). '?' and letters folded by --ignore-case get no mask bits.
+static unsigned char pattern_score_bits(const char *str, size_t n, int suffix, uint64_t *val, uint64_t *mask) {
+	if (n > SCORE_MAX_CHARS) n = SCORE_MAX_CHARS;
+	uint64_t v = 0, m = 0;
+	for (size_t i = 0; i < n; ++i) {
+		unsigned char ch = (unsigned char)(suffix ? str[-1 - (ptrdiff_t)i] : str[i]);
+		if (ch == '?' || (g_ignore_case && isalpha(ch))) continue;
+		unsigned shift = suffix ? (unsigned)(6 * i) : (unsigned)(58 - 6 * i);
+		v |= (uint64_t)b64_index(ch) << shift;
+		m |= (uint64_t)0x3F << shift;
+	}
+	*val = v;
+	*mask = m;
+	return (unsigned char)n;
+}
+
 static int add_pattern(const char *prefix_opt, const char *suffix_opt) {
 	if (!prefix_opt && !suffix_opt) return -1;
 	if (g_patterns_count == g_patterns_cap) {
@@ -1434,6 +5442,8 @@ static int add_pattern(const char *prefix_opt, const char *suffix_opt) {
 	}
 	struct search_pattern *p = &g_patterns[g_patterns_count];
 	memset(p, 0, sizeof(*p));
+	p->job = g_pattern_job;
+	p->job_id = g_pattern_job_id;
 	if (prefix_opt) {
 		p->prefix = strdup(prefix_opt);
 		if (!p->prefix) return -1;
@@ -1441,10 +5451,15 @@ static int add_pattern(const char *prefix_opt, const char *suffix_opt) {
 		// Precompute prefilter indices for up to first 4 Base64 chars
 		size_t pm = p->prefix_len < 4 ? p->prefix_len : 4;
 		p->pre_mask_len = (unsigned char)pm;
+		unsigned fold = 0;
 		for (size_t i = 0; i < pm; ++i) {
-			unsigned char idx = b64_index((unsigned char)p->prefix[i]);
+			unsigned char idx = pattern_char_index(p->prefix[i], &fold, 1u << i);
 			p->pre_idx[i] = idx;
 		}
+		p->pre_fold = (unsigned char)fold;
+		p->pre_bits = (unsigned char)(p->prefix_len <= BASE64_LEN - 1 &&
+			pattern_bits(p->prefix, p->prefix_len, 0, p->pre_bmask, p->pre_bval, &p->pre_cf));
+		p->sc_pre_len = pattern_score_bits(p->prefix, p->prefix_len, 0, &p->sc_pre_val, &p->sc_pre_mask);
 	}
 	if (suffix_opt) {
 		p->suffix = strdup(suffix_opt);
@@ -1456,63 +5471,548 @@ static int add_pattern(const char *prefix_opt, const char *suffix_opt) {
 			size_t core_len = p->suffix_len - 1; // ignore final '='
 			if (core_len > 3) core_len = 3;
 			p->suf_mask_len = (unsigned char)core_len;
+			unsigned fold = 0;
 			for (size_t i = 0; i < core_len; ++i) {
-				unsigned char c = (unsigned char)p->suffix[(size_t)(p->suffix_len - 2 - i)];
-				p->suf_idx[core_len - 1 - i] = b64_index(c);
+				char c = p->suffix[(size_t)(p->suffix_len - 2 - i)];
+				p->suf_idx[core_len - 1 - i] = pattern_char_index(c, &fold, 1u << (core_len - 1 - i));
 			}
+			p->suf_fold = (unsigned char)fold;
+		}
+		// The trailing '=' always matches; the chars before it end at position BASE64_LEN - 2
+		p->suf_bits = (unsigned char)(p->suffix_len >= 1 && p->suffix_len <= BASE64_LEN &&
+			pattern_bits(p->suffix, p->suffix_len - 1, BASE64_LEN - p->suffix_len, p->suf_bmask, p->suf_bval, &p->suf_cf));
+		if (p->suffix_len >= 2)
+			p->sc_suf_len = pattern_score_bits(p->suffix + p->suffix_len - 1, p->suffix_len - 1, 1, &p->sc_suf_val, &p->sc_suf_mask);
+	}
+	if ((prefix_opt && strchr(prefix_opt, '?')) || (suffix_opt && strchr(suffix_opt, '?')) || g_ignore_case) g_patterns_cpu_only = 1;
+	g_patterns_count++;
+	return 0;
+}
+
+// --contains STR: STR (with optional '?') anywhere in the 43 chars before '='
+static int add_infix_pattern(const char *s) {
+	size_t n = strlen(s);
+	if (n == 0 || n > INFIX_MAX_LEN) return -1;
+	if (g_patterns_count == g_patterns_cap) {
+		size_t new_cap = g_patterns_cap ? g_patterns_cap * 2 : 4;
+		void *np = realloc(g_patterns, new_cap * sizeof(*g_patterns));
+		if (!np) return -1;
+		g_patterns = (struct search_pattern *)np;
+		g_patterns_cap = new_cap;
+	}
+	struct search_pattern *p = &g_patterns[g_patterns_count];
+	memset(p, 0, sizeof(*p));
+	p->job = g_pattern_job;
+	p->job_id = g_pattern_job_id;
+	p->infix = strdup(s);
+	if (!p->infix) return -1;
+	p->infix_len = n;
+	for (size_t i = 0; i < n; ++i) {
+		if (s[i] == '?') continue;
+		if (g_ignore_case && isalpha((unsigned char)s[i])) {
+			p->inf_cf.pos[p->inf_cf.n] = (unsigned char)i;
+			p->inf_cf.upper[p->inf_cf.n++] = (unsigned char)(toupper((unsigned char)s[i]) - 'A');
+			continue;
+		}
+		unsigned shift = 58u - 6u * (unsigned)i;
+		p->inf_val |= (uint64_t)b64_index((unsigned char)s[i]) << shift;
+		p->inf_mask |= (uint64_t)0x3F << shift;
+	}
+	g_patterns_cpu_only = 1;
+	g_infix_count++;
+	g_patterns_count++;
+	return 0;
+}
+
+static int add_search_string(const char *s) {
+	if (!s) return -1;
+	size_t slen = strlen(s);
+	int rc = 0;
+	if (!g_better) {
+		// Base pattern: prefix=s, suffix=s"="
+		char *suf = (char *)malloc(slen + 2);
+		if (!suf) return -1;
+		memcpy(suf, s, slen);
+		suf[slen] = '=';
+		suf[slen + 1] = '\0';
+		rc = add_pattern(s, suf);
+		free(suf);
+		if (rc != 0) return rc;
+	} else {
+		// Only add visually-better variants
+		// Prefix variants: s+"/" and s"+"
+		char *pre1 = (char *)malloc(slen + 2);
+		char *pre2 = (char *)malloc(slen + 2);
+		if (!pre1 || !pre2) { free(pre1); free(pre2); return -1; }
+		memcpy(pre1, s, slen); pre1[slen] = '/'; pre1[slen + 1] = '\0';
+		memcpy(pre2, s, slen); pre2[slen] = '+'; pre2[slen + 1] = '\0';
+		rc = add_pattern(pre1, NULL); if (rc == 0) rc = add_pattern(pre2, NULL);
+		free(pre1); free(pre2);
+		if (rc != 0) return rc;
+
+		// Suffix variants: "/"+s+"=" and "+"+s+"="
+		char *suf1 = (char *)malloc(slen + 2 + 1);
+		char *suf2 = (char *)malloc(slen + 2 + 1);
+		if (!suf1 || !suf2) { free(suf1); free(suf2); return -1; }
+		suf1[0] = '/'; memcpy(suf1 + 1, s, slen); suf1[1 + slen] = '='; suf1[1 + slen + 1] = '\0';
+		suf2[0] = '+'; memcpy(suf2 + 1, s, slen); suf2[1 + slen] = '='; suf2[1 + slen + 1] = '\0';
+		rc = add_pattern(NULL, suf1); if (rc == 0) rc = add_pattern(NULL, suf2);
+		free(suf1); free(suf2);
+		if (rc != 0) return rc;
+	}
+	return 0;
+}
+
+#ifdef ME_KEYGEN_BENCH
+// --- Microbenchmarks (make bench) ---
+// meshtastic_keygen_bench times the building blocks one at a time on one thread: fem/fesq and
+// feinvert on every fe backend the CPU runs, the fe51 field, batch inversion at several N, the
+// ladders and batched paths, fetobytes/base64_encode_32, and the prefilter and verify_bits against
+// 1 to 10000 patterns. Each case is calibrated to --ms / --reps per repetition and reported as the
+// mean ns/op with its standard deviation; --json writes the results and --baseline compares them
+// against such a file.
+#define BENCH_MAX_CASES 96
+#define BENCH_KEYS 4096 // random secrets / public keys cycled through by the per-key cases
+
+struct bench_result {
+	char name[40];
+	double ns, sd, best;
+	int reps;
+};
+
+static struct {
+	double ms;        // time budget per case
+	int reps;
+	const char *filter;
+	struct bench_result res[BENCH_MAX_CASES];
+	int n;
+	char *base_name[BENCH_MAX_CASES]; // --baseline entries
+	double base_ns[BENCH_MAX_CASES];
+	int n_base;
+	double tolerance; // percent
+	int regressions;
+} g_bench = { .ms = 300.0, .reps = 7, .tolerance = 10.0 };
+
+// State shared by the case bodies; run() gets it whole and uses the fields it needs
+struct bench_ctx {
+	fe_mul_fn mul;
+	fe_sq_fn sq;
+	fe a, b;
+	fe51 a51, b51;
+	int n;                   // batch size
+	fe *z, *zi;              // n each
+	fe51 *z51, *zi51, *x51;  // n each
+	void *simd;              // 3 * n SIMD scratch vectors (fe_soa4 / fe_soa8)
+	unsigned char *sks;      // BENCH_KEYS clamped secrets
+	unsigned char *keys;     // BENCH_KEYS random public keys
+	unsigned char *pubs;     // n output keys
+	const struct pattern_set *ps;
+};
+static volatile unsigned g_bench_sink; // keeps results live
+
+static double bench_now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void bench_fem(struct bench_ctx *c, long it) {
+	for (long i = 0; i < it; ++i) c->mul(&c->a, &c->a, &c->b);
+	g_bench_sink += (unsigned)c->a.v[0];
+}
+static void bench_fesq(struct bench_ctx *c, long it) {
+	for (long i = 0; i < it; ++i) c->sq(&c->a, &c->a);
+	g_bench_sink += (unsigned)c->a.v[0];
+}
+static void bench_feinvert(struct bench_ctx *c, long it) {
+	for (long i = 0; i < it; ++i) feinvert(&c->a, &c->a);
+	g_bench_sink += (unsigned)c->a.v[0];
+}
+static void bench_ladder(struct bench_ctx *c, long it) {
+	fe x, z;
+	for (long i = 0; i < it; ++i) {
+		ladder_get_x2z2(c->sks + (size_t)(i & (BENCH_KEYS - 1)) * 32, &x, &z);
+		g_bench_sink += (unsigned)x.v[0];
+	}
+}
+static void bench_fe_batch_invert(struct bench_ctx *c, long it) {
+	for (long i = 0; i < it; ++i) fe_batch_invert(c->zi, c->z, c->n);
+	g_bench_sink += (unsigned)c->zi[0].v[0];
+}
+static void bench_fetobytes(struct bench_ctx *c, long it) {
+	unsigned char s[32] = {0};
+	for (long i = 0; i < it; ++i) { fetobytes(s, &c->a); c->a.v[0] ^= s[0] & 1; }
+	g_bench_sink += s[1];
+}
+static void bench_fe51_mul(struct bench_ctx *c, long it) {
+	for (long i = 0; i < it; ++i) fe51_mul(&c->a51, &c->a51, &c->b51);
+	g_bench_sink += (unsigned)c->a51.v[0];
+}
+static void bench_fe51_sq(struct bench_ctx *c, long it) {
+	for (long i = 0; i < it; ++i) fe51_sq(&c->a51, &c->a51);
+	g_bench_sink += (unsigned)c->a51.v[0];
+}
+static void bench_fe51_invert(struct bench_ctx *c, long it) {
+	for (long i = 0; i < it; ++i) fe51_invert(&c->a51, &c->a51);
+	g_bench_sink += (unsigned)c->a51.v[0];
+}
+static void bench_fe51_batch_invert(struct bench_ctx *c, long it) {
+	for (long i = 0; i < it; ++i) fe51_batch_invert(c->zi51, c->z51, c->n);
+	g_bench_sink += (unsigned)c->zi51[0].v[0];
+}
+static void bench_fe51_tobytes(struct bench_ctx *c, long it) {
+	unsigned char s[32] = {0};
+	for (long i = 0; i < it; ++i) { fe51_tobytes(s, &c->a51); c->a51.v[0] ^= s[0] & 1; }
+	g_bench_sink += s[1];
+}
+static void bench_fe51_x2z2(struct bench_ctx *c, long it) {
+	fe51 x, z;
+	for (long i = 0; i < it; ++i) {
+		g_fe51_x2z2(c->sks + (size_t)(i & (BENCH_KEYS - 1)) * 32, &x, &z);
+		g_bench_sink += (unsigned)x.v[0];
+	}
+}
+static void bench_batch_fe51(struct bench_ctx *c, long it) {
+	for (long i = 0; i < it; ++i) x25519_base_batch_fe51(c->sks, c->n, c->pubs, c->x51, c->z51, c->zi51);
+	g_bench_sink += c->pubs[0];
+}
+#if defined(__x86_64__) || defined(__i386__)
+static void bench_batch_avx2(struct bench_ctx *c, long it) {
+	int n4 = c->n / 4;
+	fe_soa4 *X = (fe_soa4 *)c->simd;
+	for (long i = 0; i < it; ++i) x25519_base_batch_avx2(c->sks, n4, c->pubs, X, X + n4, X + 2 * n4);
+	g_bench_sink += c->pubs[0];
+}
+static void bench_batch_ifma(struct bench_ctx *c, long it) {
+	int n8 = c->n / 8;
+	fe_soa8 *X = (fe_soa8 *)c->simd;
+	for (long i = 0; i < it; ++i) x25519_base_batch_ifma(c->sks, n8, c->pubs, X, X + n8, X + 2 * n8);
+	g_bench_sink += c->pubs[0];
+}
+#endif
+static void bench_base64(struct bench_ctx *c, long it) {
+	char out[45];
+	for (long i = 0; i < it; ++i) {
+		base64_encode_32(c->keys + (size_t)(i & (BENCH_KEYS - 1)) * 32, out);
+		g_bench_sink += (unsigned char)out[7];
+	}
+}
+static void bench_prefilter_bitmap(struct bench_ctx *c, long it) {
+	unsigned hits = 0;
+	for (long i = 0; i < it; ++i) hits += (unsigned)prefilter_bitmap(c->ps, c->keys + (size_t)(i & (BENCH_KEYS - 1)) * 32);
+	g_bench_sink += hits;
+}
+static void bench_prefilter_linear(struct bench_ctx *c, long it) {
+	unsigned hits = 0;
+	for (long i = 0; i < it; ++i) hits += (unsigned)prefilter_linear(c->ps, c->keys + (size_t)(i & (BENCH_KEYS - 1)) * 32);
+	g_bench_sink += hits;
+}
+static void bench_verify_bits(struct bench_ctx *c, long it) {
+	struct key_match m;
+	unsigned hits = 0;
+	for (long i = 0; i < it; ++i) hits += (unsigned)verify_bits(c->ps, c->keys + (size_t)(i & (BENCH_KEYS - 1)) * 32, &m);
+	g_bench_sink += hits;
+}
+
+// Baseline ns/op for name; 0 when the baseline has no such case
+static double bench_base_ns(const char *name) {
+	for (int i = 0; i < g_bench.n_base; ++i)
+		if (strcmp(g_bench.base_name[i], name) == 0) return g_bench.base_ns[i];
+	return 0;
+}
+
+// Square root by Newton steps (the binary does not link libm)
+static double bench_sqrt(double x) {
+	if (x <= 0) return 0;
+	double r = x > 1 ? x : 1;
+	for (int i = 0; i < 200; ++i) {
+		double n = 0.5 * (r + x / r);
+		if (n >= r) break;
+		r = n;
+	}
+	return r;
+}
+
+// Time one case: grow the iteration count until a repetition fills its share of --ms, then take
+// --reps repetitions of ops_per_it * iters ops each. Prints one table row.
+static void bench_run(const char *name, void (*fn)(struct bench_ctx *, long), struct bench_ctx *c, long ops_per_it) {
+	if (g_bench.filter && !strstr(name, g_bench.filter)) return;
+	if (g_bench.n == BENCH_MAX_CASES) return;
+	double target = g_bench.ms * 1e6 / g_bench.reps, t = 0;
+	long it = 1;
+	for (;;) {
+		double t0 = bench_now_ns();
+		fn(c, it);
+		t = bench_now_ns() - t0;
+		if (t >= target / 4 || it >= (1L << 40)) break;
+		it *= (t > 0 && target / 4 / t < 16) ? 2 : 16;
+	}
+	if (t < target) it = (long)((double)it * target / (t > 1 ? t : 1)) + 1;
+	struct bench_result *r = &g_bench.res[g_bench.n++];
+	snprintf(r->name, sizeof r->name, "%s", name);
+	double sum = 0, sum2 = 0;
+	r->best = 0;
+	for (int k = 0; k < g_bench.reps; ++k) {
+		double t0 = bench_now_ns();
+		fn(c, it);
+		double ns = (bench_now_ns() - t0) / ((double)it * (double)ops_per_it);
+		sum += ns; sum2 += ns * ns;
+		if (k == 0 || ns < r->best) r->best = ns;
+	}
+	r->reps = g_bench.reps;
+	r->ns = sum / r->reps;
+	double var = r->reps > 1 ? (sum2 - sum * sum / r->reps) / (r->reps - 1) : 0;
+	r->sd = bench_sqrt(var);
+	printf("%-28s %12.2f %9.2f %6.1f%% %14.0f", r->name, r->ns, r->sd, r->ns > 0 ? 100.0 * r->sd / r->ns : 0.0, r->ns > 0 ? 1e9 / r->ns : 0.0);
+	double base = bench_base_ns(r->name);
+	if (base > 0) {
+		double d = 100.0 * (r->ns - base) / base;
+		printf(" %+8.1f%%%s", d, d > g_bench.tolerance ? "  REGRESSION" : "");
+		if (d > g_bench.tolerance) g_bench.regressions++;
+	}
+	printf("\n");
+	fflush(stdout);
+}
+
+// --baseline FILE: a previous --json output; one result object per line is all this reads
+static int bench_load_baseline(const char *path) {
+	FILE *f = fopen(path, "r");
+	if (!f) { fprintf(stderr, "Cannot open baseline %s: %s\n", path, strerror(errno)); return 0; }
+	char line[512];
+	while (fgets(line, sizeof line, f) && g_bench.n_base < BENCH_MAX_CASES) {
+		char *p = strstr(line, "\"name\": \""), *q = strstr(line, "\"ns_per_op\": ");
+		if (!p || !q) continue;
+		p += 9;
+		char *e = strchr(p, '"');
+		if (!e) continue;
+		*e = '\0';
+		g_bench.base_name[g_bench.n_base] = strdup(p);
+		if (!g_bench.base_name[g_bench.n_base]) break;
+		g_bench.base_ns[g_bench.n_base++] = strtod(q + 13, NULL);
+	}
+	fclose(f);
+	if (!g_bench.n_base) { fprintf(stderr, "No results in baseline %s\n", path); return 0; }
+	return 1;
+}
+
+static int bench_write_json(const char *path) {
+	FILE *f = fopen(path, "w");
+	if (!f) { fprintf(stderr, "Cannot write %s: %s\n", path, strerror(errno)); return 0; }
+	fprintf(f, "{\"ms\": %.0f, \"reps\": %d, \"cpu\": {\"adx\": %d, \"bmi2\": %d, \"avx2\": %d, \"avx512f\": %d, \"avx512ifma\": %d},\n",
+		g_bench.ms, g_bench.reps, g_has_adx, g_has_bmi2, g_has_avx2, g_has_avx512f, g_has_avx512ifma);
+	fprintf(f, " \"results\": [\n");
+	for (int i = 0; i < g_bench.n; ++i) {
+		const struct bench_result *r = &g_bench.res[i];
+		fprintf(f, "  {\"name\": \"%s\", \"ns_per_op\": %.4f, \"stddev_ns\": %.4f, \"best_ns\": %.4f, \"ops_per_sec\": %.1f, \"reps\": %d}%s\n",
+			r->name, r->ns, r->sd, r->best, r->ns > 0 ? 1e9 / r->ns : 0.0, r->reps, i + 1 < g_bench.n ? "," : "");
+	}
+	fprintf(f, " ]}\n");
+	if (fclose(f) != 0) { fprintf(stderr, "Cannot write %s: %s\n", path, strerror(errno)); return 0; }
+	return 1;
+}
+
+// Random prefix (5 chars) and suffix (4 chars + '=') patterns, half each, compiled into one set
+static struct pattern_set *bench_pattern_set(int n) {
+	static const char B64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	unsigned char r[5];
+	char s[6];
+	patterns_clear();
+	for (int i = 0; i < n; ++i) {
+		if (RAND_bytes(r, sizeof r) != 1) return NULL;
+		for (int k = 0; k < 5; ++k) s[k] = B64[r[k] & 63];
+		s[5] = '\0';
+		int rc;
+		if (i & 1) {
+			s[3] = B64[r[3] & 60]; s[4] = '='; // the last char before '=' carries 4 bits
+			rc = add_pattern(NULL, s);
+		} else rc = add_pattern(s, NULL);
+		if (rc != 0) return NULL;
+	}
+	int no_bitmap = 0;
+	struct pattern_set *ps = pattern_set_build(&no_bitmap);
+	if (ps && no_bitmap) { pattern_set_free(ps); return NULL; }
+	return ps;
+}
+
+static void bench_usage(const char *prog) {
+	fprintf(stderr, "Usage: %s [--ms N] [--reps N] [--filter STR] [--json FILE] [--baseline FILE [--tolerance PCT]]\n", prog);
+	fprintf(stderr, "  --ms N: time per case in milliseconds (default 300).\n");
+	fprintf(stderr, "  --reps N: repetitions per case; the stddev is taken across them (default 7).\n");
+	fprintf(stderr, "  --filter STR: only run cases whose name contains STR.\n");
+	fprintf(stderr, "  --json FILE: write the results as JSON.\n");
+	fprintf(stderr, "  --baseline FILE: compare against an earlier --json file; exit 3 when a case is slower by more than --tolerance percent (default 10).\n");
+}
+
+static int bench_main(int argc, char **argv) {
+	static const struct option opts[] = {
+		{ "ms", required_argument, 0, 1 },
+		{ "reps", required_argument, 0, 2 },
+		{ "filter", required_argument, 0, 3 },
+		{ "json", required_argument, 0, 4 },
+		{ "baseline", required_argument, 0, 5 },
+		{ "tolerance", required_argument, 0, 6 },
+		{ "help", no_argument, 0, 'h' },
+		{ 0, 0, 0, 0 }
+	};
+	const char *json = NULL, *baseline = NULL;
+	int opt;
+	while ((opt = getopt_long(argc, argv, "h", opts, NULL)) != -1) {
+		switch (opt) {
+		case 1: g_bench.ms = atof(optarg); break;
+		case 2: g_bench.reps = atoi(optarg); break;
+		case 3: g_bench.filter = optarg; break;
+		case 4: json = optarg; break;
+		case 5: baseline = optarg; break;
+		case 6: g_bench.tolerance = atof(optarg); break;
+		case 'h': bench_usage(argv[0]); return 0;
+		default: bench_usage(argv[0]); return 1;
 		}
 	}
-	g_patterns_count++;
-	return 0;
-}
+	if (optind < argc) { bench_usage(argv[0]); return 1; }
+	if (g_bench.ms <= 0 || g_bench.reps < 2 || g_bench.reps > 1000 || g_bench.tolerance < 0) { bench_usage(argv[0]); return 1; }
+	if (baseline && !bench_load_baseline(baseline)) return 1;
+
+	enum { NMAX = 1024 };
+	static const int batch_n[] = { 1, 16, 64, 256, 1024 };
+	static const int pat_n[] = { 1, 10, 100, 1000, 10000 };
+	struct bench_ctx c;
+	memset(&c, 0, sizeof c);
+	c.z = (fe *)malloc(NMAX * sizeof(fe)); c.zi = (fe *)malloc(NMAX * sizeof(fe));
+	c.z51 = (fe51 *)malloc(NMAX * sizeof(fe51)); c.zi51 = (fe51 *)malloc(NMAX * sizeof(fe51));
+	c.x51 = (fe51 *)malloc(NMAX * sizeof(fe51));
+	c.simd = aligned_alloc(64, (size_t)3 * NMAX * sizeof(fe51)); // fe_soa4 / fe_soa8: 4 / 8 lanes of fe51 size
+	c.sks = (unsigned char *)malloc(BENCH_KEYS * 32); c.keys = (unsigned char *)malloc(BENCH_KEYS * 32);
+	c.pubs = (unsigned char *)malloc(NMAX * 32);
+	if (!c.z || !c.zi || !c.z51 || !c.zi51 || !c.x51 || !c.simd || !c.sks || !c.keys || !c.pubs) {
+		fprintf(stderr, "Out of memory\n"); return 1;
+	}
+	if (RAND_bytes(c.sks, BENCH_KEYS * 32) != 1 || RAND_bytes(c.keys, BENCH_KEYS * 32) != 1) {
+		fprintf(stderr, "RAND_bytes failed\n"); return 1;
+	}
+	for (int i = 0; i < BENCH_KEYS; ++i) { unsigned char *sk = c.sks + (size_t)i * 32; sk[0] &= 248; sk[31] &= 127; sk[31] |= 64; }
+	for (int i = 0; i < NMAX; ++i) { fe_frombytes(&c.z[i], c.keys + (size_t)i * 32); fe51_frombytes(&c.z51[i], c.keys + (size_t)i * 32); }
+
+	fprintf(stderr, "Bench: %.0f ms x %d reps per case; cpu adx=%d bmi2=%d avx2=%d avx512f=%d avx512ifma=%d\n",
+		g_bench.ms, g_bench.reps, g_has_adx, g_has_bmi2, g_has_avx2, g_has_avx512f, g_has_avx512ifma);
+	printf("%-28s %12s %9s %7s %14s%s\n", "case", "ns/op", "stddev", "cv", "ops/s", g_bench.n_base ? "  vs baseline" : "");
+
+	// fe (10x25.5 limbs) on every backend the CPU runs; feinvert and the ladder go through g_fe_mul
+	struct { const char *name; fe_mul_fn mul; fe_sq_fn sq; int ok; } be[] = {
+		{ "baseline", fem_baseline, fesq_baseline, 1 },
+#if defined(__x86_64__) || defined(__i386__)
+		{ "adx", fem_adx, fesq_adx, g_has_adx && g_has_bmi2 },
+		{ "avx2", fem_avx2, fesq_avx2, g_has_avx2 },
+		{ "ifma", fem_ifma, fesq_ifma, g_has_avx512ifma },
+#endif
+	};
+	fe_mul_fn sel_mul = g_fe_mul; fe_sq_fn sel_sq = g_fe_sq;
+	char name[40];
+	for (size_t b = 0; b < sizeof be / sizeof be[0]; ++b) {
+		if (!be[b].ok) { fprintf(stderr, "Skipping the %s backend (not supported by this CPU)\n", be[b].name); continue; }
+		c.mul = be[b].mul; c.sq = be[b].sq;
+		g_fe_mul = be[b].mul; g_fe_sq = be[b].sq;
+		fe_frombytes(&c.a, c.keys); fe_frombytes(&c.b, c.keys + 32);
+		snprintf(name, sizeof name, "fem/%s", be[b].name); bench_run(name, bench_fem, &c, 1);
+		snprintf(name, sizeof name, "fesq/%s", be[b].name); bench_run(name, bench_fesq, &c, 1);
+		snprintf(name, sizeof name, "feinvert/%s", be[b].name); bench_run(name, bench_feinvert, &c, 1);
+		snprintf(name, sizeof name, "ladder/%s", be[b].name); bench_run(name, bench_ladder, &c, 1);
+	}
+	g_fe_mul = sel_mul; g_fe_sq = sel_sq;
+	for (size_t k = 0; k < sizeof batch_n / sizeof batch_n[0]; ++k) {
+		c.n = batch_n[k];
+		snprintf(name, sizeof name, "fe_batch_invert/%d", c.n); bench_run(name, bench_fe_batch_invert, &c, c.n);
+	}
+	fe_frombytes(&c.a, c.keys);
+	bench_run("fetobytes", bench_fetobytes, &c, 1);
 
-static int add_search_string(const char *s) {
-	if (!s) return -1;
-	size_t slen = strlen(s);
-	int rc = 0;
-	if (!g_better) {
-		// Base pattern: prefix=s, suffix=s"="
-		char *suf = (char *)malloc(slen + 2);
-		if (!suf) return -1;
-		memcpy(suf, s, slen);
-		suf[slen] = '=';
-		suf[slen + 1] = '\0';
-		rc = add_pattern(s, suf);
-		free(suf);
-		if (rc != 0) return rc;
-	} else {
-		// Only add visually-better variants
-		// Prefix variants: s+"/" and s"+"
-		char *pre1 = (char *)malloc(slen + 2);
-		char *pre2 = (char *)malloc(slen + 2);
-		if (!pre1 || !pre2) { free(pre1); free(pre2); return -1; }
-		memcpy(pre1, s, slen); pre1[slen] = '/'; pre1[slen + 1] = '\0';
-		memcpy(pre2, s, slen); pre2[slen] = '+'; pre2[slen + 1] = '\0';
-		rc = add_pattern(pre1, NULL); if (rc == 0) rc = add_pattern(pre2, NULL);
-		free(pre1); free(pre2);
-		if (rc != 0) return rc;
+	// Native 5x51 field and the batched paths the CPU search runs (per key)
+	fe51_frombytes(&c.a51, c.keys); fe51_frombytes(&c.b51, c.keys + 32);
+	bench_run("fe51_mul", bench_fe51_mul, &c, 1);
+	bench_run("fe51_sq", bench_fe51_sq, &c, 1);
+	bench_run("fe51_invert", bench_fe51_invert, &c, 1);
+	for (size_t k = 0; k < sizeof batch_n / sizeof batch_n[0]; ++k) {
+		c.n = batch_n[k];
+		snprintf(name, sizeof name, "fe51_batch_invert/%d", c.n); bench_run(name, bench_fe51_batch_invert, &c, c.n);
+	}
+	fe51_frombytes(&c.a51, c.keys);
+	bench_run("fe51_tobytes", bench_fe51_tobytes, &c, 1);
+	void (*sel_x2z2)(const unsigned char sk[32], fe51 *x2, fe51 *z2) = g_fe51_x2z2;
+	int have_fb = fixedbase_init();
+	c.n = 256;
+	g_fe51_x2z2 = ladder51_get_x2z2;
+	bench_run("ladder51", bench_fe51_x2z2, &c, 1);
+	bench_run("batch_fe51/256", bench_batch_fe51, &c, c.n);
+	if (have_fb) {
+		g_fe51_x2z2 = fixedbase_get_x2z2;
+		bench_run("fixedbase", bench_fe51_x2z2, &c, 1);
+		bench_run("batch_fixedbase/256", bench_batch_fe51, &c, c.n);
+	} else fprintf(stderr, "Skipping the fixed-base comb (table init failed)\n");
+	g_fe51_x2z2 = sel_x2z2;
+#if defined(__x86_64__) || defined(__i386__)
+	if (g_has_avx2) bench_run("batch_avx2/256", bench_batch_avx2, &c, c.n);
+	if (g_has_avx512f && g_has_avx512ifma) bench_run("batch_ifma/256", bench_batch_ifma, &c, c.n);
+#endif
+	bench_run("base64_encode_32", bench_base64, &c, 1);
 
-		// Suffix variants: "/"+s+"=" and "+"+s+"="
-		char *suf1 = (char *)malloc(slen + 2 + 1);
-		char *suf2 = (char *)malloc(slen + 2 + 1);
-		if (!suf1 || !suf2) { free(suf1); free(suf2); return -1; }
-		suf1[0] = '/'; memcpy(suf1 + 1, s, slen); suf1[1 + slen] = '='; suf1[1 + slen + 1] = '\0';
-		suf2[0] = '+'; memcpy(suf2 + 1, s, slen); suf2[1 + slen] = '='; suf2[1 + slen + 1] = '\0';
-		rc = add_pattern(NULL, suf1); if (rc == 0) rc = add_pattern(NULL, suf2);
-		free(suf1); free(suf2);
-		if (rc != 0) return rc;
+	// Matching on random public keys: the two prefilters and the exact check of a candidate
+	for (size_t k = 0; k < sizeof pat_n / sizeof pat_n[0]; ++k) {
+		struct pattern_set *ps = bench_pattern_set(pat_n[k]);
+		if (!ps) { fprintf(stderr, "Cannot build a set of %d patterns\n", pat_n[k]); continue; }
+		c.ps = ps;
+		snprintf(name, sizeof name, "prefilter_bitmap/%d", pat_n[k]); bench_run(name, bench_prefilter_bitmap, &c, 1);
+		snprintf(name, sizeof name, "prefilter_linear/%d", pat_n[k]); bench_run(name, bench_prefilter_linear, &c, 1);
+		snprintf(name, sizeof name, "verify_bits/%d", pat_n[k]); bench_run(name, bench_verify_bits, &c, 1);
+		pattern_set_free(ps);
 	}
-	return 0;
+	patterns_clear();
+
+	int rc = 0;
+	if (json && !bench_write_json(json)) rc = 1;
+	if (!rc && g_bench.regressions) {
+		fprintf(stderr, "%d case(s) slower than the baseline by more than %.1f%%\n", g_bench.regressions, g_bench.tolerance);
+		rc = 3;
+	}
+	free(c.z); free(c.zi); free(c.z51); free(c.zi51); free(c.x51); free(c.simd);
+	free(c.sks); free(c.keys); free(c.pubs);
+	for (int i = 0; i < g_bench.n_base; ++i) free(g_bench.base_name[i]);
+	return rc;
 }
+#endif
 
 static void print_usage(const char *prog) {
-	fprintf(stderr, "Usage: %s [-t N|--threads N] [-s STR|--search STR]... [-c N|--count N] [--affinity] [-q|--quiet] [-b|--better] [-g|--gpu]\n", prog);
-	fprintf(stderr, "  -s STR: required (can be repeated). STR must contain only Base64 characters [A-Za-z0-9+/] (no '=').\n");
+	fprintf(stderr, "Usage: %s [-t N|--threads N] [-s STR|--search STR]... [-c N|--count N] [--affinity] [-q|--quiet] [--report-interval SEC] [--report-detail] [--json] [-b|--better] [--contains STR]... [--ignore-case] [--wordlist FILE] [--top K] [--top-stop N] [--seed S] [--regen T:I[:S]] [--checkpoint FILE] [--resume FILE] [--coordinator ADDR|--worker ADDR] [--serve ADDR|--submit ADDR [--deadline SEC]] [--pattern-file FILE] [--control ADDR] [--fleet] [--export N [--export-file FILE] [--export-base64]] [--derive FILE [--derive-base64]] [--incremental] [--cpu-autotune] [-g|--gpu]\n", prog);
+	fprintf(stderr, "  -s STR: required (can be repeated). STR must contain only Base64 characters [A-Za-z0-9+/] (no '='); '?' matches any one character.\n");
 	fprintf(stderr, "  -t N  : optional. Number of threads (default %d).\n", DEFAULT_NUM_THREADS);
 	fprintf(stderr, "  -c N  : optional. Stop after finding N matches (default 1).\n");
 	fprintf(stderr, "  -q, --quiet: optional. Disable periodic reporting.\n");
+	fprintf(stderr, "  --report-interval SEC: optional. Seconds between progress lines (default 5, fractions allowed). With several threads the line shows the min/max per-thread and per-CPU rate.\n");
+	fprintf(stderr, "  --report-detail: optional. Follow each progress line with every thread's and CPU's rate.\n");
+	fprintf(stderr, "  --json: optional. Write FOUND records to stdout as JSON lines (pub, priv, and word, seed/thread/index/step, search or contains when present); stderr keeps the FOUND text. CPU only.\n");
 	fprintf(stderr, "  --affinity: optional. Pin worker threads to CPU cores (Linux).\n");
 	fprintf(stderr, "  -b, --better: optional. Only match visually tighter variants: prefix STR/ and STR+; suffix /STR= and +STR=. (Base STR/STR= are skipped.)\n");
+	fprintf(stderr, "  --contains STR: optional (can be repeated). Match STR (up to %d chars, '?' allowed) anywhere in the key; may replace -s. CPU only.\n", INFIX_MAX_LEN);
+	fprintf(stderr, "  --ignore-case: optional. Letters in -s/--contains match either case; digits, '+' and '/' stay exact. CPU only.\n");
+	fprintf(stderr, "  --wordlist FILE: optional. One word per line (%d..%d Base64 chars, '#' comments); each matches as prefix WORD or suffix WORD=. FOUND lines add word=. CPU only.\n", WORDLIST_MIN_LEN, BASE64_LEN - 1);
+	fprintf(stderr, "  --top K: optional. Also keep the K (max %d) keys whose -s prefix/suffix matches the most chars; printed as TOP lines while running and at exit (Ctrl-C). CPU only.\n", TOP_MAX);
+	fprintf(stderr, "  --top-stop N: optional. With --top, a key matching N or more chars is reported as FOUND and counts toward -c.\n");
+	fprintf(stderr, "  --seed S: optional. Deterministic run: thread T's secrets come from a stream keyed by the 64-bit S; FOUND lines add seed= thread= index= (and step= with --incremental). All keys of the run follow from S, so they are only as secret as S (64 bits). CPU only.\n");
+	fprintf(stderr, "  --checkpoint FILE: optional. Save the search position to FILE every MEKG_CHECKPOINT_SEC seconds (default 60) and on exit. Without --seed the streams use a random 256-bit key stored in FILE (mode 0600). CPU only.\n");
+	fprintf(stderr, "  --resume FILE: optional. Continue a checkpointed run with the same search options; keeps checkpointing to FILE.\n");
+	fprintf(stderr, "  --coordinator ADDR: optional. Listen on HOST:PORT or unix:PATH and hand disjoint stream shards to --worker processes running the same search; sums their keys, prints their FOUND lines and stops them all at -c. Without --seed the streams use a random 256-bit key. The link is plain text (stream key, FOUND lines): localhost or trusted networks only.\n");
+	fprintf(stderr, "  --worker ADDR: optional. Join a coordinator and search the shard it assigns (stream key and ids) until it says stop. CPU only.\n");
+	fprintf(stderr, "  --serve ADDR: optional. Daemon on HOST:PORT or unix:PATH: a warm worker pool (-t) runs the jobs clients submit, matching each key against all of them at once. CPU only.\n");
+	fprintf(stderr, "  --submit ADDR: optional. Send -s/--contains/-c (and --deadline SEC) as one job to a --serve daemon and print its FOUND lines.\n");
+	fprintf(stderr, "  --pattern-file FILE: optional. More patterns, one \"search STR\" or \"contains STR\" per line ('#' comments); SIGHUP re-reads FILE and swaps the set without restarting the workers. CPU only.\n");
+	fprintf(stderr, "  --control ADDR: optional. Listen on HOST:PORT or unix:PATH for pattern changes while running: search STR, contains STR, drop search|contains STR, reload, list. CPU only.\n");
+	fprintf(stderr, "  --fleet: optional. One distinct key per target: each -s/--contains/pattern-file entry is retired once matched, and the run ends when all have a key. FOUND lines add search=STR or contains=STR; TARGET lines at exit give each key and the keys it took. -c is ignored. CPU only.\n");
+	fprintf(stderr, "  --export N: optional. Write N plain keypairs (no search) as 64-byte priv||pub records after a 64-byte MEKGKEYS header, through a writer thread; uses the batched internal ladder. CPU only.\n");
+	fprintf(stderr, "  --export-file FILE: with --export, write to FILE (mode 0600) instead of stdout.\n");
+	fprintf(stderr, "  --export-base64: with --export, write \"PRIV PUB\" Base64 lines after a '#' header line.\n");
+	fprintf(stderr, "  --derive FILE: optional. Read secrets (raw 32-byte, or an --export file) from FILE or '-' for stdin and write their public keys to stdout in input order, on the batched internal ladder. CPU only.\n");
+	fprintf(stderr, "  --derive-base64: with --derive, read one Base64 secret per line (first field) and write one Base64 public key per line.\n");
+	fprintf(stderr, "  --regen T:I[:S]: with --seed or --resume FILE, print the key of a FOUND record (thread T, index I, walk step S) and exit.\n");
+	fprintf(stderr, "  --incremental: optional. CPU search walks k, k+8, k+16, ... from one random start per thread (one point addition per key).\n");
+	fprintf(stderr, "  --cpu-autotune: optional. Pick the derive path, batch size and thread count (with or without SMT siblings) from short calibration rounds, cache the winner per host and CPU (MEKG_AUTOTUNE_CACHE overrides the file) and reuse it on later starts. -t and MEKG_CPU_* knobs that are set win. CPU only.\n");
 	fprintf(stderr, "  -g, --gpu: optional. Use OpenCL GPU implementation (experimental). Requires OpenCL runtime and kernel file opencl_keygen.cl.\n");
 	fprintf(stderr, "  GPU tuning flags (CLI overrides env MEKG_OCL_*):\n");
 	fprintf(stderr, "    --gpu-gsize N     : Global work size (default 16384)\n");
@@ -1528,7 +6028,297 @@ void *generate_keys(void *arg);
 
 static void handle_signal(int sig) {
 	(void)sig;
-	atomic_store(&g_stop, 1);
+	atomic_store(&g_stop.flag, 1);
+}
+
+// --pattern-file: SIGHUP asks the control thread to re-read it
+static void handle_sighup(int sig) {
+	(void)sig;
+	atomic_store(&g_reload_req, 1);
+}
+
+// --- CPU autotune (--cpu-autotune) ---
+// Short end-to-end rounds of the real worker loop (against an empty pattern set, so nothing is found)
+// pick the derive path, the batch size and the thread count: first every path at batch 256 on all
+// threads, then batch sizes for the winner, then one pinned thread per physical core against all
+// hardware threads. The winner goes to a per-host cache file, one line per CPU model, feature set,
+// CPU count and search mode, and later starts apply that line without calibrating. Knobs set
+// explicitly (-t, --resume, MEKG_CPU_FE, MEKG_CPU_INTERNAL, MEKG_EXPERIMENTAL_AVX2_MULTI,
+// MEKG_CPU_BATCH) stay as given and are left out of the rounds; only a full tune is cached.
+#define TUNE_CACHE_TAG "# meshtastic_keygen CPU autotune v1"
+struct cpu_tune {
+	char path[12]; // openssl | fe51 | fixedbase | avx2x4 | ifma8 | walk (--incremental)
+	int batch;
+	int threads;
+	int smt;       // 0: one thread per physical core, pinned
+	double rate;   // keys/s measured
+};
+static struct {
+	int fix_path, fix_batch, fix_threads;
+	int affinity;  // --affinity as given
+	int max_threads; // worker slots allocated in main
+	int primaries;   // one per physical core (core_order_primary_first), 0 unknown
+} g_tune;
+
+// "MODEL|bmi2=..|cpus=N|mode": the cache key of this host and run
+static void cpu_tune_key(char *out, size_t len) {
+	char model[64] = "unknown";
+#if defined(__x86_64__) || defined(__i386__)
+	unsigned int r[12];
+	if (__get_cpuid_max(0x80000000u, NULL) >= 0x80000004u) {
+		for (unsigned i = 0; i < 3; ++i) __get_cpuid(0x80000002u + i, &r[4 * i], &r[4 * i + 1], &r[4 * i + 2], &r[4 * i + 3]);
+		memcpy(model, r, 48); model[48] = '\0';
+	}
+#else
+	FILE *f = fopen("/proc/cpuinfo", "r");
+	if (f) {
+		char line[256];
+		while (fgets(line, sizeof line, f)) {
+			char *c = strchr(line, ':');
+			if (c && (strncmp(line, "model name", 10) == 0 || strncmp(line, "Model", 5) == 0)) { snprintf(model, sizeof model, "%s", c + 2); break; }
+		}
+		fclose(f);
+	}
+#endif
+	// Trim and keep the key on one tab-free line
+	char *m = model;
+	while (*m == ' ') ++m;
+	for (char *c = m; *c; ++c) if (*c == '\n' || *c == '\t' || *c == '|') *c = ' ';
+	size_t n = strlen(m);
+	while (n && m[n - 1] == ' ') m[--n] = '\0';
+	snprintf(out, len, "%s|bmi2=%d,adx=%d,avx2=%d,avx512f=%d,avx512ifma=%d|cpus=%ld|%s", m,
+		g_has_bmi2, g_has_adx, g_has_avx2, g_has_avx512f, g_has_avx512ifma, sysconf(_SC_NPROCESSORS_ONLN),
+		g_incremental ? "walk" : "random");
+}
+
+// MEKG_AUTOTUNE_CACHE, else $XDG_CACHE_HOME or ~/.cache + /meshtastic_keygen-cpu-HOST.tune; 0 when no place
+static int cpu_tune_cache_path(char *out, size_t len) {
+	const char *env = getenv("MEKG_AUTOTUNE_CACHE");
+	if (env && env[0]) return snprintf(out, len, "%s", env) < (int)len;
+	char host[128] = "localhost", dir[1024];
+	gethostname(host, sizeof host - 1);
+	host[sizeof host - 1] = '\0';
+	const char *xdg = getenv("XDG_CACHE_HOME"), *home = getenv("HOME");
+	if (xdg && xdg[0]) snprintf(dir, sizeof dir, "%s", xdg);
+	else if (home && home[0]) {
+		snprintf(dir, sizeof dir, "%s/.cache", home);
+		mkdir(dir, 0700); // first use
+	} else return 0;
+	return snprintf(out, len, "%s/meshtastic_keygen-cpu-%s.tune", dir, host) < (int)len;
+}
+
+static int cpu_tune_path_ok(const char *path) {
+	if (g_incremental) return strcmp(path, "walk") == 0;
+	if (strcmp(path, "openssl") == 0 || strcmp(path, "fe51") == 0) return 1;
+	if (strcmp(path, "fixedbase") == 0) return fixedbase_init();
+#if defined(__x86_64__) || defined(__i386__)
+	if (strcmp(path, "avx2x4") == 0) return g_has_avx2;
+	if (strcmp(path, "ifma8") == 0) return g_has_avx512f && g_has_avx512ifma;
+#endif
+	return 0;
+}
+
+// The line for key in the cache file; 1 and *c filled when it is present and usable here
+static int cpu_tune_load(const char *file, const char *key, struct cpu_tune *c) {
+	FILE *f = fopen(file, "r");
+	if (!f) return 0;
+	char line[512];
+	size_t klen = strlen(key);
+	int ok = 0;
+	while (!ok && fgets(line, sizeof line, f)) {
+		if (strncmp(line, key, klen) != 0 || line[klen] != '\t') continue;
+		memset(c, 0, sizeof *c);
+		ok = sscanf(line + klen + 1, "path=%11s batch=%d threads=%d smt=%d rate=%lf", c->path, &c->batch, &c->threads, &c->smt, &c->rate) == 5 &&
+			c->batch >= 1 && c->batch <= 4096 && c->threads >= 1 && c->threads <= g_tune.max_threads &&
+			(c->smt || g_tune.fix_threads || g_tune.primaries == c->threads) && cpu_tune_path_ok(c->path);
+	}
+	fclose(f);
+	return ok;
+}
+
+// Replace or add the line for key; written to FILE.tmp and renamed over FILE
+static int cpu_tune_save(const char *file, const char *key, const struct cpu_tune *c) {
+	char tmp[1032], line[512];
+	if (snprintf(tmp, sizeof tmp, "%s.tmp", file) >= (int)sizeof tmp) return 0;
+	int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fd < 0) return 0;
+	FILE *out = fdopen(fd, "w");
+	if (!out) { close(fd); unlink(tmp); return 0; }
+	fprintf(out, "%s\n", TUNE_CACHE_TAG);
+	FILE *in = fopen(file, "r");
+	size_t klen = strlen(key);
+	if (in) {
+		while (fgets(line, sizeof line, in)) {
+			if (line[0] == '#' || (strncmp(line, key, klen) == 0 && line[klen] == '\t')) continue;
+			fputs(line, out);
+		}
+		fclose(in);
+	}
+	fprintf(out, "%s\tpath=%s batch=%d threads=%d smt=%d rate=%.0f\n", key, c->path, c->batch, c->threads, c->smt, c->rate);
+	if (fclose(out) != 0 || rename(tmp, file) != 0) { unlink(tmp); return 0; }
+	return 1;
+}
+
+// Set the globals the workers read; knobs fixed on the command line or in the environment are kept
+static void cpu_tune_apply(const struct cpu_tune *c) {
+	if (!g_tune.fix_path && !g_incremental) {
+		g_use_internal = strcmp(c->path, "openssl") != 0;
+		g_use_fe51 = 1; g_use_ifma8 = 0; g_avx2_multi_lanes = 0;
+		g_fe51_x2z2 = fixedbase_init() ? fixedbase_get_x2z2 : ladder51_get_x2z2; // also the fe51 side paths
+		if (strcmp(c->path, "fe51") == 0) g_fe51_x2z2 = ladder51_get_x2z2;
+		else if (strcmp(c->path, "avx2x4") == 0) g_avx2_multi_lanes = 4;
+		else if (strcmp(c->path, "ifma8") == 0) g_use_ifma8 = 1;
+	}
+	if (!g_tune.fix_batch) g_cpu_batch = c->batch;
+	if (!g_tune.fix_threads) {
+		g_num_threads = c->threads;
+		g_affinity = g_tune.affinity || !c->smt;
+	}
+}
+
+// The current path as a cpu_tune name (for a path fixed by the environment)
+static const char *cpu_tune_current_path(void) {
+	if (g_incremental) return "walk";
+	if (!g_use_internal) return "openssl";
+	if (g_use_ifma8 && g_avx2_multi_lanes == 0) return "ifma8";
+	if (g_avx2_multi_lanes == 4) return "avx2x4";
+	return g_fe51_x2z2 == fixedbase_get_x2z2 && g_use_fe51 ? "fixedbase" : "fe51";
+}
+
+// The derive path the workers will run, for the startup banner: the cpu_tune name, except that a
+// MEKG_CPU_FE ref10 backend is named by its multiplier and the OpenSSL path by its library
+static const char *cpu_derive_path_name(void) {
+	if (!g_incremental && !g_use_internal) {
+#ifdef ME_USE_LIB25519
+		return "lib25519";
+#else
+		return "openssl";
+#endif
+	}
+	if (g_incremental || g_use_fe51 || g_avx2_multi_lanes == 4) return cpu_tune_current_path();
+#if defined(__x86_64__) || defined(__i386__)
+	if (g_fe_mul == fem_ifma) return "ifma";
+	if (g_fe_mul == fem_adx) return "adx";
+	if (g_fe_mul == fem_avx2) return "avx2";
+#endif
+	return "baseline";
+}
+
+// One calibration round: c->threads workers for a warm-up plus ms, keys/s over the measured part.
+// -1 when Ctrl-C arrived (g_stop stays set).
+static double cpu_tune_round(struct cpu_tune *c, unsigned ms) {
+	cpu_tune_apply(c);
+	pthread_t *th = (pthread_t *)malloc(sizeof(pthread_t) * (size_t)g_num_threads);
+	if (!th) return 0;
+	for (int i = 0; i < g_num_threads; ++i) {
+		atomic_store(&g_stats[i].keys, 0);
+		atomic_store(&g_stats[i].cpu, -1);
+#ifdef ME_KEYGEN_PROFILE
+		for (int j = 0; j < PROF_NSTAGES; ++j) atomic_store(&g_stats[i].prof[j], 0);
+#endif
+	}
+	for (int i = 0; i < g_num_threads; ++i) pthread_create(&th[i], NULL, generate_keys, (void*)(intptr_t)i);
+	struct timespec warm = { 0, (long)(ms / 4) * 1000000L }, run = { ms / 1000, (long)(ms % 1000) * 1000000L }, t0, t1;
+	nanosleep(&warm, NULL);
+	unsigned long long k0 = keys_total();
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	nanosleep(&run, NULL);
+	unsigned long long k1 = keys_total();
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	int interrupted = atomic_exchange(&g_stop.flag, 1);
+	for (int i = 0; i < g_num_threads; ++i) pthread_join(th[i], NULL);
+	free(th);
+	if (interrupted) return -1;
+	atomic_store(&g_stop.flag, 0);
+	double secs = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+	c->rate = secs > 0 ? (double)(k1 - k0) / secs : 0;
+	if (!g_quiet) {
+		char rate_str[32];
+		human_readable_ull((unsigned long long)c->rate, rate_str, sizeof rate_str);
+		fprintf(stderr, "CPU autotune: %-9s batch=%-4d threads=%d%s: %s keys/s\n", c->path, g_cpu_batch, g_num_threads,
+			c->smt ? "" : " (one per core)", rate_str);
+	}
+	return c->rate;
+}
+
+// Run before the workers start: apply the cached winner, or calibrate, cache and apply.
+// Returns 0, or 1 when interrupted (Ctrl-C).
+static int cpu_autotune(void) {
+	char key[256], file[1024];
+	struct cpu_tune best, c;
+	g_tune.max_threads = g_num_threads;
+	g_tune.affinity = g_affinity;
+	long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	g_tune.primaries = g_tune.fix_threads ? 0 : core_order_primary_first();
+	cpu_tune_key(key, sizeof key);
+	int have_file = cpu_tune_cache_path(file, sizeof file);
+	const char *force = getenv("MEKG_AUTOTUNE_FORCE");
+	int full = !g_tune.fix_path && !g_tune.fix_batch && !g_tune.fix_threads;
+	if (have_file && !(force && force[0] == '1') && cpu_tune_load(file, key, &best)) {
+		cpu_tune_apply(&best);
+		fprintf(stderr, "CPU autotune: cached %s batch=%d threads=%d%s (%s)\n", cpu_tune_current_path(), g_cpu_batch, g_num_threads,
+			best.smt || g_tune.fix_threads ? "" : " one per core", file);
+		return 0;
+	}
+	if (g_tune.fix_path && g_tune.fix_batch && g_tune.fix_threads) {
+		fprintf(stderr, "CPU autotune: path, batch and threads are all set explicitly; nothing to tune.\n");
+		return 0;
+	}
+	const char *env_ms = getenv("MEKG_AUTOTUNE_MS");
+	unsigned ms = env_ms && atoi(env_ms) >= 50 ? (unsigned)atoi(env_ms) : 300;
+	// The rounds see an empty set; main publishes the real one afterwards
+	int no_bitmap = 0;
+	size_t saved_count = g_patterns_count, saved_infix = g_infix_count;
+	g_patterns_count = 0; g_infix_count = 0;
+	struct pattern_set *empty = pattern_set_build(&no_bitmap);
+	g_patterns_count = saved_count; g_infix_count = saved_infix;
+	if (!empty) { fprintf(stderr, "Out of memory\n"); return 1; }
+	pattern_set_publish(empty);
+	fprintf(stderr, "CPU autotune: calibrating (%u ms rounds)...\n", ms);
+
+	memset(&best, 0, sizeof best);
+	snprintf(best.path, sizeof best.path, "%s", cpu_tune_current_path());
+	best.batch = g_tune.fix_batch ? g_cpu_batch : 256;
+	best.threads = g_num_threads;
+	best.smt = 1;
+	best.rate = -1;
+	static const char *const paths[] = { "openssl", "fe51", "fixedbase", "avx2x4", "ifma8" };
+	if (!g_tune.fix_path && !g_incremental) {
+		for (size_t i = 0; i < sizeof paths / sizeof paths[0]; ++i) {
+			if (!cpu_tune_path_ok(paths[i])) continue;
+			c = best;
+			snprintf(c.path, sizeof c.path, "%s", paths[i]);
+			if (cpu_tune_round(&c, ms) < 0) return 1;
+			if (c.rate > best.rate) best = c;
+		}
+	}
+	if (!g_tune.fix_batch && strcmp(best.path, "openssl") != 0) {
+		static const int batches[] = { 64, 256, 1024 };
+		if (best.rate < 0 && cpu_tune_round(&best, ms) < 0) return 1;
+		int measured = best.batch;
+		for (size_t i = 0; i < sizeof batches / sizeof batches[0]; ++i) {
+			if (batches[i] == measured) continue;
+			c = best; c.batch = batches[i];
+			if (cpu_tune_round(&c, ms) < 0) return 1;
+			if (c.rate > best.rate) best = c;
+		}
+	}
+	if (!g_tune.fix_threads && g_tune.primaries > 0 && g_tune.primaries < ncpu && g_tune.primaries <= g_tune.max_threads) {
+		if (best.rate < 0 && cpu_tune_round(&best, ms) < 0) return 1;
+		c = best; c.threads = g_tune.primaries; c.smt = 0;
+		if (cpu_tune_round(&c, ms) < 0) return 1;
+		if (c.rate > best.rate) best = c;
+	}
+	cpu_tune_apply(&best);
+	char rate_str[32];
+	human_readable_ull((unsigned long long)(best.rate > 0 ? best.rate : 0), rate_str, sizeof rate_str);
+	fprintf(stderr, "CPU autotune: selected %s batch=%d threads=%d%s (%s keys/s)\n", cpu_tune_current_path(), g_cpu_batch, g_num_threads,
+		best.smt ? "" : " one per core", rate_str);
+	if (full) {
+		if (have_file && cpu_tune_save(file, key, &best)) fprintf(stderr, "CPU autotune: saved to %s\n", file);
+		else fprintf(stderr, "CPU autotune: cannot write the cache file%s%s\n", have_file ? " " : "", have_file ? file : "");
+	} else fprintf(stderr, "CPU autotune: not cached (-t, --resume or MEKG_CPU_* set)\n");
+	return 0;
 }
 
 int main(int argc, char **argv) {
@@ -1553,6 +6343,9 @@ int main(int argc, char **argv) {
 	if (g_has_avx512ifma) { g_fe_mul = fem_ifma; g_fe_sq = fesq_ifma; }
 	else if (g_has_adx && g_has_bmi2) { g_fe_mul = fem_adx; g_fe_sq = fesq_adx; }
 #endif
+#ifdef ME_KEYGEN_BENCH
+	return bench_main(argc, argv);
+#endif
 
 	// Print start wall-clock timestamp
 	{
@@ -1569,6 +6362,18 @@ int main(int argc, char **argv) {
 	// Collect search strings first to apply -b consistently regardless of option order
 	char **searches = NULL;
 	size_t searches_count = 0, searches_cap = 0;
+	char **contains = NULL;
+	size_t contains_count = 0, contains_cap = 0;
+	const char *wordlist_path = NULL;
+	const char *regen = NULL;
+	const char *resume_path = NULL;
+	const char *coord_addr = NULL, *worker_addr = NULL;
+	int cpu_autotune_req = 0;
+	const char *serve_addr = NULL, *submit_addr = NULL;
+	const char *control_addr = NULL;
+	const char *export_path = NULL;
+	unsigned submit_deadline = 0;
+	unsigned long long resume_fp = 0;
 	static struct option long_opts[] = {
 		{"threads", required_argument, 0, 't'},
 		{"search",  required_argument, 0, 's'},
@@ -1583,6 +6388,33 @@ int main(int argc, char **argv) {
 		{"gpu-autotune", no_argument,    0,  5 },
 		{"gpu-budget-ms", required_argument, 0, 6 },
 		{"gpu-max-keys", required_argument, 0, 7 },
+		{"incremental", no_argument,     0,  8 },
+		{"contains", required_argument,  0,  9 },
+		{"ignore-case", no_argument,     0, 10 },
+		{"wordlist", required_argument,  0, 11 },
+		{"top",      required_argument,  0, 12 },
+		{"top-stop", required_argument,  0, 13 },
+		{"seed",     required_argument,  0, 14 },
+		{"regen",    required_argument,  0, 15 },
+		{"checkpoint", required_argument, 0, 16 },
+		{"resume",   required_argument,  0, 17 },
+		{"coordinator", required_argument, 0, 18 },
+		{"worker",   required_argument,  0, 19 },
+		{"serve",    required_argument,  0, 20 },
+		{"submit",   required_argument,  0, 21 },
+		{"deadline", required_argument,  0, 22 },
+		{"pattern-file", required_argument, 0, 23 },
+		{"control",  required_argument,  0, 24 },
+		{"fleet",    no_argument,        0, 25 },
+		{"export",   required_argument,  0, 26 },
+		{"export-file", required_argument, 0, 27 },
+		{"export-base64", no_argument,   0, 28 },
+		{"derive",   required_argument,  0, 29 },
+		{"derive-base64", no_argument,   0, 30 },
+		{"report-interval", required_argument, 0, 31 },
+		{"report-detail", no_argument,   0, 32 },
+		{"json",     no_argument,        0, 33 },
+		{"cpu-autotune", no_argument,    0, 34 },
 		{0, 0, 0, 0}
 	};
 	int opt, idx;
@@ -1594,6 +6426,7 @@ int main(int argc, char **argv) {
 				long n = strtol(optarg, NULL, 10);
 				if (n > 0 && n <= 65535) {
 					g_num_threads = (int)n;
+					g_tune.fix_threads = 1;
 				} else {
 					fprintf(stderr, "Invalid thread count: %s\n", optarg);
 					print_usage(argv[0]);
@@ -1602,7 +6435,7 @@ int main(int argc, char **argv) {
 			} break;
 			case 's':
 				if (!search_has_only_b64_chars(optarg)) {
-					fprintf(stderr, "Invalid search string: must contain only Base64 characters [A-Za-z0-9+/] and no '='.\n");
+					fprintf(stderr, "Invalid search string: must contain only Base64 characters [A-Za-z0-9+/] or '?' and no '='.\n");
 					print_usage(argv[0]);
 					return 1;
 				}
@@ -1668,39 +6501,280 @@ int main(int argc, char **argv) {
 				if (v == 0) { fprintf(stderr, "Invalid --gpu-max-keys\n"); return 1; }
 				cli_max_keys = v; g_use_gpu = 1;
 			} break;
+			case 8: // --incremental
+				g_incremental = 1;
+				break;
+			case 9: // --contains
+				if (!search_has_only_b64_chars(optarg) || strlen(optarg) > INFIX_MAX_LEN) {
+					fprintf(stderr, "Invalid --contains string: 1..%d Base64 characters [A-Za-z0-9+/] or '?'.\n", INFIX_MAX_LEN);
+					print_usage(argv[0]);
+					return 1;
+				}
+				if (contains_count == contains_cap) {
+					size_t new_cap = contains_cap ? contains_cap * 2 : 4;
+					char **tmp = (char **)realloc(contains, new_cap * sizeof(*contains));
+					if (!tmp) { fprintf(stderr, "Out of memory\n"); return 1; }
+					contains = tmp; contains_cap = new_cap;
+				}
+				contains[contains_count] = strdup(optarg);
+				if (!contains[contains_count]) { fprintf(stderr, "Out of memory\n"); return 1; }
+				contains_count++;
+				break;
+			case 10: // --ignore-case
+				g_ignore_case = 1;
+				break;
+			case 11: // --wordlist
+				wordlist_path = optarg;
+				break;
+			case 12: { // --top
+				long v = strtol(optarg, NULL, 10);
+				if (v <= 0 || v > TOP_MAX) {
+					fprintf(stderr, "Invalid --top: %s (must be 1..%d)\n", optarg, TOP_MAX);
+					return 1;
+				}
+				g_top_k = (int)v;
+			} break;
+			case 13: { // --top-stop
+				long v = strtol(optarg, NULL, 10);
+				if (v <= 0 || v > BASE64_LEN - 1) {
+					fprintf(stderr, "Invalid --top-stop: %s (must be 1..%d)\n", optarg, BASE64_LEN - 1);
+					return 1;
+				}
+				g_top_stop = (int)v;
+			} break;
+			case 14: { // --seed
+				char *end = NULL;
+				errno = 0;
+				g_seed = strtoull(optarg, &end, 0);
+				if (errno || !end || *end || end == optarg) {
+					fprintf(stderr, "Invalid --seed: %s (64-bit number, decimal or 0x hex)\n", optarg);
+					return 1;
+				}
+				seed_key_from_u64(g_seed, g_seed_key);
+				g_seeded = 1;
+			} break;
+			case 15: // --regen
+				regen = optarg;
+				break;
+			case 16: // --checkpoint
+				g_checkpoint_path = optarg;
+				break;
+			case 17: // --resume
+				resume_path = optarg;
+				break;
+			case 18: // --coordinator
+				coord_addr = optarg;
+				break;
+			case 19: // --worker
+				worker_addr = optarg;
+				break;
+			case 20: // --serve
+				serve_addr = optarg;
+				break;
+			case 21: // --submit
+				submit_addr = optarg;
+				break;
+			case 22: { // --deadline
+				long v = strtol(optarg, NULL, 10);
+				if (v <= 0 || v > 100000000L) { fprintf(stderr, "Invalid --deadline: %s (seconds > 0)\n", optarg); return 1; }
+				submit_deadline = (unsigned)v;
+			} break;
+			case 23: // --pattern-file
+				g_pattern_file = optarg;
+				break;
+			case 24: // --control
+				control_addr = optarg;
+				break;
+			case 25: // --fleet
+				g_fleet_mode = 1;
+				break;
+			case 26: { // --export
+				char *end = NULL;
+				errno = 0;
+				g_export_n = strtoull(optarg, &end, 10);
+				if (errno || !end || *end || g_export_n == 0) { fprintf(stderr, "Invalid --export: %s (key count > 0)\n", optarg); return 1; }
+			} break;
+			case 27: // --export-file
+				export_path = optarg;
+				break;
+			case 28: // --export-base64
+				g_export_b64 = 1;
+				break;
+			case 29: // --derive
+				g_derive_path = optarg;
+				break;
+			case 30: // --derive-base64
+				g_derive_b64 = 1;
+				break;
+			case 31: { // --report-interval
+				char *end = NULL;
+				double v = strtod(optarg, &end);
+				if (!end || *end || !(v >= 0.1 && v <= 86400.0)) { fprintf(stderr, "Invalid --report-interval: %s (seconds, 0.1 to 86400)\n", optarg); return 1; }
+				g_report_sec = v;
+			} break;
+			case 32: // --report-detail
+				g_report_detail = 1;
+				break;
+			case 33: // --json
+				g_json = 1;
+				break;
+			case 34: // --cpu-autotune
+				cpu_autotune_req = 1;
+				break;
 			default:
 				print_usage(argv[0]);
 				return 1;
 		}
 	}
 
+	// --submit ADDR: hand -s/--contains/-c/--deadline to a --serve daemon as one job
+	if (submit_addr) {
+		if (g_json) { fprintf(stderr, "Error: --submit prints the daemon's FOUND lines as sent; --json does not apply.\n"); return 1; }
+		if (cpu_autotune_req) { fprintf(stderr, "Error: --submit runs no local workers; --cpu-autotune does not apply.\n"); return 1; }
+		if (searches_count == 0 && contains_count == 0) {
+			fprintf(stderr, "Error: --submit needs at least one -s or --contains pattern.\n");
+			return 1;
+		}
+		return run_submit(submit_addr, searches, searches_count, contains, contains_count, submit_deadline);
+	}
+	if (serve_addr && (searches_count || contains_count || wordlist_path || g_top_k || coord_addr || worker_addr || resume_path || g_checkpoint_path || g_use_gpu)) {
+		fprintf(stderr, "Error: --serve takes its patterns from submitted jobs; it does not combine with -s, --contains, --wordlist, --top, -g, sharding or checkpoints.\n");
+		return 1;
+	}
+	g_serve = serve_addr != NULL;
+	int live = g_pattern_file || control_addr || g_fleet_mode;
+	if (live && (g_serve || coord_addr || worker_addr || resume_path || g_checkpoint_path || g_use_gpu)) {
+		fprintf(stderr, "Error: --pattern-file, --control and --fleet change the patterns of a running search; they do not combine with --serve, sharding, checkpoints or -g.\n");
+		return 1;
+	}
+	if (g_fleet_mode && wordlist_path) {
+		fprintf(stderr, "Error: --fleet targets come from -s, --contains and --pattern-file; --wordlist entries cannot be retired (list them as \"search WORD\" lines instead).\n");
+		return 1;
+	}
+	if (g_fleet_mode) g_found_target = ULLONG_MAX; // the run ends when every target has its key
+	if (g_export_n && (searches_count || contains_count || wordlist_path || g_top_k || g_serve || live || coord_addr || worker_addr ||
+			resume_path || g_checkpoint_path || g_incremental || g_use_gpu)) {
+		fprintf(stderr, "Error: --export writes plain keypairs; it does not combine with patterns, --top, --incremental (walk keys are related), --serve, sharding, checkpoints or -g.\n");
+		return 1;
+	}
+	if ((export_path || g_export_b64) && !g_export_n) {
+		fprintf(stderr, "Error: --export-file and --export-base64 need --export N.\n");
+		return 1;
+	}
+	if (g_derive_path && (g_export_n || searches_count || contains_count || wordlist_path || g_top_k || g_serve || live || coord_addr || worker_addr ||
+			resume_path || g_checkpoint_path || g_incremental || g_use_gpu || g_seeded)) {
+		fprintf(stderr, "Error: --derive only turns secrets into public keys; it does not combine with --export, patterns, --top, --incremental, --seed, --serve, sharding, checkpoints or -g.\n");
+		return 1;
+	}
+	if (g_json && (g_use_gpu || coord_addr || g_serve || g_export_n || g_derive_path)) {
+		fprintf(stderr, "Error: --json formats the FOUND records of a local CPU search; it does not apply to -g, --coordinator, --serve, --export or --derive.\n");
+		return 1;
+	}
+	if (cpu_autotune_req && (g_use_gpu || coord_addr || g_export_n || g_derive_path)) {
+		fprintf(stderr, "Error: --cpu-autotune tunes the local CPU search; it does not apply to -g, --coordinator, --export or --derive.\n");
+		return 1;
+	}
+	if (g_derive_b64 && !g_derive_path) {
+		fprintf(stderr, "Error: --derive-base64 needs --derive FILE.\n");
+		return 1;
+	}
+	if ((coord_addr || worker_addr) && (resume_path || g_checkpoint_path || (worker_addr && g_seeded) || (coord_addr && worker_addr))) {
+		fprintf(stderr, "Error: --coordinator and --worker do not combine with each other, --checkpoint or --resume; workers take the seed from the coordinator.\n");
+		return 1;
+	}
+	if (coord_addr && !g_seeded && seed_key_random() != 0) return 1;
+
+	// --resume FILE restores the stream key, thread count and counters and keeps checkpointing to
+	// FILE unless --checkpoint names another file; a plain --checkpoint run draws a random 256-bit key
+	if (resume_path) {
+		int cli_threads = g_num_threads, cli_seeded = g_seeded;
+		unsigned long long cli_seed = g_seed;
+		if (checkpoint_load(resume_path, &resume_fp) != 0) return 1;
+		if (cli_seeded && (g_seed_random || cli_seed != g_seed)) {
+			fprintf(stderr, "Error: --seed %llu does not match the checkpoint.\n", cli_seed);
+			return 1;
+		}
+		if (cli_threads != g_num_threads) fprintf(stderr, "Resume: using the checkpoint's %d threads\n", g_num_threads);
+		if (!g_checkpoint_path) g_checkpoint_path = resume_path;
+	} else if (g_checkpoint_path && !g_seeded) {
+		if (seed_key_random() != 0) return 1;
+	}
+	const char *env_ckpt = getenv("MEKG_CHECKPOINT_SEC");
+	if (env_ckpt && atoi(env_ckpt) > 0) g_checkpoint_sec = (unsigned)atoi(env_ckpt);
+
+	// --regen T:I[:S]: rebuild one key from a seeded FOUND record (--seed S or --resume FILE) and exit
+	if (regen) {
+		unsigned thread = 0;
+		unsigned long long index = 0, step = 0;
+		int n = 0, fields = sscanf(regen, "%u:%llu%n:%llu%n", &thread, &index, &n, &step, &n);
+		if (!g_seeded || fields < 2 || regen[n] != '\0') {
+			fprintf(stderr, "Error: --regen needs --seed S (or --resume FILE of a checkpointed run) and THREAD:INDEX[:STEP] from a FOUND line.\n");
+			return 1;
+		}
+		unsigned char sk[32], pub[32];
+		seed_stream_key(g_seed_key, thread, index, sk);
+		sk[0] &= 248; sk[31] &= 127; sk[31] |= 64;
+		if (fields == 3) {
+			unsigned char k0[32];
+			memcpy(k0, sk, 32);
+			scalar_add_u64(sk, k0, 8ULL * step);
+		}
+		if (!x25519_pub_openssl(pub, sk)) { fprintf(stderr, "X25519 derivation failed\n"); return 6; }
+		char b64_pub[BASE64_LEN + 1], b64_priv[BASE64_LEN + 1];
+		base64_encode_32(pub, b64_pub);
+		base64_encode_32(sk, b64_priv);
+		printf("pub=%s priv=%s\n", b64_pub, b64_priv);
+		return 0;
+	}
+
 	if (!g_quiet) {
-		fprintf(stderr, "CPU features: BMI2=%d ADX=%d AVX2=%d AVX512IFMA=%d\n", g_has_bmi2, g_has_adx, g_has_avx2, g_has_avx512ifma);
+		fprintf(stderr, "CPU features: BMI2=%d ADX=%d AVX2=%d AVX512F=%d AVX512IFMA=%d\n", g_has_bmi2, g_has_adx, g_has_avx2, g_has_avx512f, g_has_avx512ifma);
 		fflush(stderr);
 	}
 
 	#if defined(__x86_64__) || defined(__i386__)
-		if (g_has_avx512ifma) { g_fe_mul = fem_ifma; g_fe_sq = fesq_ifma; g_fe_backend_name = "ifma"; }
-		else if (g_has_adx && g_has_bmi2) { g_fe_mul = fem_adx; g_fe_sq = fesq_adx; g_fe_backend_name = "adx"; }
-		else if (g_has_avx2) { g_fe_mul = fem_avx2; g_fe_sq = fesq_avx2; g_fe_backend_name = "avx2"; }
+		if (g_has_avx512ifma) { g_fe_mul = fem_ifma; g_fe_sq = fesq_ifma; }
+		else if (g_has_adx && g_has_bmi2) { g_fe_mul = fem_adx; g_fe_sq = fesq_adx; }
+		else if (g_has_avx2) { g_fe_mul = fem_avx2; g_fe_sq = fesq_avx2; }
 	#endif
+	// The native 5x51 path beats every repacking backend above; g_fe_mul stays set for the fe diagnostics.
+	// Within fe51, the fixed-base comb replaces the ladder for basepoint multiples (~3x per key).
+	g_use_fe51 = 1;
+	if (fixedbase_init()) { g_fe51_x2z2 = fixedbase_get_x2z2; }
+#if defined(__x86_64__) || defined(__i386__)
+	// Eight lanes per madd52 beat the scalar fe51 ladder; fe51 still serves the single-key and incremental paths
+	if (g_has_avx512f && g_has_avx512ifma) { g_use_ifma8 = 1; }
+#endif
 
-	// Optional override for testing: MEKG_CPU_FE=baseline|adx|ifma|avx2
+	// Optional override for testing: MEKG_CPU_FE=ifma8|fixedbase|fe51|baseline|adx|ifma|avx2
 	const char *env_cpu_fe = getenv("MEKG_CPU_FE");
 	if (env_cpu_fe && env_cpu_fe[0]) {
+		g_use_fe51 = 0; g_use_ifma8 = 0;
+		g_fe51_x2z2 = ladder51_get_x2z2;
+		if (strcmp(env_cpu_fe, "fe51") == 0) { g_use_fe51 = 1; }
+		else if (strcmp(env_cpu_fe, "fixedbase") == 0) {
+			g_use_fe51 = 1;
+			if (fixedbase_init()) { g_fe51_x2z2 = fixedbase_get_x2z2; }
+			else fprintf(stderr, "MEKG_CPU_FE=fixedbase: table init failed; using fe51.\n");
+		}
 #if defined(__x86_64__) || defined(__i386__)
-		if (strcmp(env_cpu_fe, "ifma") == 0) { g_fe_mul = fem_ifma; g_fe_sq = fesq_ifma; g_fe_backend_name = "ifma"; }
-		else if (strcmp(env_cpu_fe, "adx") == 0) { g_fe_mul = fem_adx; g_fe_sq = fesq_adx; g_fe_backend_name = "adx"; }
-		else if (strcmp(env_cpu_fe, "avx2") == 0) { g_fe_mul = fem_avx2; g_fe_sq = fesq_avx2; g_fe_backend_name = "avx2"; }
-		else { g_fe_mul = fem_baseline; g_fe_sq = fesq_baseline; g_fe_backend_name = "baseline"; }
-#else
-		(void)env_cpu_fe; // no-op on non-x86
+		else if (strcmp(env_cpu_fe, "ifma8") == 0) {
+			g_use_fe51 = 1;
+			if (fixedbase_init()) g_fe51_x2z2 = fixedbase_get_x2z2; // fe51 side paths, as in auto-selection
+			if (g_has_avx512f && g_has_avx512ifma) { g_use_ifma8 = 1; }
+			else fprintf(stderr, "MEKG_CPU_FE=ifma8: AVX-512 IFMA not usable on this CPU/OS; using fe51.\n");
+		}
+		else if (strcmp(env_cpu_fe, "ifma") == 0) { g_fe_mul = fem_ifma; g_fe_sq = fesq_ifma; }
+		else if (strcmp(env_cpu_fe, "adx") == 0) { g_fe_mul = fem_adx; g_fe_sq = fesq_adx; }
+		else if (strcmp(env_cpu_fe, "avx2") == 0) { g_fe_mul = fem_avx2; g_fe_sq = fesq_avx2; }
 #endif
+		else { g_fe_mul = fem_baseline; g_fe_sq = fesq_baseline; }
 	}
 
-	if (!g_quiet) {
-		fprintf(stderr, "CPU FE backend: %s\n", g_fe_backend_name);
-		fflush(stderr);
+	// Incremental walk always runs on fe51; precompute x(8B) once
+	if (g_incremental) {
+		if (g_use_gpu) { fprintf(stderr, "--incremental is CPU-only; ignored with --gpu.\n"); g_incremental = 0; }
+		else walk_init_step_point();
 	}
 
 	// Optional internal CPU ladder for pubkey derivation
@@ -1723,6 +6797,15 @@ int main(int argc, char **argv) {
 		long v = strtol(env_batch, NULL, 10);
 		if (v > 1 && v <= 4096) g_cpu_batch = (int)v;
 	}
+	// --cpu-autotune leaves what the environment or the command line set alone
+	g_tune.fix_path = (env_cpu_fe && env_cpu_fe[0]) || (env_internal && env_internal[0]) || (env_multi && env_multi[0]);
+	g_tune.fix_batch = env_batch && env_batch[0];
+	if (resume_path) g_tune.fix_threads = 1;
+	// --export and --derive are all derivation: the batched internal ladder unless the environment says otherwise
+	if (g_export_n || g_derive_path) {
+		if (!env_internal || !env_internal[0]) g_use_internal = 1;
+		if (!env_batch || !env_batch[0]) g_cpu_batch = EXPORT_DEFAULT_BATCH;
+	}
 	// Optional: prefer P-cores when pinning threads
 	const char *env_pcores = getenv("MEKG_PIN_PCORES");
 	if (env_pcores && (env_pcores[0]=='1' || env_pcores[0]=='y' || env_pcores[0]=='Y' || env_pcores[0]=='t' || env_pcores[0]=='T'))
@@ -1753,33 +6836,91 @@ int main(int argc, char **argv) {
 
 	// After parsing, create search patterns from collected strings (respects -b), unless in test mode
 	if (!any_test_mode) {
-		if (searches_count == 0) {
+		if (searches_count == 0 && contains_count == 0 && !wordlist_path && !g_serve && !g_pattern_file && !control_addr && !g_export_n && !g_derive_path) {
 			fprintf(stderr, "Error: missing required --search|-s STRING option (can be specified multiple times).\n");
 			print_usage(argv[0]);
 			return 1;
 		}
-		for (size_t i = 0; i < searches_count; ++i) {
+		if (live) {
+			// Keep the option strings: later sets are compiled from them plus the file and --control
+			for (size_t i = 0; i < searches_count; ++i)
+				if (live_add(searches[i], 0, 0) != 0) { fprintf(stderr, "Out of memory\n"); return 1; }
+			for (size_t i = 0; i < contains_count; ++i)
+				if (live_add(contains[i], 1, 0) != 0) { fprintf(stderr, "Out of memory\n"); return 1; }
+			if (g_pattern_file && live_load_file(g_pattern_file) != 0) return 1;
+			if (live_fill() < 0) { fprintf(stderr, "Failed to add search string\n"); return 1; }
+			if (g_live_count == 0 && !control_addr && !wordlist_path) {
+				fprintf(stderr, "Error: %s has no patterns.\n", g_pattern_file);
+				return 1;
+			}
+			if (control_addr && (g_control_fd = net_open(control_addr, 1)) < 0) return 1;
+			if (pipe(g_live_wake) != 0) { perror("pipe"); return 1; }
+		}
+		for (size_t i = 0; i < searches_count && !live; ++i) {
 			if (add_search_string(searches[i]) != 0) { fprintf(stderr, "Failed to add search string\n"); return 1; }
 		}
+		for (size_t i = 0; i < contains_count && !live; ++i) {
+			if (add_infix_pattern(contains[i]) != 0) { fprintf(stderr, "Failed to add --contains string\n"); return 1; }
+		}
 		for (size_t i = 0; i < searches_count; ++i) free(searches[i]);
 		free(searches);
+		for (size_t i = 0; i < contains_count; ++i) free(contains[i]);
+		free(contains);
+		if (g_use_gpu && (g_patterns_cpu_only || wordlist_path || g_top_k || g_seeded || worker_addr)) {
+			fprintf(stderr, "Error: --contains, --ignore-case, --wordlist, --top, --seed, --checkpoint, --coordinator, --worker and '?' wildcards are only supported on the CPU path (drop -g).\n");
+			return 1;
+		}
+		if (g_top_stop && !g_top_k) {
+			fprintf(stderr, "Error: --top-stop needs --top K.\n");
+			return 1;
+		}
+		if (g_top_k && g_patterns_count == g_infix_count) {
+			fprintf(stderr, "Error: --top scores -s prefixes/suffixes; give at least one -s STR.\n");
+			return 1;
+		}
+		if (wordlist_path) {
+			size_t skipped = 0;
+			if (wordlist_load(wordlist_path, &skipped) != 0) return 1;
+			if (g_wordlist.n == 0) { fprintf(stderr, "Wordlist %s has no usable words\n", wordlist_path); return 1; }
+			fprintf(stderr, "Wordlist: %u words from %s", g_wordlist.n, wordlist_path);
+			if (skipped) fprintf(stderr, " (%zu skipped: need %d..%d Base64 chars)", skipped, WORDLIST_MIN_LEN, BASE64_LEN - 1);
+			fprintf(stderr, "\n");
+		}
+		if (resume_path) {
+			if (resume_fp != search_fingerprint()) {
+				fprintf(stderr, "Error: %s was written for a different search (patterns, --wordlist, --ignore-case or --incremental differ).\n", resume_path);
+				return 1;
+			}
+			unsigned long long found = atomic_load_explicit(&g_found_count, memory_order_relaxed);
+			if (g_seed_random) fprintf(stderr, "Resume: %llu keys checked, %llu found so far\n", g_resume_keys, found);
+			else fprintf(stderr, "Resume: seed=%llu, %llu keys checked, %llu found so far\n", g_seed, g_resume_keys, found);
+			if (found >= g_found_target) {
+				fprintf(stderr, "The checkpoint already has %llu matches; raise -c to continue.\n", found);
+				return 0;
+			}
+		} else if (g_checkpoint_path) {
+			if (g_seed_random) fprintf(stderr, "Checkpoint: %s every %us (random 256-bit stream key, kept in the file)\n", g_checkpoint_path, g_checkpoint_sec);
+			else fprintf(stderr, "Checkpoint: %s every %us (seed=%llu)\n", g_checkpoint_path, g_checkpoint_sec, g_seed);
+		}
 
 		// (duplicate print of search patterns removed)
 	} else {
 		// In test mode, free any collected search strings and skip building patterns
 		for (size_t i = 0; i < searches_count; ++i) free(searches[i]);
 		free(searches);
+		for (size_t i = 0; i < contains_count; ++i) free(contains[i]);
+		free(contains);
 	}
 
-	// Print search patterns (prefixes and suffixes)
-	{
+	// Print search patterns (prefixes and suffixes); a --serve daemon has none until jobs arrive
+	if (!g_serve && !g_export_n && !g_derive_path) {
 		// Count and print prefixes
 		size_t pcount = 0, scount = 0;
 		for (size_t i = 0; i < g_patterns_count; ++i) {
 			if (g_patterns[i].prefix_len > 0) pcount++;
 			if (g_patterns[i].suffix_len > 0) scount++;
 		}
-		fprintf(stderr, "Search patterns:\n");
+		fprintf(stderr, "Search patterns%s:\n", g_ignore_case ? " (ignore case)" : "");
 		fprintf(stderr, "  Prefixes (%zu): ", pcount);
 		{
 			int first = 1;
@@ -1804,8 +6945,48 @@ int main(int argc, char **argv) {
 			}
 			fprintf(stderr, "\n");
 		}
+		if (g_infix_count) {
+			fprintf(stderr, "  Infixes (%zu): ", g_infix_count);
+			int first = 1;
+			for (size_t i = 0; i < g_patterns_count; ++i) {
+				if (g_patterns[i].infix_len > 0) {
+					if (!first) fprintf(stderr, ", ");
+					fwrite(g_patterns[i].infix, 1, g_patterns[i].infix_len, stderr);
+					first = 0;
+				}
+			}
+			fprintf(stderr, "\n");
+		}
+		fflush(stderr);
+	}
+
+	// Worker reader slots, then the first compiled pattern set (empty for --serve and test modes)
+	g_pset_readers = (struct pset_reader *)aligned_alloc(64, sizeof(struct pset_reader) * (size_t)g_num_threads);
+	if (!g_pset_readers) { fprintf(stderr, "Out of memory\n"); return 1; }
+	for (int i = 0; i < g_num_threads; ++i) atomic_init(&g_pset_readers[i].epoch, PSET_OFFLINE);
+	g_pset_nreaders = g_num_threads;
+	g_stats = (struct keygen_stats *)aligned_alloc(64, sizeof(struct keygen_stats) * (size_t)g_num_threads);
+	if (!g_stats) { fprintf(stderr, "Out of memory\n"); return 1; }
+	for (int i = 0; i < g_num_threads; ++i) { atomic_init(&g_stats[i].keys, 0); atomic_init(&g_stats[i].cpu, -1); }
+#ifdef ME_KEYGEN_PROFILE
+	for (int i = 0; i < g_num_threads; ++i)
+		for (int j = 0; j < PROF_NSTAGES; ++j) atomic_init(&g_stats[i].prof[j], 0);
+	atexit(prof_summary);
+#endif
+	if (cpu_autotune_req && (!any_test_mode || bench_ms > 0) && cpu_autotune() != 0) {
+		fprintf(stderr, "CPU autotune interrupted\n");
+		return 1;
+	}
+	if (!g_quiet && !g_use_gpu) {
+		fprintf(stderr, "CPU derive path: %s\n", cpu_derive_path_name());
 		fflush(stderr);
 	}
+	if (!pattern_set_rebuild()) return 1;
+	if (live) {
+		if (g_pattern_file) signal(SIGHUP, handle_sighup);
+		if (g_pattern_file) fprintf(stderr, "Pattern file: %s (SIGHUP re-reads it)\n", g_pattern_file);
+		if (control_addr) fprintf(stderr, "Pattern control on %s\n", control_addr);
+	}
 
     // env flags already read above; proceed to optional test blocks
 
@@ -2361,11 +7542,14 @@ int main(int argc, char **argv) {
 			return 6;
 		}
 		if (!ok_a || !ok_b) return 5;
+		if (cpu_selftest_rfc() != 0) return 6;
 		fprintf(stderr, "RFC basepoint public key test passed.\n");
 		return 0;
 #else
-		fprintf(stderr, "Built without OpenCL; RFC test unavailable.\n");
-		return 2;
+		// GPU vectors need OpenCL; the CPU ladders are still checked
+		if (cpu_selftest_rfc() != 0) return 6;
+		fprintf(stderr, "RFC basepoint public key test passed (CPU only).\n");
+		return 0;
 #endif
 	} else if (bench_ms > 0 && !g_use_gpu) {
 		// CPU-only benchmark mode: run N threads for bench_ms and report keys/s
@@ -2373,13 +7557,15 @@ int main(int argc, char **argv) {
 		if (!threads) { fprintf(stderr, "Failed to allocate thread handles\n"); return 1; }
 		OPENSSL_init_crypto(0, NULL);
 		if (!g_quiet) fprintf(stderr, "Benchmark: running %u ms on %d threads...\n", bench_ms, g_num_threads);
+		if (found_writer_start() != 0) { fprintf(stderr, "Out of memory\n"); free(threads); return 1; }
 		for (int i = 0; i < g_num_threads; i++) { pthread_create(&threads[i], NULL, generate_keys, (void*)(intptr_t)i); }
 		// Sleep for duration then stop
 		struct timespec ts; ts.tv_sec = bench_ms / 1000U; ts.tv_nsec = (long)(bench_ms % 1000U) * 1000000L; nanosleep(&ts, NULL);
-		atomic_store_explicit(&g_stop, 1, memory_order_relaxed);
+		atomic_store_explicit(&g_stop.flag, 1, memory_order_relaxed);
 		for (int i = 0; i < g_num_threads; i++) { pthread_join(threads[i], NULL); }
+		found_writer_stop();
 		free(threads);
-		unsigned long long total = atomic_load_explicit(&g_key_count, memory_order_relaxed);
+		unsigned long long total = keys_total();
 		double secs = (double)bench_ms / 1000.0;
 		double rate = secs > 0.0 ? (double)total / secs : 0.0;
 		char total_str[32], rate_str[32];
@@ -2387,6 +7573,86 @@ int main(int argc, char **argv) {
 		human_readable_ull((unsigned long long)rate, rate_str, sizeof rate_str);
 		fprintf(stderr, "Benchmark done. Elapsed: %.3fs | total keys: %s | rate: %s/s\n", secs, total_str, rate_str);
 		return 0;
+	} else if (g_serve) {
+		// Daemon: workers start parked and run whenever some job is active
+		threads = (pthread_t *)malloc(sizeof(pthread_t) * (size_t)g_num_threads);
+		if (!threads) { fprintf(stderr, "Failed to allocate thread handles\n"); return 1; }
+		OPENSSL_init_crypto(0, NULL);
+		atomic_store(&g_pause_req, 1);
+		if (!g_quiet) { pthread_create(&rpt, NULL, reporter, NULL); }
+		for (int i = 0; i < g_num_threads; i++) { pthread_create(&threads[i], NULL, generate_keys, (void*)(intptr_t)i); }
+		int rc = run_serve(serve_addr);
+		atomic_store(&g_stop.flag, 1);
+		serve_resume();
+		for (int i = 0; i < g_num_threads; i++) { pthread_join(threads[i], NULL); }
+		if (!g_quiet) { pthread_join(rpt, NULL); }
+		free(threads);
+		// The wake pipe outlives run_serve: workers finishing their last batch may still poke it
+		for (int e = 0; e < 2; ++e) if (g_serve_wake[e] >= 0) close(g_serve_wake[e]);
+		if (rc != 0) return rc;
+	} else if (g_export_n) {
+		// Bulk export: workers fill buffers, one writer thread streams them out
+		if (export_path) g_export_fd = open(export_path, O_WRONLY | O_CREAT | O_TRUNC, 0600); // private keys
+		else if (!g_export_b64 && isatty(STDOUT_FILENO)) { fprintf(stderr, "Error: refusing to write binary records to a terminal; use --export-file or --export-base64.\n"); return 1; }
+		else g_export_fd = STDOUT_FILENO;
+		if (g_export_fd < 0) { fprintf(stderr, "Cannot create %s: %s\n", export_path, strerror(errno)); return 1; }
+		g_export_rec = g_export_b64 ? EXPORT_B64_LINE : 64;
+		threads = (pthread_t *)malloc(sizeof(pthread_t) * (size_t)g_num_threads);
+		if (!threads || export_pool_init(2 * g_num_threads + 2) != 0) { fprintf(stderr, "Out of memory\n"); return 1; }
+		if (export_write_header(g_export_n) != 0) { perror("Export header"); return 1; }
+		OPENSSL_init_crypto(0, NULL);
+		fprintf(stderr, "Exporting %llu keypairs (%s) to %s with %d threads...\n", g_export_n, g_export_b64 ? "Base64 lines" : "64-byte records",
+			export_path ? export_path : "stdout", g_num_threads);
+		pthread_t writer;
+		pthread_create(&writer, NULL, export_writer, NULL);
+		if (!g_quiet) { pthread_create(&rpt, NULL, reporter, NULL); }
+		for (int i = 0; i < g_num_threads; i++) { pthread_create(&threads[i], NULL, generate_keys, (void*)(intptr_t)i); }
+		for (int i = 0; i < g_num_threads; i++) { pthread_join(threads[i], NULL); }
+		atomic_store(&g_stop.flag, 1);
+		if (!g_quiet) { pthread_join(rpt, NULL); }
+		free(threads);
+		unsigned long long written = export_finish(writer);
+		if (export_path && (fsync(g_export_fd) != 0 || close(g_export_fd) != 0)) { perror("Export close"); g_export_failed = 1; }
+		export_pool_free();
+		fprintf(stderr, "Exported %llu of %llu keypairs\n", written, g_export_n);
+		if (g_export_failed || written != g_export_n) return 1;
+	} else if (g_derive_path) {
+		// Batch derivation: workers turn input chunks into public keys, the writer keeps input order
+		if (!g_derive_b64 && isatty(STDOUT_FILENO)) { fprintf(stderr, "Error: refusing to write binary public keys to a terminal; redirect stdout or use --derive-base64.\n"); return 1; }
+		if (derive_open(g_derive_path) != 0) return 1;
+		g_export_fd = STDOUT_FILENO;
+		g_export_rec = g_derive_b64 ? BASE64_LEN + 1 : 32;
+		g_export_ordered = 1;
+		threads = (pthread_t *)malloc(sizeof(pthread_t) * (size_t)g_num_threads);
+		if (!threads || export_pool_init(2 * g_num_threads + 2) != 0) { fprintf(stderr, "Out of memory\n"); return 1; }
+		OPENSSL_init_crypto(0, NULL);
+		fprintf(stderr, "Deriving public keys from %s (%s) with %d threads...\n", strcmp(g_derive_path, "-") == 0 ? "stdin" : g_derive_path,
+			g_derive_b64 ? "Base64 lines" : g_derive_in.rec == 32 ? "32-byte secrets" : "export records", g_num_threads);
+		pthread_t writer;
+		pthread_create(&writer, NULL, export_writer, NULL);
+		if (!g_quiet) { pthread_create(&rpt, NULL, reporter, NULL); }
+		for (int i = 0; i < g_num_threads; i++) { pthread_create(&threads[i], NULL, generate_keys, (void*)(intptr_t)i); }
+		for (int i = 0; i < g_num_threads; i++) { pthread_join(threads[i], NULL); }
+		atomic_store(&g_stop.flag, 1);
+		if (!g_quiet) { pthread_join(rpt, NULL); }
+		free(threads);
+		unsigned long long written = export_finish(writer);
+		export_pool_free();
+		derive_close();
+		const struct derive_input *in = &g_derive_in;
+		fprintf(stderr, "Derived %llu public keys from %llu secrets read\n", written, in->records);
+		if (in->expect != ULLONG_MAX && in->records != in->expect && in->eof && !in->error) {
+			fprintf(stderr, "Derive: export header promised %llu records, input held %llu\n", in->expect, in->records);
+			return 1;
+		}
+		if (g_export_failed || in->error || written != in->records) return 1;
+	} else if (coord_addr) {
+		// Coordinator: no local workers; the reporter shows the aggregate rate
+		if (!g_quiet) { pthread_create(&rpt, NULL, reporter, NULL); }
+		int rc = run_coordinator(coord_addr);
+		atomic_store(&g_stop.flag, 1);
+		if (!g_quiet) { pthread_join(rpt, NULL); }
+		if (rc != 0) return rc;
 	} else if (!g_use_gpu) {
 		// fall through to normal CPU keygen
 		threads = (pthread_t *)malloc(sizeof(pthread_t) * (size_t)g_num_threads);
@@ -2396,12 +7662,63 @@ int main(int argc, char **argv) {
 		}
 		// Initialize OpenSSL PRNG (modern OpenSSL auto-inits). Keep for compatibility.
 		OPENSSL_init_crypto(0, NULL);
+		if (g_top_k) {
+			g_top_boards = (struct top_board *)aligned_alloc(64, sizeof(struct top_board) * (size_t)g_num_threads);
+			if (!g_top_boards) { fprintf(stderr, "Out of memory\n"); free(threads); return 1; }
+			memset(g_top_boards, 0, sizeof(struct top_board) * (size_t)g_num_threads);
+		}
+		if (g_checkpoint_path) {
+			g_progress = (struct keygen_progress *)aligned_alloc(64, sizeof(struct keygen_progress) * (size_t)g_num_threads);
+			if (!g_progress) { fprintf(stderr, "Out of memory\n"); free(threads); return 1; }
+			memset(g_progress, 0, sizeof(struct keygen_progress) * (size_t)g_num_threads);
+		}
+		pthread_t link;
+		if (worker_addr) {
+			// The coordinator owns -c and the seed; this process runs until told to stop
+			if (worker_connect(worker_addr) != 0) { free(threads); return 1; }
+			g_found_target = ULLONG_MAX;
+			if (g_seed_random) fprintf(stderr, "Worker: random stream key, streams %u..%u\n", g_stream_base, g_stream_base + (unsigned)g_num_threads - 1);
+			else fprintf(stderr, "Worker: seed=%llu, streams %u..%u\n", g_seed, g_stream_base, g_stream_base + (unsigned)g_num_threads - 1);
+			pthread_create(&link, NULL, worker_link, NULL);
+		}
 		fprintf(stderr, "Starting key generation with %d threads...\n", g_num_threads);
-		if (!g_quiet) { pthread_create(&rpt, NULL, reporter, NULL); }
+		int rpt_started = !g_quiet || g_checkpoint_path;
+		if (rpt_started) { pthread_create(&rpt, NULL, reporter, NULL); }
+		pthread_t ctl;
+		if (live) pthread_create(&ctl, NULL, live_control, NULL);
+		if (found_writer_start() != 0) { fprintf(stderr, "Out of memory\n"); free(threads); return 1; }
 		for (int i = 0; i < g_num_threads; i++) { pthread_create(&threads[i], NULL, generate_keys, (void*)(intptr_t)i); }
 		for (int i = 0; i < g_num_threads; i++) { pthread_join(threads[i], NULL); }
-		if (!g_quiet) { pthread_join(rpt, NULL); }
+		found_writer_stop(); // FOUND lines before TARGET lines, checkpoints and the coordinator's last KEYS
+		if (rpt_started) { pthread_join(rpt, NULL); }
+		if (live) {
+			atomic_store(&g_stop.flag, 1);
+			pthread_join(ctl, NULL);
+			if (g_control_fd >= 0) close(g_control_fd);
+			if (control_addr && strncmp(control_addr, "unix:", 5) == 0) unlink(control_addr + 5);
+			close(g_live_wake[0]); close(g_live_wake[1]);
+			if (g_fleet_mode) fleet_print();
+			live_free();
+		}
 		free(threads);
+		if (worker_addr) {
+			void *sent = NULL;
+			pthread_join(link, &sent);
+			worker_finish((unsigned long long)(uintptr_t)sent);
+		}
+		if (g_progress) {
+			// Workers are joined, so this is exactly where the run stopped
+			if (checkpoint_write() == 0) fprintf(stderr, "Checkpoint written to %s\n", g_checkpoint_path);
+			free(g_progress);
+			g_progress = NULL;
+		}
+		free(g_resume);
+		g_resume = NULL;
+		if (g_top_k) {
+			top_print(1);
+			free(g_top_boards);
+			g_top_boards = NULL;
+		}
 	} else {
 #ifndef ME_KEYGEN_OPENCL
 		fprintf(stderr, "This binary was built without OpenCL support. Rebuild with OPENCL=1.\n");
@@ -2471,7 +7788,7 @@ int main(int argc, char **argv) {
 	if (!g_quiet) { pthread_create(&rpt, NULL, reporter, NULL); gpu_reporter_started = 1; }
 
 	unsigned long long total_found = 0;
-		while (!atomic_load_explicit(&g_stop, memory_order_relaxed) && total_found < g_found_target) {
+		while (!atomic_load_explicit(&g_stop.flag, memory_order_relaxed) && total_found < g_found_target) {
 			struct ocl_inputs in = {
 				.kernel_path = kernel_path,
 				.patterns = pats,
@@ -2496,7 +7813,7 @@ int main(int argc, char **argv) {
 			// Double-buffered pipeline: keep up to two in-flight chunks (async compute + copy)
 			struct ocl_async *inflight[2] = { NULL, NULL };
 			size_t inflight_idx = 0;
-			while (left > 0 && !atomic_load_explicit(&g_stop, memory_order_relaxed)) {
+			while (left > 0 && !atomic_load_explicit(&g_stop.flag, memory_order_relaxed)) {
 				unsigned long long max_wi_by_keys = max_keys / (unsigned long long)effective_iters;
 				if (max_wi_by_keys == 0ULL) max_wi_by_keys = (unsigned long long)user_lsize; // due to padding, we'll run at least local size
 				size_t lim_by_keys = (size_t)((max_wi_by_keys / (unsigned long long)user_lsize) * (unsigned long long)user_lsize);
@@ -2511,7 +7828,7 @@ int main(int argc, char **argv) {
 				int arc = ocl_run_chunk_async(&in, chunk, effective_iters, seed, &h);
 				if (arc != 0) {
 					fprintf(stderr, "GPU async chunk failed.\n");
-					if (gpu_reporter_started) { atomic_store_explicit(&g_stop, 1, memory_order_relaxed); pthread_join(rpt, NULL); }
+					if (gpu_reporter_started) { atomic_store_explicit(&g_stop.flag, 1, memory_order_relaxed); pthread_join(rpt, NULL); }
 					free(pats);
 					return 3;
 				}
@@ -2529,7 +7846,7 @@ int main(int argc, char **argv) {
 					if (ocl_async_collect(prev, &pout) != 0) {
 						fprintf(stderr, "GPU async collect failed.\n");
 						ocl_async_release(prev);
-						if (gpu_reporter_started) { atomic_store_explicit(&g_stop, 1, memory_order_relaxed); pthread_join(rpt, NULL); }
+						if (gpu_reporter_started) { atomic_store_explicit(&g_stop.flag, 1, memory_order_relaxed); pthread_join(rpt, NULL); }
 						free(pats);
 						return 3;
 					}
@@ -2556,7 +7873,7 @@ int main(int argc, char **argv) {
 					if (ocl_async_collect(inflight[k], &pout) != 0) {
 						fprintf(stderr, "GPU async collect failed.\n");
 						ocl_async_release(inflight[k]); inflight[k] = NULL;
-						if (gpu_reporter_started) { atomic_store_explicit(&g_stop, 1, memory_order_relaxed); pthread_join(rpt, NULL); }
+						if (gpu_reporter_started) { atomic_store_explicit(&g_stop.flag, 1, memory_order_relaxed); pthread_join(rpt, NULL); }
 						free(pats);
 						return 3;
 					}
@@ -2573,7 +7890,7 @@ int main(int argc, char **argv) {
 				}
 			}
 		}
-		atomic_store_explicit(&g_stop, 1, memory_order_relaxed);
+		atomic_store_explicit(&g_stop.flag, 1, memory_order_relaxed);
 		if (gpu_reporter_started) { pthread_join(rpt, NULL); }
 		free(pats);
 #endif
@@ -2583,16 +7900,22 @@ int main(int argc, char **argv) {
 		for (size_t i = 0; i < g_patterns_count; ++i) {
 			free(g_patterns[i].prefix);
 			free(g_patterns[i].suffix);
+			free(g_patterns[i].infix);
 		}
 		free(g_patterns);
 	}
+	wordlist_free();
+	// Every worker has exited (offline), so all retired sets can go
+	pattern_set_reclaim();
+	pattern_set_free(atomic_exchange(&g_pset, NULL));
+	free(g_pset_readers);
     
 	// Final summary
 	struct timespec ts_end;
 	clock_gettime(CLOCK_MONOTONIC, &ts_end);
 	double secs = (ts_end.tv_sec - ts_start.tv_sec) + (ts_end.tv_nsec - ts_start.tv_nsec) / 1e9;
 	if (secs < 0) secs = 0;
-	unsigned long long total_final = atomic_load_explicit(&g_key_count, memory_order_relaxed);
+	unsigned long long total_final = keys_total();
 	unsigned long long found_final = atomic_load_explicit(&g_found_count, memory_order_relaxed);
 	unsigned long long rate_ull = (unsigned long long)((total_final / (secs > 1e-9 ? secs : 1e-9)) + 0.5);
 	char total_str[32];